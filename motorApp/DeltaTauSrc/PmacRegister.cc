@@ -4,38 +4,88 @@
 #include <stdio.h>
 #include <iocsh.h>
 #include "epicsExport.h"
+#include "devPmacAsyn.h"
+#include "pmacDpramSim.h"
+#include "pmacSimCore.h"
 
-int PmacSetup(int addrs_type,    /* VME address type; 24 - A24 or 32 - A32. */
-             void *mbox,        /* Mailbox base address. */
-             void *addrs,       /* DPRAM Base Address */
-             unsigned vector,   /* noninterrupting(0), valid vectors(64-255) */
-             int int_level,     /* interrupt level (1-6) */
-             int scan_rate);     /* polling rate - in HZ */
+extern "C"
+{
 
+/* pmacAsynPort */
+static const iocshArg asynPortArg0 = {"card",iocshArgInt};
+static const iocshArg asynPortArg1 = {"asyn port",iocshArgString};
 
+static const iocshArg * const pmacAsynPortArgs[2] = {&asynPortArg0,&asynPortArg1};
+static const iocshFuncDef asynPortFuncDef = {"pmacAsynPort", 2, pmacAsynPortArgs};
+static void asynPortCallFunc(const iocshArgBuf *args)
+{
+    pmacAsynPort(args[0].ival, args[1].sval);
+}
 
-extern "C"
+/* pmacDpramSimConfig */
+static const iocshArg simConfigArg0 = {"card",iocshArgInt};
+static const iocshArg simConfigArg1 = {"update rate (Hz)",iocshArgDouble};
+
+static const iocshArg * const simConfigArgs[2] = {&simConfigArg0,&simConfigArg1};
+static const iocshFuncDef simConfigFuncDef = {"pmacDpramSimConfig", 2, simConfigArgs};
+static void simConfigCallFunc(const iocshArgBuf *args)
+{
+    pmacDpramSimConfig(args[0].ival, args[1].dval);
+}
+
+/* pmacDpramSimMove */
+static const iocshArg simMoveArg0 = {"card",iocshArgInt};
+static const iocshArg simMoveArg1 = {"axis",iocshArgInt};
+static const iocshArg simMoveArg2 = {"position",iocshArgDouble};
+static const iocshArg simMoveArg3 = {"velocity",iocshArgDouble};
+static const iocshArg simMoveArg4 = {"acceleration",iocshArgDouble};
+
+static const iocshArg * const simMoveArgs[5] = {&simMoveArg0,&simMoveArg1,&simMoveArg2,&simMoveArg3,&simMoveArg4};
+static const iocshFuncDef simMoveFuncDef = {"pmacDpramSimMove", 5, simMoveArgs};
+static void simMoveCallFunc(const iocshArgBuf *args)
 {
+    pmacDpramSimMove(args[0].ival, args[1].ival, args[2].dval, args[3].dval, args[4].dval);
+}
+
+/* pmacDpramReport */
+static const iocshArg dpramReportArg0 = {"card",iocshArgInt};
+static const iocshArg dpramReportArg1 = {"number of reads",iocshArgInt};
 
-/* Pmac Setup */
-static const iocshArg setupArg0 = {"addrs_type",iocshArgInt};
-static const iocshArg setupArg1 = {"*mbox",iocshArgInt};
-static const iocshArg setupArg2 = {"*addrs",iocshArgInt};
-static const iocshArg setupArg3 = {"interrupt vector",iocshArgInt};
-static const iocshArg setupArg4 = {"interrupt level",iocshArgInt};
-static const iocshArg setupArg5 = {"scan rate",iocshArgInt};
+static const iocshArg * const dpramReportArgs[2] = {&dpramReportArg0,&dpramReportArg1};
+static const iocshFuncDef dpramReportFuncDef = {"pmacDpramReport", 2, dpramReportArgs};
+static void dpramReportCallFunc(const iocshArgBuf *args)
+{
+    pmacDpramReport(args[0].ival, args[1].ival);
+}
+
+/* pmacSimConfig */
+static const iocshArg simCoreArg0 = {"TCP port",iocshArgInt};
+static const iocshArg simCoreArg1 = {"update rate (Hz)",iocshArgDouble};
+
+static const iocshArg * const simCoreArgs[2] = {&simCoreArg0,&simCoreArg1};
+static const iocshFuncDef simCoreFuncDef = {"pmacSimConfig", 2, simCoreArgs};
+static void simCoreCallFunc(const iocshArgBuf *args)
+{
+    pmacSimConfig(args[0].ival, args[1].dval);
+}
 
-static const iocshArg * const PmacSetuparg[6] = {&setupArg0,&setupArg1,&setupArg2,&setupArg3,&setupArg4,&setupArg5};
-static const iocshFuncDef setupFuncDef = {"PmacSetup", 6, PmacSetuparg};
-static void setupCallFunc(const iocshArgBuf *args)
+/* pmacSimReport */
+static const iocshFuncDef simReportFuncDef = {"pmacSimReport", 0, NULL};
+static void simReportCallFunc(const iocshArgBuf *args)
 {
-    PmacSetup(args[0].ival,args[1].vval,args[2].vval,args[3].ival,args[4].ival,args[5].ival);
+    pmacSimReport();
 }
 
 
 static void PmacSetupRegister(void)
 {
-    iocshRegister(&setupFuncDef, setupCallFunc);
+    iocshRegister(&asynPortFuncDef, asynPortCallFunc);
+    iocshRegister(&simConfigFuncDef, simConfigCallFunc);
+    iocshRegister(&simMoveFuncDef, simMoveCallFunc);
+    iocshRegister(&dpramReportFuncDef, dpramReportCallFunc);
+    iocshRegister(&simCoreFuncDef, simCoreCallFunc);
+    iocshRegister(&simReportFuncDef, simReportCallFunc);
+    pmacSimMockRegister();
 }
 
 epicsExportRegistrar(PmacSetupRegister);
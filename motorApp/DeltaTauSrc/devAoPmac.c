@@ -5,25 +5,28 @@
 ** Description:
 **    Device support for the analogue out (Ao) record, using the PMAC driver code.
 **
+**    Asynchronous; OUT is VME_IO "#C<card> S0 @<variable>", where <card> is
+**    bound to an asyn port by pmacAsynPort(). Writes are batched with the
+**    other PMAC records of the same scan cycle by devPmacAsyn.
+**
 ** Author:
 **    Joy Morris
 **
 ** $Id: devAoPmac.c,v 1.3 2005/05/18 09:19:36 mn Exp $
 **
 ** $Name:  $
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Asynchronous, batched I/O via devPmacAsyn.
 *************************************************************************/
 
 
-#include	<vxWorks.h>
 #include	<stdlib.h>
 #include	<string.h>
 #include	<stdio.h>
-#include	<wdLib.h>
-#include	<memLib.h>
 
 #include	<alarm.h>
-#include	<callback.h>
-#include	<cvtTable.h>
 #include	<dbDefs.h>
 #include	<recGbl.h>
 #include	<dbAccess.h>
@@ -32,14 +35,14 @@
 #include	<link.h>
 #include	<dbCommon.h>
 #include	<aoRecord.h>
+#include	<epicsStdio.h>
 
+#include "devPmacAsyn.h"
 #include "epicsExport.h"
 
-int send_mess(int card, char const *com, char *name);
-
 /* Create the dset for devAoPmac */
-static long init_record();
-static long write_ao();
+static long init_record(struct aoRecord *);
+static long write_ao(struct aoRecord *);
 struct {
 	long		number;
 	DEVSUPFUN	report;
@@ -53,65 +56,47 @@ struct {
 	6,
 	NULL,
 	NULL,
-	init_record,
+	(DEVSUPFUN) init_record,
 	NULL,
-	write_ao,
+	(DEVSUPFUN) write_ao,
 	NULL
 };
     
 epicsExportAddress(dset,devAoPmac);
    
-static long init_record(pao)
-    struct aoRecord	*pao;
+static long init_record(struct aoRecord *pao)
 {
-   
-char  * MyName = "init_record pao";
-
-   printf("delta tau ao: init_record\n");
+    pmacRequest *preq;
 
-   
-    switch (pao->out.type) {
-    case (VME_IO) :
-      printf("%s: card %d signal %d parm %s\n",
-	      MyName,
-	      pao->out.value.vmeio.card,
-	      pao->out.value.vmeio.signal,
-	      pao->out.value.vmeio.parm);
-	break;
-    default :
-	recGblRecordError(S_db_badField,(void *)pao,
-		"devAoPmac (init_record) Illegal OUT field");
-	return(S_db_badField);
+    preq = pmacRequestCreate((dbCommon *) pao, &pao->out, 0, 0);
+    if (preq == NULL || *preq->parm == '\0')
+    {
+        pao->pact = TRUE;       /* Disable the record. */
+        return(S_db_badField);
     }
+    pao->dpvt = preq;
     return(2);
 }
 
-static long write_ao(pao)
-    struct aoRecord	*pao;
+/* First pass queues "parm=val" and returns with PACT set; the batcher
+ * processes the record again once the command line has been sent. */
+static long write_ao(struct aoRecord *pao)
 {
-    
-    int ret;
-    char buff[256]="";
-    char * MyName = "write_ao";
+    pmacRequest *preq = (pmacRequest *) pao->dpvt;
+    char buff[PMAC_CMD_SIZE];
 
-    
-    sprintf(buff, "%s=%f",pao->out.value.vmeio.parm,pao->val);
-    printf("%s: %s \n",MyName, buff);
-    
-    switch (pao->out.type) {
-    case (VME_IO) :
-      ret = send_mess( 0, buff, NULL);
-      printf("%s: return = 0x%x\n",MyName,ret);
-      /*      recv_mess(0,buff,1);
-	      printf("recv_mess: %s\n",buff); */
-      break;
-    default :
-        if(recGblSetSevr(pao,SOFT_ALARM,INVALID_ALARM)){
-		if(pao->stat!=SOFT_ALARM) {
-			recGblRecordError(S_db_badField,(void *)pao,
-			   "devAoPmac (read_ao) Illegal OUT field");
-		}
-	}
+    if (!pao->pact)
+    {
+        epicsSnprintf(buff, sizeof(buff), "%s=%f", preq->parm, pao->val);
+        if (pmacRequestQueue(preq, buff) == 0)
+        {
+            pao->pact = TRUE;
+            return(0);
+        }
     }
+    else if (preq->status == 0)
+        return(0);
+
+    recGblSetSevr(pao, WRITE_ALARM, INVALID_ALARM);
     return(0);
 }
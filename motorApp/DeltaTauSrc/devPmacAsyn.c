@@ -0,0 +1,438 @@
+/******************************************************************************
+** Program:
+**    devPmacAsyn.c
+**
+** Description:
+**    Shared asyn command batcher for the PMAC ao/stringin/stringout device
+**    support.
+**
+**    Records queue their variable reads/writes here and return with PACT
+**    set. The first request of a scan cycle queues one asyn request on the
+**    card's port; by the time the port thread runs, every other record
+**    processed in the same cycle has been appended. The port thread packs
+**    the pending requests into one space-separated PMAC command line, e.g.
+**
+**        P100=1.500000 I130 M161 P101
+**
+**    writes it, reads the reply up to the terminating <ACK> and hands one
+**    <CR> terminated reply line to each request that expects a value, in
+**    command order. Each record is then processed again via
+**    callbackRequestProcessCallback() to complete.
+**
+**    A PMAC aborts the rest of a command line on the first error, so a
+**    <BELL> anywhere in the reply (or a reply line count mismatch) fails the
+**    whole batch. Requests whose reply format is unknown (stringout
+**    commands) are sent on a line of their own.
+**
+**    The port must have no input EOS, or an input EOS of "\006" (<ACK>);
+**    with any other terminator the batch fails with an error.
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <alarm.h>
+#include <callback.h>
+#include <dbDefs.h>
+#include <dbAccess.h>
+#include <recGbl.h>
+#include <epicsMutex.h>
+#include <epicsStdio.h>
+#include <epicsString.h>
+#include <asynDriver.h>
+#include <asynOctet.h>
+
+#include "devPmacAsyn.h"
+
+#define MAX_PMAC_CARDS  8
+#define PMAC_LINE_SIZE  256     /* Max. length of a batched command line. */
+#define PMAC_READ_SIZE  2048
+#define PMAC_TIMEOUT    1.0
+#define PMAC_ACK        '\006'
+#define PMAC_BELL       '\007'
+
+static const char *driverName = "devPmacAsyn";
+
+struct pmacCard
+{
+    int card;
+    char *port;
+    asynUser *pasynUser;
+    asynOctet *pasynOctet;
+    void *octetPvt;
+    epicsMutexId lock;
+    pmacRequest *head;          /* Pending requests, in queue order. */
+    pmacRequest *tail;
+    int queued;                 /* Batch request queued on the port. */
+};
+
+static pmacCard *pmac_cards[MAX_PMAC_CARDS];
+
+static void processBatch(asynUser *);
+static int sendBatch(pmacCard *, pmacRequest *, int);
+
+
+/*****************************************************
+ * FUNCTION... pmacAsynPort()
+ * USAGE...... Bind a PMAC card number to an asynOctet port.
+ *
+ * LOGIC...
+ *  Create an asynUser for the card's batch request.
+ *  Connect it to the port and find the asynOctet interface.
+ *  Save the card in the card table.
+ *****************************************************/
+int pmacAsynPort(int card, const char *port)
+{
+    static const char *functionName = "pmacAsynPort";
+    pmacCard *pcard;
+    asynUser *pasynUser;
+    asynInterface *pasynInterface;
+
+    if (card < 0 || card >= MAX_PMAC_CARDS || port == NULL)
+    {
+        printf("%s:%s: invalid card %d (0-%d) or port\n", driverName,
+               functionName, card, MAX_PMAC_CARDS - 1);
+        return(-1);
+    }
+    if (pmac_cards[card] != NULL)
+    {
+        printf("%s:%s: card %d already bound to port %s\n", driverName,
+               functionName, card, pmac_cards[card]->port);
+        return(-1);
+    }
+
+    pcard = (pmacCard *) callocMustSucceed(1, sizeof(pmacCard), functionName);
+    pasynUser = pasynManager->createAsynUser(processBatch, 0);
+    pasynUser->userPvt = pcard;
+    pasynUser->timeout = PMAC_TIMEOUT;
+    if (pasynManager->connectDevice(pasynUser, port, 0) != asynSuccess)
+    {
+        printf("%s:%s: cannot connect to port %s: %s\n", driverName,
+               functionName, port, pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        free(pcard);
+        return(-1);
+    }
+    pasynInterface = pasynManager->findInterface(pasynUser, asynOctetType, 1);
+    if (pasynInterface == NULL)
+    {
+        printf("%s:%s: port %s has no asynOctet interface\n", driverName,
+               functionName, port);
+        pasynManager->disconnect(pasynUser);
+        pasynManager->freeAsynUser(pasynUser);
+        free(pcard);
+        return(-1);
+    }
+
+    pcard->card = card;
+    pcard->port = epicsStrDup(port);
+    pcard->pasynUser = pasynUser;
+    pcard->pasynOctet = (asynOctet *) pasynInterface->pinterface;
+    pcard->octetPvt = pasynInterface->drvPvt;
+    pcard->lock = epicsMutexMustCreate();
+    pmac_cards[card] = pcard;
+    return(0);
+}
+
+
+/*****************************************************
+ * FUNCTION... pmacRequestCreate()
+ * USAGE...... Allocate the request for a record's VME_IO link.
+ *
+ * LOGIC...
+ *  The link card selects the port bound by pmacAsynPort(); the link
+ *  parameter is the PMAC variable, with room left for "=value".
+ *  Returns NULL, with a record error, on an invalid link.
+ *****************************************************/
+pmacRequest *pmacRequestCreate(dbCommon *precord, struct link *plink,
+                               int reply, int alone)
+{
+    pmacRequest *preq;
+    int card;
+
+    if (plink->type != VME_IO)
+    {
+        recGblRecordError(S_db_badField, (void *) precord,
+                          "devPmacAsyn (init_record) Illegal link type");
+        return(NULL);
+    }
+    card = plink->value.vmeio.card;
+    if (card < 0 || card >= MAX_PMAC_CARDS || pmac_cards[card] == NULL)
+    {
+        recGblRecordError(S_db_badField, (void *) precord,
+                          "devPmacAsyn (init_record) card not bound to a port");
+        return(NULL);
+    }
+    if (plink->value.vmeio.parm == NULL ||
+        strlen(plink->value.vmeio.parm) >= PMAC_CMD_SIZE - 24)
+    {
+        recGblRecordError(S_db_badField, (void *) precord,
+                          "devPmacAsyn (init_record) invalid link parameter");
+        return(NULL);
+    }
+
+    preq = (pmacRequest *) callocMustSucceed(1, sizeof(pmacRequest),
+                                             "pmacRequestCreate");
+    preq->precord = precord;
+    preq->card = pmac_cards[card];
+    preq->parm = plink->value.vmeio.parm;
+    preq->reply = reply;
+    preq->alone = alone;
+    return(preq);
+}
+
+
+/*****************************************************
+ * FUNCTION... pmacRequestQueue()
+ * USAGE...... Append a record's command to its card's pending batch.
+ *
+ * LOGIC...
+ *  Append to the pending list.
+ *  IF no batch request is queued on the port.
+ *      Queue one; it collects everything appended before it runs.
+ *  ENDIF
+ *****************************************************/
+int pmacRequestQueue(pmacRequest *preq, const char *cmd)
+{
+    static const char *functionName = "pmacRequestQueue";
+    pmacCard *pcard = preq->card;
+    asynStatus status = asynSuccess;
+
+    if (strlen(cmd) >= PMAC_CMD_SIZE)
+    {
+        asynPrint(pcard->pasynUser, ASYN_TRACE_ERROR,
+                  "%s:%s: %s command too long: %s\n", driverName,
+                  functionName, preq->precord->name, cmd);
+        return(-1);
+    }
+    strcpy(preq->cmd, cmd);
+    preq->next = NULL;
+    preq->value[0] = '\0';
+    preq->status = asynSuccess;
+
+    epicsMutexMustLock(pcard->lock);
+    if (pcard->tail == NULL)
+        pcard->head = preq;
+    else
+        pcard->tail->next = preq;
+    pcard->tail = preq;
+    if (!pcard->queued)
+    {
+        status = pasynManager->queueRequest(pcard->pasynUser,
+                                            asynQueuePriorityMedium, 0);
+        if (status == asynSuccess)
+            pcard->queued = 1;
+        else
+        {
+            asynPrint(pcard->pasynUser, ASYN_TRACE_ERROR,
+                      "%s:%s: %s queueRequest failed: %s\n", driverName,
+                      functionName, preq->precord->name,
+                      pcard->pasynUser->errorMessage);
+            pcard->head = pcard->tail = NULL;
+        }
+    }
+    epicsMutexUnlock(pcard->lock);
+    return(status == asynSuccess ? 0 : -1);
+}
+
+
+/*****************************************************
+ * FUNCTION... processBatch()
+ * USAGE...... asyn port thread callback; send one batch per call.
+ *
+ * LOGIC...
+ *  Take the longest run of pending requests that fits on one command
+ *  line (a request flagged "alone" always forms its own batch).
+ *  Send it and split the reply.
+ *  Process each record of the batch to complete its I/O.
+ *  IF requests are still pending.
+ *      Queue another batch request.
+ *  ENDIF
+ *****************************************************/
+static void processBatch(asynUser *pasynUser)
+{
+    static const char *functionName = "processBatch";
+    pmacCard *pcard = (pmacCard *) pasynUser->userPvt;
+    pmacRequest *batch, *last, *preq, *next;
+    int len, nreply, status;
+
+    epicsMutexMustLock(pcard->lock);
+    batch = pcard->head;
+    if (batch == NULL)
+    {
+        pcard->queued = 0;
+        epicsMutexUnlock(pcard->lock);
+        return;
+    }
+    last = batch;
+    len = strlen(batch->cmd);
+    nreply = batch->reply;
+    while (!batch->alone && last->next != NULL && !last->next->alone &&
+           len + 1 + (int) strlen(last->next->cmd) < PMAC_LINE_SIZE)
+    {
+        last = last->next;
+        len += 1 + strlen(last->cmd);
+        nreply += last->reply;
+    }
+    pcard->head = last->next;
+    if (pcard->head == NULL)
+        pcard->tail = NULL;
+    last->next = NULL;
+    epicsMutexUnlock(pcard->lock);
+
+    status = sendBatch(pcard, batch, nreply);
+
+    for (preq = batch; preq != NULL; preq = next)
+    {
+        next = preq->next;      /* The record may requeue preq once processed. */
+        preq->status = status;
+        callbackRequestProcessCallback(&preq->callback, preq->precord->prio,
+                                       preq->precord);
+    }
+
+    epicsMutexMustLock(pcard->lock);
+    if (pcard->head == NULL)
+        pcard->queued = 0;
+    else if (pasynManager->queueRequest(pasynUser, asynQueuePriorityMedium, 0)
+             != asynSuccess)
+    {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                  "%s:%s: %s queueRequest failed: %s\n", driverName,
+                  functionName, pcard->port, pasynUser->errorMessage);
+        batch = pcard->head;
+        pcard->head = pcard->tail = NULL;
+        pcard->queued = 0;
+        for (preq = batch; preq != NULL; preq = next)
+        {
+            next = preq->next;
+            preq->status = asynError;
+            callbackRequestProcessCallback(&preq->callback,
+                                           preq->precord->prio, preq->precord);
+        }
+    }
+    epicsMutexUnlock(pcard->lock);
+}
+
+
+/*****************************************************
+ * FUNCTION... sendBatch()
+ * USAGE...... Write one command line and demultiplex its reply.
+ *
+ * LOGIC...
+ *  Fail the batch if the port has an input EOS other than <ACK>; any
+ *  other terminator would split the reply before its <ACK>.
+ *  Join the batch commands with spaces and write the line.
+ *  Read until <ACK> or <BELL>, or until a read ends on the input EOS,
+ *  which is the <ACK> that asynInterposeEos has stripped.
+ *  IF the reply holds an error, or the line count does not match.
+ *      Fail the whole batch.
+ *  ENDIF
+ *  Copy reply lines, in order, to the requests that expect one.
+ *****************************************************/
+static int sendBatch(pmacCard *pcard, pmacRequest *batch, int nreply)
+{
+    static const char *functionName = "sendBatch";
+    asynUser *pasynUser = pcard->pasynUser;
+    char line[PMAC_LINE_SIZE + PMAC_CMD_SIZE];
+    char reply[PMAC_READ_SIZE];
+    char *pline, *pend, *plast;
+    char eos[2];
+    pmacRequest *preq;
+    size_t len, nwrite, nread, total;
+    int eom, eoslen, nlines;
+    asynStatus status;
+
+    if (pcard->pasynOctet->getInputEos(pcard->octetPvt, pasynUser, eos,
+                                       sizeof(eos), &eoslen) == asynSuccess &&
+        eoslen != 0 && (eoslen != 1 || eos[0] != PMAC_ACK))
+    {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                  "%s:%s: %s input EOS must be none or \\006\n", driverName,
+                  functionName, pcard->port);
+        return(asynError);
+    }
+
+    len = 0;
+    for (preq = batch; preq != NULL; preq = preq->next)
+    {
+        if (len != 0)
+            line[len++] = ' ';
+        strcpy(&line[len], preq->cmd);
+        len += strlen(preq->cmd);
+    }
+
+    pcard->pasynOctet->flush(pcard->octetPvt, pasynUser);
+    status = pcard->pasynOctet->write(pcard->octetPvt, pasynUser, line, len,
+                                      &nwrite);
+    if (status != asynSuccess)
+    {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                  "%s:%s: %s write \"%s\" failed: %s\n", driverName,
+                  functionName, pcard->port, line, pasynUser->errorMessage);
+        return(status);
+    }
+
+    total = 0;
+    do
+    {
+        status = pcard->pasynOctet->read(pcard->octetPvt, pasynUser,
+                                         &reply[total],
+                                         sizeof(reply) - 1 - total,
+                                         &nread, &eom);
+        total += nread;
+        reply[total] = '\0';
+    } while (status == asynSuccess && !(eom & ASYN_EOM_EOS) &&
+             total < sizeof(reply) - 1 &&
+             memchr(reply, PMAC_ACK, total) == NULL &&
+             memchr(reply, PMAC_BELL, total) == NULL);
+
+    asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
+              "%s:%s: %s \"%s\" -> %d bytes\n", driverName, functionName,
+              pcard->port, line, (int) total);
+
+    if (status != asynSuccess)
+    {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                  "%s:%s: %s read for \"%s\" failed: %s\n", driverName,
+                  functionName, pcard->port, line, pasynUser->errorMessage);
+        return(status);
+    }
+    if ((pend = (char *) memchr(reply, PMAC_BELL, total)) != NULL)
+    {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                  "%s:%s: %s error reply to \"%s\": %s\n", driverName,
+                  functionName, pcard->port, line, pend + 1);
+        return(asynError);
+    }
+    if ((pend = (char *) memchr(reply, PMAC_ACK, total)) != NULL)
+        *pend = '\0';
+
+    /* Split the reply into lines; blank lines carry no value. */
+    nlines = 0;
+    preq = batch;
+    for (pline = epicsStrtok_r(reply, "\r\n", &plast); pline != NULL;
+         pline = epicsStrtok_r(NULL, "\r\n", &plast))
+    {
+        nlines++;
+        while (preq != NULL && !preq->reply)
+            preq = preq->next;
+        if (preq != NULL)
+        {
+            epicsSnprintf(preq->value, PMAC_REPLY_SIZE, "%s", pline);
+            preq = preq->next;
+        }
+    }
+    if (nlines != nreply && !batch->alone)
+    {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                  "%s:%s: %s \"%s\" returned %d lines, expected %d\n",
+                  driverName, functionName, pcard->port, line, nlines, nreply);
+        return(asynError);
+    }
+    return(asynSuccess);
+}
@@ -0,0 +1,53 @@
+/******************************************************************************
+** Program:
+**    devPmacAsyn.h
+**
+** Description:
+**    Shared asyn command batcher for the PMAC ao/stringin/stringout device
+**    support. Requests queued during one scan cycle are packed into a single
+**    multi-variable PMAC command line and the reply is split back out.
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+******************************************************************************/
+#ifndef INCdevPmacAsynh
+#define INCdevPmacAsynh
+
+#include <callback.h>
+#include <dbCommon.h>
+#include <link.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PMAC_CMD_SIZE   64      /* Max. length of one variable/command. */
+#define PMAC_REPLY_SIZE 64      /* Max. length of one reply line. */
+
+typedef struct pmacCard pmacCard;
+
+/* Per-record request; owned by the record's DPVT. */
+typedef struct pmacRequest
+{
+    struct pmacRequest *next;
+    CALLBACK callback;
+    dbCommon *precord;
+    pmacCard *card;
+    const char *parm;           /* PMAC variable from the link. */
+    int reply;                  /* Command produces one reply line. */
+    int alone;                  /* Command must be sent on its own line. */
+    char cmd[PMAC_CMD_SIZE];
+    char value[PMAC_REPLY_SIZE];
+    int status;                 /* asynStatus of the completed request. */
+} pmacRequest;
+
+extern int pmacAsynPort(int, const char *);
+extern pmacRequest *pmacRequestCreate(dbCommon *, struct link *, int, int);
+extern int pmacRequestQueue(pmacRequest *, const char *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCdevPmacAsynh */
@@ -5,23 +5,29 @@
 ** Description:
 **    Device support for the stringin record, using the PMAC driver code.
 **
+**    Asynchronous; INP is VME_IO "#C<card> S0 @<variable>", where <card> is
+**    bound to an asyn port by pmacAsynPort(). The query must return exactly
+**    one reply line; it is batched with the other PMAC records of the same
+**    scan cycle by devPmacAsyn.
+**
 ** Author:
 **    Martin Norbury
 **
 ** $Id: devSiPmac.c,v 1.3 2005/05/18 09:19:36 mn Exp $
 **
 ** $Name:  $
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Asynchronous, batched I/O via devPmacAsyn.
 ******************************************************************************/
-#include	<vxWorks.h>
 #include	<stdlib.h>
 #include	<stdio.h>
-#include	<wdLib.h>
-#include	<memLib.h>
 #include	<string.h>
 
 #include	<alarm.h>
-#include	<callback.h>
 #include	<dbDefs.h>
+#include	<recGbl.h>
 #include	<dbAccess.h>
 #include	<recSup.h>
 #include	<devSup.h>
@@ -29,13 +35,12 @@
 #include	<dbCommon.h>
 #include	<stringinRecord.h>
 
+#include "devPmacAsyn.h"
 #include <epicsExport.h>
 
-SEM_ID *semptr;
-
-/* Create the dset for devSiTestAsyn */
-static long init_record();
-static long read_stringin();
+/* Create the dset for devSiPmac */
+static long init_record(struct stringinRecord *);
+static long read_stringin(struct stringinRecord *);
 struct {
 	long		number;
 	DEVSUPFUN	report;
@@ -48,70 +53,57 @@ struct {
 	6,
 	NULL,
 	NULL,
-	init_record,
+	(DEVSUPFUN) init_record,
 	NULL,
-	read_stringin,
+	(DEVSUPFUN) read_stringin,
 	NULL};
 
 epicsExportAddress(dset,devSiPmac);
 
 
-int send_mess(int card, char const *com, char *name);
-int recv_mess(int, char *, int);
-
-static long init_record(pstringin)
-struct stringinRecord	*pstringin;
+static long init_record(struct stringinRecord *pstringin)
 {
-  char * MyName = "init_record";
-  
-  printf("MN: stringin init_record\n");
+    pmacRequest *preq;
 
-  
-  printf("init_record: semptr = 0x%x\n",semptr);
+    /* A CONSTANT link leaves the record as a soft stringin. */
+    if (pstringin->inp.type == CONSTANT)
+        return(0);
 
-  /* stringin.inp must be a CONSTANT*/
-  switch (pstringin->inp.type) 
+    preq = pmacRequestCreate((dbCommon *) pstringin, &pstringin->inp, 1, 0);
+    if (preq == NULL || *preq->parm == '\0')
     {
-  
-    case (CONSTANT) :
-      printf("CONSTANT\n");
-      break;
-
-    case (VME_IO):
-      printf("VME_IO\n");
-      printf("%s: card %d signal %d parm %s\n",
-	     MyName,
-	     pstringin->inp.value.vmeio.card,
-	     pstringin->inp.value.vmeio.signal,
-	     pstringin->inp.value.vmeio.parm);
-      break;
-      
-    default :
-      printf("Error invalid type\n");
-
+        pstringin->pact = TRUE; /* Disable the record. */
+        return(S_db_badField);
     }
+    pstringin->dpvt = preq;
     return(0);
 }
 
-static long read_stringin(pstringin)
-struct stringinRecord	*pstringin;
+/* First pass queues the query and returns with PACT set; the batcher
+ * processes the record again with the reply line in preq->value. */
+static long read_stringin(struct stringinRecord *pstringin)
 {
-  int ret;
-  char buff[256];
-  char * MyName = "read_stringin";
+    pmacRequest *preq = (pmacRequest *) pstringin->dpvt;
 
-  printf("Inside read_stringin\n");
+    if (preq == NULL)
+        return(0);
 
-  printf("Send %s\n",pstringin->inp.value.vmeio.parm);
-  
-  printf("STRINGIN HAS TAKEN THE SEMAPHORE\n");
-  ret = send_mess(0,pstringin->inp.value.vmeio.parm,NULL);
-  printf("%s: return = 0x%x\n",MyName,ret);
-  
-  recv_mess(0,buff,1);
-  printf("recv_mess: %s\n",buff);
-  
-  strcpy(pstringin->val,buff);
-  
-  return(0);
+    if (!pstringin->pact)
+    {
+        if (pmacRequestQueue(preq, preq->parm) == 0)
+        {
+            pstringin->pact = TRUE;
+            return(0);
+        }
+    }
+    else if (preq->status == 0)
+    {
+        strncpy(pstringin->val, preq->value, sizeof(pstringin->val));
+        pstringin->val[sizeof(pstringin->val) - 1] = '\0';
+        pstringin->udf = FALSE;
+        return(0);
+    }
+
+    recGblSetSevr(pstringin, READ_ALARM, INVALID_ALARM);
+    return(0);
 }
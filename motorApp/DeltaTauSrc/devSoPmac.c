@@ -5,33 +5,40 @@
 ** Description:
 **    Device support for the stringout record, using the PMAC driver code.
 **
+**    Asynchronous; OUT is VME_IO "#C<card> S0 @", where <card> is bound to
+**    an asyn port by pmacAsynPort(). VAL is sent as a complete PMAC command.
+**    Since its reply is not known in advance, it goes out on a command line
+**    of its own through the devPmacAsyn queue.
+**
 ** Author:
 **    Martin Norbury
 **
 ** $Id: devSoPmac.c,v 1.3 2005/05/18 09:19:36 mn Exp $
 **
 ** $Name:  $
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Asynchronous I/O via devPmacAsyn.
 ******************************************************************************/
-#include	<vxWorks.h>
 #include	<stdlib.h>
 #include	<stdio.h>
 #include	<string.h>
 
 #include	<alarm.h>
 #include	<dbDefs.h>
+#include	<recGbl.h>
 #include	<dbAccess.h>
 #include        <recSup.h>
 #include	<devSup.h>
-#include	<module_types.h>
+#include	<dbCommon.h>
 #include	<stringoutRecord.h>
 
+#include "devPmacAsyn.h"
 #include <epicsExport.h>
 
-int send_mess(int card, char const *com, char *name);
-int recv_mess(int, char *, int);
-
-static long init_record();
-static long write_stringout();
+static long init_record(struct stringoutRecord *);
+static long write_stringout(struct stringoutRecord *);
 struct {
 	long		number;
 	DEVSUPFUN	report;
@@ -43,52 +50,42 @@ struct {
 	5,
         NULL,
 	NULL,
-	init_record,
+	(DEVSUPFUN) init_record,
 	NULL,
-	write_stringout
+	(DEVSUPFUN) write_stringout
 };
 
 epicsExportAddress(dset,devSoPmac);
 
-static long init_record(pstringout)
-struct stringoutRecord *pstringout;
+static long init_record(struct stringoutRecord *pstringout)
 {
-  char  * MyName = "init_record";
-
-   printf("MN: init_record\n");
+    pmacRequest *preq;
 
-   switch(pstringout->out.type)
-     {
-     case (VME_IO):
-       printf("VME_IO\n");
-       printf("%s: card %d signal %d parm %s\n",
-	      MyName,
-	      pstringout->out.value.vmeio.card,
-	      pstringout->out.value.vmeio.signal,
-	      pstringout->out.value.vmeio.parm);
-       break;
-
-     default:
-       printf("Error invalid type\n");
-     }
-
-   return 0;
+    preq = pmacRequestCreate((dbCommon *) pstringout, &pstringout->out, 0, 1);
+    if (preq == NULL)
+    {
+        pstringout->pact = TRUE; /* Disable the record. */
+        return(S_db_badField);
+    }
+    pstringout->dpvt = preq;
+    return(0);
 } /* end init_record() */
 
-static long write_stringout(pstringout)
-    struct stringoutRecord	*pstringout;
+static long write_stringout(struct stringoutRecord *pstringout)
 {
-    long status;
-    int ret;
-    char buff[256];
-    char * MyName = "write_stringout";
-
-    printf("%s: %s\n",MyName,pstringout->val);
+    pmacRequest *preq = (pmacRequest *) pstringout->dpvt;
 
-    ret = send_mess( 0, pstringout->val, NULL);
-    printf("%s: return = 0x%x\n",MyName,ret);
+    if (!pstringout->pact)
+    {
+        if (pmacRequestQueue(preq, pstringout->val) == 0)
+        {
+            pstringout->pact = TRUE;
+            return(0);
+        }
+    }
+    else if (preq->status == 0)
+        return(0);
 
-    recv_mess(0,buff,1);
-    printf("recv_mess: %s\n",buff);
+    recGblSetSevr(pstringout, WRITE_ALARM, INVALID_ALARM);
     return(0);
 }
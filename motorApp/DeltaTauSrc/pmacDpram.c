@@ -0,0 +1,154 @@
+/******************************************************************************
+** Program:
+**    pmacDpram.c
+**
+** Description:
+**    Per-card registry and snapshot access for the DPRAM-style PMAC status
+**    block described in pmacDpram.h.
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <epicsTime.h>
+
+#include "motorBarrier.h"
+#include "pmacDpram.h"
+
+#define MAX_READ_RETRIES 100
+
+static const char *driverName = "pmacDpram";
+
+static volatile pmacDpramStatus *dpram_cards[PMAC_DPRAM_CARDS];
+
+
+/*****************************************************
+ * FUNCTION... pmacDpramAttach()
+ * USAGE...... Register a card's status block (mapped DPRAM or simulator).
+ *****************************************************/
+int pmacDpramAttach(int card, volatile pmacDpramStatus *pblock)
+{
+    if (card < 0 || card >= PMAC_DPRAM_CARDS)
+    {
+        printf("%s:pmacDpramAttach: invalid card %d (0-%d)\n", driverName,
+               card, PMAC_DPRAM_CARDS - 1);
+        return(-1);
+    }
+    dpram_cards[card] = pblock;
+    return(0);
+}
+
+
+volatile pmacDpramStatus *pmacDpramGet(int card)
+{
+    if (card < 0 || card >= PMAC_DPRAM_CARDS)
+        return(NULL);
+    return(dpram_cards[card]);
+}
+
+
+/*****************************************************
+ * FUNCTION... pmacDpramRead()
+ * USAGE...... Copy a consistent snapshot of a card's status block.
+ *
+ * LOGIC...
+ *  Return -1 if the card has no valid block.
+ *  DO
+ *      Read the sequence; retry while it is odd (writer active).
+ *      memcpy the whole block.
+ *      Re-read the sequence.
+ *  WHILE the sequence changed and retries remain.
+ *  Return the number of retries, or -1 if no stable copy was obtained.
+ *****************************************************/
+int pmacDpramRead(int card, pmacDpramStatus *pdest)
+{
+    volatile pmacDpramStatus *psrc = pmacDpramGet(card);
+    epicsUInt32 before, after;
+    int retries;
+
+    if (psrc == NULL || psrc->magic != PMAC_DPRAM_MAGIC ||
+        psrc->version != PMAC_DPRAM_VERSION)
+        return(-1);
+
+    for (retries = 0; retries < MAX_READ_RETRIES; retries++)
+    {
+        before = psrc->sequence;
+        if (before & 1)
+            continue;
+        MOTOR_BARRIER();   /* Order the sequence counter against the block contents. */
+        memcpy(pdest, (const void *) psrc, sizeof(pmacDpramStatus));
+        MOTOR_BARRIER();
+        after = psrc->sequence;
+        if (after == before)
+        {
+            if (pdest->naxes > PMAC_DPRAM_AXES)
+                pdest->naxes = PMAC_DPRAM_AXES;
+            return(retries);
+        }
+    }
+    return(-1);
+}
+
+
+void pmacDpramWriteBegin(volatile pmacDpramStatus *pblock)
+{
+    pblock->sequence++;
+    MOTOR_BARRIER();
+}
+
+
+void pmacDpramWriteEnd(volatile pmacDpramStatus *pblock)
+{
+    MOTOR_BARRIER();
+    pblock->sequence++;
+}
+
+
+/*****************************************************
+ * FUNCTION... pmacDpramReport()
+ * USAGE...... Time nreads snapshots of a card's block and print its axes.
+ *****************************************************/
+int pmacDpramReport(int card, int nreads)
+{
+    pmacDpramStatus snapshot;
+    epicsTimeStamp start, end;
+    int i, axis, status = 0, retries = 0;
+    double elapsed;
+
+    if (nreads < 1)
+        nreads = 1;
+    epicsTimeGetCurrent(&start);
+    for (i = 0; i < nreads && status >= 0; i++)
+    {
+        status = pmacDpramRead(card, &snapshot);
+        retries += status;
+    }
+    epicsTimeGetCurrent(&end);
+    if (status < 0)
+    {
+        printf("%s: card %d has no valid status block\n", driverName, card);
+        return(-1);
+    }
+    elapsed = epicsTimeDiffInSeconds(&end, &start);
+
+    printf("%s: card %d, %d reads, %.3f us/read, %d retries, sequence %u, "
+           "servo time %.3f s\n", driverName, card, nreads,
+           1e6 * elapsed / nreads, retries, snapshot.sequence,
+           snapshot.servoTime);
+    for (axis = 0; axis < (int) snapshot.naxes; axis++)
+    {
+        pmacDpramAxis *pAxis = &snapshot.axis[axis];
+
+        if (pAxis->position == 0.0 && pAxis->velocity == 0.0)
+            continue;
+        printf("  axis %2d: position %.3f following %.4f velocity %.3f "
+               "status %06x %06x %06x\n", axis + 1, pAxis->position,
+               pAxis->following, pAxis->velocity, pAxis->status[0],
+               pAxis->status[1], pAxis->status[2]);
+    }
+    return(0);
+}
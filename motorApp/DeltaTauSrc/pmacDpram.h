@@ -0,0 +1,66 @@
+/******************************************************************************
+** Program:
+**    pmacDpram.h
+**
+** Description:
+**    Fixed-layout, DPRAM-style PMAC status block. The controller (or the
+**    pmacDpramSim simulator) keeps positions, following errors and status
+**    words for every axis up to date in shared memory; a poller takes a
+**    consistent snapshot of all axes with one memcpy and no ASCII commands.
+**
+**    The writer bumps "sequence" to an odd value before it updates the block
+**    and to the next even value afterwards. pmacDpramRead() retries its copy
+**    until it sees the same even sequence on both sides.
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+******************************************************************************/
+#ifndef INCpmacDpramh
+#define INCpmacDpramh
+
+#include <epicsTypes.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PMAC_DPRAM_AXES     32
+#define PMAC_DPRAM_CARDS    8
+#define PMAC_DPRAM_MAGIC    0x504d4143  /* "PMAC" */
+#define PMAC_DPRAM_VERSION  1
+
+/* Status word 3 bits; same layout as the "#n?" reply of pmacsimulation.py. */
+#define PMAC_STAT3_INPOSITION   0x0001
+
+typedef struct pmacDpramAxis
+{
+    epicsFloat64 position;      /* Actual position (counts). */
+    epicsFloat64 following;     /* Following error (counts). */
+    epicsFloat64 velocity;      /* Actual velocity (counts/s). */
+    epicsUInt32  status[3];     /* Motor status words 1-3. */
+    epicsUInt32  spare;
+} pmacDpramAxis;
+
+typedef struct pmacDpramStatus
+{
+    epicsUInt32  magic;         /* PMAC_DPRAM_MAGIC once initialised. */
+    epicsUInt32  version;       /* PMAC_DPRAM_VERSION. */
+    epicsUInt32  sequence;      /* Odd while the writer is updating. */
+    epicsUInt32  naxes;         /* Valid entries in axis[]. */
+    epicsFloat64 servoTime;     /* Writer time of this update (s). */
+    pmacDpramAxis axis[PMAC_DPRAM_AXES];
+} pmacDpramStatus;
+
+extern int pmacDpramAttach(int, volatile pmacDpramStatus *);
+extern volatile pmacDpramStatus *pmacDpramGet(int);
+extern int pmacDpramRead(int, pmacDpramStatus *);
+extern void pmacDpramWriteBegin(volatile pmacDpramStatus *);
+extern void pmacDpramWriteEnd(volatile pmacDpramStatus *);
+extern int pmacDpramReport(int, int);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCpmacDpramh */
@@ -0,0 +1,225 @@
+/******************************************************************************
+** Program:
+**    pmacDpramSim.cpp
+**
+** Description:
+**    Simulated PMAC that keeps a pmacDpramStatus block up to date at a
+**    configurable rate. Each update integrates a trapezoidal move for every
+**    axis over the real elapsed time, so the motion is independent of the
+**    update rate, and then rewrites the whole block under the sequence
+**    counter. This replaces the 10 Hz Python dpramsimulation.py thread for
+**    testing the zero-command polling path.
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+** .02 2026-10-19     Share the motion model with pmacSimCore.
+******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <cantProceed.h>
+
+#include "pmacDpramSim.h"
+#include "pmacSimCore.h"
+
+#define FOLLOWING_LAG   0.001   /* Following error = velocity * lag (s). */
+
+static const char *driverName = "pmacDpramSim";
+
+static pmacDpramSim *dpram_sims[PMAC_DPRAM_CARDS];
+
+extern "C" {
+static void simThreadC(void *pPvt)
+{
+    pmacDpramSim *pSim = (pmacDpramSim *) pPvt;
+    pSim->run();
+}
+}
+
+
+pmacDpramSim::pmacDpramSim(int card, double rate)
+    : card_(card), rate_(rate), done_(epicsEventEmpty), exiting_(false)
+{
+    char threadName[32];
+    int axis;
+
+    block_ = (pmacDpramStatus *) callocMustSucceed(1, sizeof(pmacDpramStatus),
+                                                   driverName);
+    for (axis = 0; axis < PMAC_DPRAM_AXES; axis++)
+    {
+        demand_[axis] = position_[axis] = velocity_[axis] = 0.0;
+        maxVelocity_[axis] = 1000.0;
+        accel_[axis] = 10000.0;
+    }
+    block_->version = PMAC_DPRAM_VERSION;
+    block_->naxes = PMAC_DPRAM_AXES;
+    last_ = epicsTime::getCurrent();
+    update(0.0);
+    block_->magic = PMAC_DPRAM_MAGIC;
+    pmacDpramAttach(card, block_);
+    dpram_sims[card] = this;
+
+    sprintf(threadName, "pmacDpramSim%d", card);
+    epicsThreadCreate(threadName, epicsThreadPriorityHigh,
+                      epicsThreadGetStackSize(epicsThreadStackMedium),
+                      simThreadC, this);
+}
+
+
+pmacDpramSim::~pmacDpramSim()
+{
+    exiting_ = true;
+    done_.wait();
+    pmacDpramAttach(card_, NULL);
+    dpram_sims[card_] = NULL;
+    free(block_);
+}
+
+
+pmacDpramSim *pmacDpramSim::find(int card)
+{
+    if (card < 0 || card >= PMAC_DPRAM_CARDS)
+        return(NULL);
+    return(dpram_sims[card]);
+}
+
+
+/*****************************************************
+ * FUNCTION... move()
+ * USAGE...... Start an absolute move; velocity/accel <= 0 keep the last.
+ *****************************************************/
+int pmacDpramSim::move(int axis, double position, double velocity,
+                       double accel)
+{
+    if (axis < 1 || axis > PMAC_DPRAM_AXES)
+        return(-1);
+    lock_.lock();
+    axis--;
+    demand_[axis] = position;
+    if (velocity > 0.0)
+        maxVelocity_[axis] = velocity;
+    if (accel > 0.0)
+        accel_[axis] = accel;
+    lock_.unlock();
+    return(0);
+}
+
+
+int pmacDpramSim::stop(int axis)
+{
+    double v, a;
+
+    if (axis < 1 || axis > PMAC_DPRAM_AXES)
+        return(-1);
+    lock_.lock();
+    axis--;
+    v = velocity_[axis];
+    a = accel_[axis];
+    /* Decelerate to rest from the current velocity. */
+    demand_[axis] = position_[axis] + v * fabs(v) / (2.0 * a);
+    lock_.unlock();
+    return(0);
+}
+
+
+/*****************************************************
+ * FUNCTION... update()
+ * USAGE...... Advance every axis by dt seconds and rewrite the block.
+ *
+ * LOGIC...
+ *  Advance all axes with pmacSimCore::integrate().
+ *  Rewrite the block between pmacDpramWriteBegin()/pmacDpramWriteEnd().
+ *****************************************************/
+void pmacDpramSim::update(double dt)
+{
+    int axis;
+
+    lock_.lock();
+    pmacSimCore::integrate(PMAC_DPRAM_AXES, demand_, position_, velocity_,
+                           maxVelocity_, accel_, dt);
+
+    pmacDpramWriteBegin(block_);
+    block_->servoTime += dt;
+    for (axis = 0; axis < PMAC_DPRAM_AXES; axis++)
+    {
+        pmacDpramAxis *pAxis = &block_->axis[axis];
+
+        pAxis->position = position_[axis];
+        pAxis->velocity = velocity_[axis];
+        pAxis->following = velocity_[axis] * FOLLOWING_LAG;
+        if (velocity_[axis] == 0.0 && position_[axis] == demand_[axis])
+            pAxis->status[2] |= PMAC_STAT3_INPOSITION;
+        else
+            pAxis->status[2] &= ~PMAC_STAT3_INPOSITION;
+    }
+    pmacDpramWriteEnd(block_);
+    lock_.unlock();
+}
+
+
+/*****************************************************
+ * FUNCTION... run()
+ * USAGE...... Simulator thread; updates the block at rate_ Hz.
+ *
+ * LOGIC...
+ *  Keep an absolute deadline so sleep jitter does not accumulate.
+ *  Integrate over the measured elapsed time, not the nominal period.
+ *  IF more than one period late, resynchronise the deadline.
+ *****************************************************/
+void pmacDpramSim::run()
+{
+    double period = 1.0 / rate_;
+    epicsTime next = epicsTime::getCurrent();
+    epicsTime now;
+
+    while (!exiting_)
+    {
+        next += period;
+        now = epicsTime::getCurrent();
+        if (next > now)
+            epicsThreadSleep(next - now);
+        else if (now - next > period)
+            next = now;
+        now = epicsTime::getCurrent();
+        update(now - last_);
+        last_ = now;
+    }
+    done_.signal();
+}
+
+
+/* C-callable wrappers for the iocsh commands in PmacRegister.cc. */
+extern "C" int pmacDpramSimConfig(int card, double rate)
+{
+    if (card < 0 || card >= PMAC_DPRAM_CARDS || rate <= 0.0)
+    {
+        printf("%s: invalid card %d (0-%d) or rate %g\n", driverName, card,
+               PMAC_DPRAM_CARDS - 1, rate);
+        return(-1);
+    }
+    if (dpram_sims[card] != NULL || pmacDpramGet(card) != NULL)
+    {
+        printf("%s: card %d already has a status block\n", driverName, card);
+        return(-1);
+    }
+    new pmacDpramSim(card, rate);
+    return(0);
+}
+
+
+extern "C" int pmacDpramSimMove(int card, int axis, double position,
+                                double velocity, double accel)
+{
+    pmacDpramSim *pSim = pmacDpramSim::find(card);
+
+    if (pSim == NULL)
+    {
+        printf("%s: card %d not configured\n", driverName, card);
+        return(-1);
+    }
+    return(pSim->move(axis, position, velocity, accel));
+}
@@ -0,0 +1,55 @@
+/******************************************************************************
+** Program:
+**    pmacDpramSim.h
+**
+** Description:
+**    Simulated PMAC that keeps a pmacDpramStatus block up to date at a
+**    configurable rate, for testing the DPRAM status path without hardware.
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+******************************************************************************/
+#ifndef INCpmacDpramSimh
+#define INCpmacDpramSimh
+
+#include <epicsThread.h>
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <epicsTime.h>
+
+#include "pmacDpram.h"
+
+class pmacDpramSim
+{
+public:
+    pmacDpramSim(int card, double rate);
+    ~pmacDpramSim();
+    int move(int axis, double position, double velocity, double accel);
+    int stop(int axis);
+    void run();
+
+    static pmacDpramSim *find(int card);
+
+private:
+    void update(double dt);
+
+    int card_;
+    double rate_;               /* Block updates per second. */
+    pmacDpramStatus *block_;
+    epicsMutex lock_;
+    epicsEvent done_;
+    bool exiting_;
+    epicsTime last_;
+    /* Per-axis state, kept as flat arrays. */
+    double demand_[PMAC_DPRAM_AXES];
+    double position_[PMAC_DPRAM_AXES];
+    double velocity_[PMAC_DPRAM_AXES];
+    double maxVelocity_[PMAC_DPRAM_AXES];
+    double accel_[PMAC_DPRAM_AXES];
+};
+
+extern "C" int pmacDpramSimConfig(int, double);
+extern "C" int pmacDpramSimMove(int, int, double, double, double);
+
+#endif /* INCpmacDpramSimh */
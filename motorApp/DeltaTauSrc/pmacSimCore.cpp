@@ -0,0 +1,365 @@
+/******************************************************************************
+** Program:
+**    pmacSimCore.cpp
+**
+** Description:
+**    Native PMAC simulator core. Implements the ASCII command set handled
+**    by dpramsimulation.py/pmacsimulation.py:
+**
+**        #n            address motor n
+**        #n? / #nP / #nV   status words, position (counts), velocity
+**        J=<pos> / #nJ=<pos>   move (counts)
+**        J/ / #nJ/     stop
+**        In[=v] Mn[=v] Pn[=v]  read or write a variable
+**        TYPE, VERSION
+**
+**    Any number of commands may share a line. Each query appends
+**    "<value><CR>" to the reply and the line is terminated by <ACK>; an
+**    unknown command ends the line with "<BELL>ERR003<CR>", as on a PMAC.
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+** .02 2026-10-19     advance() for the in-process asynMockController handler.
+******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include <epicsThread.h>
+#include <epicsStdio.h>
+#include <epicsString.h>
+
+#include "pmacSimCore.h"
+
+#define PMAC_ACK        '\006'
+#define PMAC_BELL       '\007'
+#define READBACK_SCALE  32.0    /* Mxx61/Mxx62 units per count. */
+
+static const char *driverName = "pmacSimCore";
+
+static const char *simType = "SIMULATION";
+static const char *simVersion = "V2.0";
+
+
+pmacSimCore::pmacSimCore(double rate)
+    : rate_(rate), updates_(0), commands_(0)
+{
+    int axis;
+
+    memset(ivar_, 0, sizeof(ivar_));
+    memset(mvar_, 0, sizeof(mvar_));
+    memset(pvar_, 0, sizeof(pvar_));
+    for (axis = 1; axis <= PMAC_SIM_MAX_AXIS; axis++)
+    {
+        ivar_[axis * 100 + PMAC_SIM_I_ACTIVATE] = 1;
+        ivar_[axis * 100 + PMAC_SIM_I_SCALEFAC] = 1;
+        ivar_[axis * 100 + PMAC_SIM_I_DEMVEL] = 32.0;
+        ivar_[axis * 100 + PMAC_SIM_I_DEMACC] = 0.015625;
+    }
+    for (axis = 0; axis < PMAC_SIM_MAX_AXIS; axis++)
+        demand_[axis] = position_[axis] = velocity_[axis] = 0.0;
+    last_ = epicsTime::getCurrent();
+    update(0.0);
+}
+
+
+/*****************************************************
+ * FUNCTION... integrate()
+ * USAGE...... Advance naxes trapezoidal moves by dt seconds.
+ *
+ * LOGIC...
+ *  One pass over flat per-axis arrays with no per-axis state machine:
+ *  FOR each axis.
+ *      IF moving away from the demand or within the stopping distance.
+ *          Decelerate towards zero velocity.
+ *      ELSE
+ *          Accelerate towards the maximum velocity.
+ *      ENDIF
+ *      Integrate the position; snap to the demand on overshoot.
+ *  ENDFOR
+ *  A non-positive acceleration is treated as infinite.
+ *****************************************************/
+void pmacSimCore::integrate(int naxes, const double *demand, double *position,
+                            double *velocity, const double *maxVelocity,
+                            const double *accel, double dt)
+{
+    int axis;
+
+    for (axis = 0; axis < naxes; axis++)
+    {
+        double dist = demand[axis] - position[axis];
+        double dir = (dist >= 0.0) ? 1.0 : -1.0;
+        double v = velocity[axis];
+        double a = (accel[axis] > 0.0) ? accel[axis] : HUGE_VAL;
+        double dv = a * dt;
+        double pos;
+
+        if (v * dir < 0.0 || fabs(dist) <= v * v / (2.0 * a))
+            v = (fabs(v) <= dv) ? 0.0 : v - ((v > 0.0) ? dv : -dv);
+        else
+        {
+            v += dir * dv;
+            if (fabs(v) > maxVelocity[axis])
+                v = dir * maxVelocity[axis];
+        }
+        pos = position[axis] + v * dt;
+        if ((demand[axis] - pos) * dir <= 0.0)
+        {
+            pos = demand[axis];
+            v = 0.0;
+        }
+        position[axis] = pos;
+        velocity[axis] = v;
+    }
+}
+
+
+/* Refresh the velocity/acceleration limits from Ixx22/Ixx19 and move. */
+void pmacSimCore::update(double dt)
+{
+    int axis;
+
+    lock_.lock();
+    for (axis = 0; axis < PMAC_SIM_MAX_AXIS; axis++)
+    {
+        maxVelocity_[axis] = 1000.0 * fabs(ivar_[(axis + 1) * 100 + PMAC_SIM_I_DEMVEL]);
+        accel_[axis] = 1000000.0 * fabs(ivar_[(axis + 1) * 100 + PMAC_SIM_I_DEMACC]);
+    }
+    integrate(PMAC_SIM_MAX_AXIS, demand_, position_, velocity_, maxVelocity_,
+              accel_, dt);
+    updates_++;
+    lock_.unlock();
+}
+
+
+/* Advance the motion by dt seconds; for callers that keep their own time. */
+void pmacSimCore::advance(double dt)
+{
+    update(dt);
+}
+
+
+/*****************************************************
+ * FUNCTION... run()
+ * USAGE...... Motion thread; calls update() at rate_ Hz.
+ *
+ * LOGIC...
+ *  Keep an absolute deadline so sleep jitter does not accumulate.
+ *  Integrate over the measured elapsed time, not the nominal period.
+ *  IF more than one period late, resynchronise the deadline.
+ *****************************************************/
+void pmacSimCore::run()
+{
+    double period = 1.0 / rate_;
+    epicsTime next = epicsTime::getCurrent();
+    epicsTime now;
+
+    for (;;)
+    {
+        next += period;
+        now = epicsTime::getCurrent();
+        if (next > now)
+            epicsThreadSleep(next - now);
+        else if (now - next > period)
+            next = now;
+        now = epicsTime::getCurrent();
+        update(now - last_);
+        last_ = now;
+    }
+}
+
+
+/* Map a variable name to its storage; NULL if out of range. */
+double *pmacSimCore::variable(char type, int num)
+{
+    if (num < 0)
+        return(NULL);
+    switch (type)
+    {
+        case 'I':
+            return((num <= PMAC_SIM_MAX_IVAR) ? &ivar_[num] : NULL);
+        case 'M':
+            return((num <= PMAC_SIM_MAX_MVAR) ? &mvar_[num] : NULL);
+        case 'P':
+            return((num < PMAC_SIM_MAX_PVAR) ? &pvar_[num] : NULL);
+    }
+    return(NULL);
+}
+
+
+/*****************************************************
+ * FUNCTION... process()
+ * USAGE...... Execute one upper-case command token.
+ *
+ * LOGIC...
+ *  Returns the number of reply bytes appended, or -1 for an error.
+ *  Motor M-variables (Mxx34, Mxx44, Mxx61, Mxx62) map onto the motion
+ *  state; all other variables are plain storage.
+ *****************************************************/
+int pmacSimCore::process(char *token, int *axis, char *reply, int maxReply)
+{
+    char *end, *eq;
+    double *pvar, value;
+    int num, index;
+
+    if (*token == '#')
+    {
+        num = strtol(token + 1, &end, 10);
+        if (end == token + 1 || num < 1 || num > PMAC_SIM_MAX_AXIS)
+            return(-1);
+        *axis = num;
+        token = end;
+        if (*token == '\0')
+            return(0);
+        index = *axis - 1;
+        if (strcmp(token, "?") == 0)
+            return(epicsSnprintf(reply, maxReply, "%04x%04x%04x\r", 0, 0,
+                                 (velocity_[index] == 0.0 &&
+                                  position_[index] == demand_[index]) ?
+                                 PMAC_SIM_STAT_INPOSITION : 0));
+        if (strcmp(token, "P") == 0)
+            return(epicsSnprintf(reply, maxReply, "%.10g\r", position_[index]));
+        if (strcmp(token, "V") == 0)
+            return(epicsSnprintf(reply, maxReply, "%.10g\r", velocity_[index]));
+    }
+
+    index = *axis - 1;
+    if (*token == 'J' && (index < 0 || index >= PMAC_SIM_MAX_AXIS))
+        return(-1);
+    if (strcmp(token, "J/") == 0)
+    {
+        double v = velocity_[index];
+        double a = accel_[index];
+
+        demand_[index] = position_[index] + ((a > 0.0) ? v * fabs(v) / (2.0 * a) : 0.0);
+        return(0);
+    }
+    if (strncmp(token, "J=", 2) == 0)
+    {
+        value = strtod(token + 2, &end);
+        if (end == token + 2 || *end != '\0')
+            return(-1);
+        demand_[index] = value;
+        return(0);
+    }
+    if (strcmp(token, "TYPE") == 0)
+        return(epicsSnprintf(reply, maxReply, "%s\r", simType));
+    if (strcmp(token, "VERSION") == 0)
+        return(epicsSnprintf(reply, maxReply, "%s\r", simVersion));
+
+    num = strtol(token + 1, &end, 10);
+    if (end == token + 1 || (pvar = variable(*token, num)) == NULL)
+        return(-1);
+    eq = end;
+    if (*eq == '=')
+    {
+        value = strtod(eq + 1, &end);
+        if (end == eq + 1 || *end != '\0')
+            return(-1);
+    }
+    else if (*eq != '\0')
+        return(-1);
+
+    index = num / 100 - 1;
+    if (*token == 'M' && index >= 0 && index < PMAC_SIM_MAX_AXIS)
+    {
+        switch (num % 100)
+        {
+            case PMAC_SIM_M_DEMANDPOS:
+                if (*eq == '=')
+                    demand_[index] = value / READBACK_SCALE;
+                else
+                    *pvar = demand_[index] * READBACK_SCALE;
+                break;
+            case PMAC_SIM_M_READBACK:
+                *pvar = position_[index] * READBACK_SCALE;
+                break;
+            case PMAC_SIM_M_MOTPROGRAM:
+                *pvar = 0;
+                break;
+            case PMAC_SIM_M_AXISHOMED:
+                *pvar = 1;
+                break;
+        }
+    }
+    if (*eq == '=')
+    {
+        if (!(*token == 'M' && index >= 0 && index < PMAC_SIM_MAX_AXIS &&
+              num % 100 == PMAC_SIM_M_DEMANDPOS))
+            *pvar = value;
+        return(0);
+    }
+    return(epicsSnprintf(reply, maxReply, "%.10g\r", *pvar));
+}
+
+
+/*****************************************************
+ * FUNCTION... command()
+ * USAGE...... Execute one command line; returns the reply length.
+ *
+ * LOGIC...
+ *  Upper-case the line and close up blanks around '='.
+ *  FOR each blank-separated token.
+ *      Execute it, appending any reply line.
+ *      IF it failed, end the reply with <BELL>ERR003<CR> and stop.
+ *  ENDFOR
+ *  Terminate the reply with <ACK>.
+ *  *axis is the connection's addressed motor and persists between lines.
+ *****************************************************/
+int pmacSimCore::command(char *line, int *axis, char *reply, int maxReply)
+{
+    char *src, *dst, *token, *last;
+    int len = 0, n;
+
+    for (src = dst = line; *src != '\0'; src++)
+    {
+        if (isspace((unsigned char) *src) &&
+            (src[1] == '=' || (dst > line && dst[-1] == '=')))
+            continue;
+        if (*src == '=')
+            while (dst > line && isspace((unsigned char) dst[-1]))
+                dst--;
+        *dst++ = toupper((unsigned char) *src);
+    }
+    *dst = '\0';
+
+    lock_.lock();
+    commands_++;
+    for (token = epicsStrtok_r(line, " \t\r\n", &last); token != NULL;
+         token = epicsStrtok_r(NULL, " \t\r\n", &last))
+    {
+        n = process(token, axis, &reply[len], maxReply - len - 1);
+        if (n < 0 || len + n >= maxReply - 1)
+        {
+            lock_.unlock();
+            if (len > maxReply - 9)
+                len = maxReply - 9;
+            return(len + epicsSnprintf(&reply[len], maxReply - len,
+                                       "%cERR003\r", PMAC_BELL));
+        }
+        len += n;
+    }
+    lock_.unlock();
+    reply[len++] = PMAC_ACK;
+    reply[len] = '\0';
+    return(len);
+}
+
+
+void pmacSimCore::report()
+{
+    int axis;
+
+    lock_.lock();
+    printf("%s: %g Hz, %lu updates, %lu command lines\n", driverName, rate_,
+           updates_, commands_);
+    for (axis = 0; axis < PMAC_SIM_MAX_AXIS; axis++)
+        if (position_[axis] != 0.0 || demand_[axis] != 0.0)
+            printf("  #%-2d position %.3f demand %.3f velocity %.3f\n",
+                   axis + 1, position_[axis], demand_[axis], velocity_[axis]);
+    lock_.unlock();
+}
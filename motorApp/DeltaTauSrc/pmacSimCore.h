@@ -0,0 +1,80 @@
+/******************************************************************************
+** Program:
+**    pmacSimCore.h
+**
+** Description:
+**    Native PMAC simulator core; replaces the Python pmacsimulation.py model.
+**    I-, M- and P-variables are flat arrays and the per-axis motion state is
+**    kept as one array per quantity, so every update runs the same
+**    straight-line loop over all MAX_AXIS axes.
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+** .02 2026-10-19     advance() for the in-process asynMockController handler.
+******************************************************************************/
+#ifndef INCpmacSimCoreh
+#define INCpmacSimCoreh
+
+#include <epicsMutex.h>
+#include <epicsTime.h>
+
+#define PMAC_SIM_MAX_AXIS   32
+#define PMAC_SIM_MAX_IVAR   3300
+#define PMAC_SIM_MAX_MVAR   3300
+#define PMAC_SIM_MAX_PVAR   8192
+
+/* Per-axis I-variable offsets (Ixx<off>). */
+#define PMAC_SIM_I_ACTIVATE 0
+#define PMAC_SIM_I_SCALEFAC 8
+#define PMAC_SIM_I_DEMACC   19      /* counts/msec^2 */
+#define PMAC_SIM_I_DEMVEL   22      /* counts/msec */
+
+/* Per-axis M-variable offsets (Mxx<off>). */
+#define PMAC_SIM_M_MOTPROGRAM   34
+#define PMAC_SIM_M_AXISHOMED    44
+#define PMAC_SIM_M_DEMANDPOS    61  /* 1/32 counts */
+#define PMAC_SIM_M_READBACK     62  /* 1/32 counts */
+
+/* Status word 3. */
+#define PMAC_SIM_STAT_INPOSITION 0x1
+
+class pmacSimCore
+{
+public:
+    pmacSimCore(double rate);
+    int command(char *line, int *axis, char *reply, int maxReply);
+    void advance(double dt);
+    void run();
+    void report();
+
+    static void integrate(int naxes, const double *demand, double *position,
+                          double *velocity, const double *maxVelocity,
+                          const double *accel, double dt);
+
+private:
+    int process(char *token, int *axis, char *reply, int maxReply);
+    double *variable(char type, int num);
+    void update(double dt);
+
+    epicsMutex lock_;
+    double rate_;               /* Motion updates per second. */
+    epicsTime last_;
+    unsigned long updates_;
+    unsigned long commands_;
+    double ivar_[PMAC_SIM_MAX_IVAR + 1];
+    double mvar_[PMAC_SIM_MAX_MVAR + 1];
+    double pvar_[PMAC_SIM_MAX_PVAR];
+    /* Per-axis state in counts and counts/s; index 0 is axis #1. */
+    double demand_[PMAC_SIM_MAX_AXIS];
+    double position_[PMAC_SIM_MAX_AXIS];
+    double velocity_[PMAC_SIM_MAX_AXIS];
+    double maxVelocity_[PMAC_SIM_MAX_AXIS];
+    double accel_[PMAC_SIM_MAX_AXIS];
+};
+
+extern "C" int pmacSimConfig(int, double);
+extern "C" int pmacSimReport(void);
+extern void pmacSimMockRegister(void);
+
+#endif /* INCpmacSimCoreh */
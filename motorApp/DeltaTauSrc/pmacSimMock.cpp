@@ -0,0 +1,71 @@
+/******************************************************************************
+** Program:
+**    pmacSimMock.cpp
+**
+** Description:
+**    "pmac" handler for asynMockController: runs a pmacSimCore inside the
+**    IOC, behind a loopback asynOctet port, with no simulator thread or
+**    socket. The motion is advanced from the mock port's clock before every
+**    write, so a given command sequence always produces the same replies.
+**
+**    asynMockControllerConfig("PMAC1", "pmac", "", 1.0, 0.2, 1)
+**    asynOctetSetOutputEos("PMAC1", 0, "\r")
+**
+**    Leave the input EOS unset: devPmacAsyn reads each reply up to its
+**    <ACK> itself, and only accepts "\006" as an input EOS.
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <asynMockController.h>
+
+#include "pmacSimCore.h"
+
+class pmacMockHandler : public asynMockHandler
+{
+public:
+    pmacMockHandler() : core_(0.0), axis_(1), time_(0.0) {}
+
+    int command(const char *command, char *reply, int maxReply)
+    {
+        char line[1024];
+
+        strncpy(line, command, sizeof(line) - 1);
+        line[sizeof(line) - 1] = '\0';
+        return(core_.command(line, &axis_, reply, maxReply));
+    }
+
+    void advance(double time)
+    {
+        core_.advance(time - time_);
+        time_ = time;
+    }
+
+    void report(FILE *fp, int details)
+    {
+        core_.report();
+    }
+
+private:
+    pmacSimCore core_;
+    int axis_;                  /* Addressed motor of the port. */
+    double time_;               /* Mock port time of the last advance(). */
+};
+
+
+static asynMockHandler *pmacMockFactory(const char *parameters)
+{
+    return(new pmacMockHandler());
+}
+
+
+void pmacSimMockRegister(void)
+{
+    asynMockHandlerRegister("pmac", pmacMockFactory);
+}
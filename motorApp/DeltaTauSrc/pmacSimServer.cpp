@@ -0,0 +1,190 @@
+/******************************************************************************
+** Program:
+**    pmacSimServer.cpp
+**
+** Description:
+**    TCP front end for pmacSimCore. Each client connection gets its own
+**    thread and addressed motor; a command line ends at <CR> (or <LF>) and
+**    is answered with the core's <CR>...<ACK> reply. Client IOCs connect
+**    with drvAsynIPPortConfigure("<port>", "<host>:<tcp port>") and an
+**    output EOS of "\r".
+**
+** Modification Log:
+** -----------------
+** .01 2026-10-19     Initial version.
+******************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <epicsThread.h>
+#include <osiSock.h>
+
+#include "pmacSimCore.h"
+
+#define MAX_LINE    1024
+#define MAX_REPLY   4096
+
+static const char *driverName = "pmacSimServer";
+
+static pmacSimCore *pmac_sim;
+
+typedef struct simClient
+{
+    pmacSimCore *core;
+    SOCKET sock;
+} simClient;
+
+extern "C" {
+
+static void simMotionThread(void *pPvt)
+{
+    ((pmacSimCore *) pPvt)->run();
+}
+
+
+/*****************************************************
+ * FUNCTION... simClientThread()
+ * USAGE...... Serve one client connection until it closes.
+ *
+ * LOGIC...
+ *  Accumulate received bytes into a line.
+ *  On <CR>, or on <LF> after a non-empty line, execute the line and send
+ *  the whole reply in one send(); lines longer than MAX_LINE are truncated.
+ *****************************************************/
+static void simClientThread(void *pPvt)
+{
+    simClient *pClient = (simClient *) pPvt;
+    char buffer[MAX_LINE];
+    char line[MAX_LINE];
+    char reply[MAX_REPLY];
+    int nread, i, len = 0, axis = 1, nreply, nsent, n;
+
+    while ((nread = recv(pClient->sock, buffer, sizeof(buffer), 0)) > 0)
+    {
+        for (i = 0; i < nread; i++)
+        {
+            if (buffer[i] == '\r' || (buffer[i] == '\n' && len > 0))
+            {
+                line[len] = '\0';
+                len = 0;
+                nreply = pClient->core->command(line, &axis, reply, MAX_REPLY);
+                for (nsent = 0; nsent < nreply; nsent += n)
+                    if ((n = send(pClient->sock, &reply[nsent], nreply - nsent, 0)) <= 0)
+                        break;
+            }
+            else if (buffer[i] != '\n' && len < MAX_LINE - 1)
+                line[len++] = buffer[i];
+        }
+    }
+    epicsSocketDestroy(pClient->sock);
+    free(pClient);
+}
+
+
+/* Accept connections and start a thread for each. */
+static void simListenThread(void *pPvt)
+{
+    SOCKET listenSock = *(SOCKET *) pPvt;
+    struct sockaddr_in addr;
+    osiSocklen_t addrlen;
+    simClient *pClient;
+    SOCKET sock;
+    char threadName[32];
+    int nclients = 0;
+
+    free(pPvt);
+    for (;;)
+    {
+        addrlen = sizeof(addr);
+        sock = epicsSocketAccept(listenSock, (struct sockaddr *) &addr, &addrlen);
+        if (sock == INVALID_SOCKET)
+        {
+            epicsThreadSleep(1.0);
+            continue;
+        }
+        pClient = (simClient *) malloc(sizeof(simClient));
+        pClient->core = pmac_sim;
+        pClient->sock = sock;
+        sprintf(threadName, "pmacSim%d", ++nclients);
+        epicsThreadCreate(threadName, epicsThreadPriorityMedium,
+                          epicsThreadGetStackSize(epicsThreadStackBig),
+                          simClientThread, pClient);
+    }
+}
+
+
+/*****************************************************
+ * FUNCTION... pmacSimConfig()
+ * USAGE...... Start the simulator core and its TCP server.
+ *
+ * LOGIC...
+ *  Create the core and its motion thread at rate Hz.
+ *  Listen on tcpPort on all interfaces.
+ *  Start the accept thread.
+ *****************************************************/
+int pmacSimConfig(int tcpPort, double rate)
+{
+    struct sockaddr_in addr;
+    SOCKET *pListen;
+
+    if (pmac_sim != NULL)
+    {
+        printf("%s: simulator already configured\n", driverName);
+        return(-1);
+    }
+    if (tcpPort <= 0 || tcpPort > 65535 || rate <= 0.0)
+    {
+        printf("%s: invalid TCP port %d or rate %g\n", driverName, tcpPort,
+               rate);
+        return(-1);
+    }
+    if (!osiSockAttach())
+        return(-1);
+
+    pListen = (SOCKET *) malloc(sizeof(SOCKET));
+    *pListen = epicsSocketCreate(AF_INET, SOCK_STREAM, 0);
+    if (*pListen == INVALID_SOCKET)
+    {
+        printf("%s: cannot create socket\n", driverName);
+        free(pListen);
+        return(-1);
+    }
+    epicsSocketEnableAddressReuseDuringTimeWaitState(*pListen);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((unsigned short) tcpPort);
+    if (bind(*pListen, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+        listen(*pListen, 10) != 0)
+    {
+        printf("%s: cannot listen on TCP port %d\n", driverName, tcpPort);
+        epicsSocketDestroy(*pListen);
+        free(pListen);
+        return(-1);
+    }
+
+    pmac_sim = new pmacSimCore(rate);
+    epicsThreadCreate("pmacSimMotion", epicsThreadPriorityHigh,
+                      epicsThreadGetStackSize(epicsThreadStackMedium),
+                      simMotionThread, pmac_sim);
+    epicsThreadCreate("pmacSimListen", epicsThreadPriorityMedium,
+                      epicsThreadGetStackSize(epicsThreadStackMedium),
+                      simListenThread, pListen);
+    return(0);
+}
+
+
+int pmacSimReport(void)
+{
+    if (pmac_sim == NULL)
+    {
+        printf("%s: simulator not configured\n", driverName);
+        return(-1);
+    }
+    pmac_sim->report();
+    return(0);
+}
+
+} // extern "C"
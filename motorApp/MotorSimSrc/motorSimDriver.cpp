@@ -35,6 +35,30 @@ December 13, 2009
 
 static const char *driverName = "motorSimDriver";
 
+/** Pushes the positions of the axes at the pulses from firstPulse to nextPulse_-1 for streaming,
+  * as a controller that gathers positions at each pulse would; see pushProfileReadbacks().
+  * The positions are those at the end of the current step.
+  * Called with the lock held from processProfile(). */
+void motorSimController::streamPulses(size_t firstPulse)
+{
+  double *readbacks = streamRow_;
+  double *errors = streamRow_ + numAxes_;
+  motorSimAxis *pAxis;
+  size_t pulse;
+  int axis;
+
+  if (!readbackRing_) return;
+  for (pulse=firstPulse; pulse<nextPulse_; pulse++) {
+    for (axis=0; axis<numAxes_; axis++) {
+      pAxis = getAxis(axis);
+      readbacks[axis] = pAxis->nextpoint_.axis[0].p + pAxis->enc_offset_;
+      errors[axis] = pAxis->profileMoving_ ?
+        readbacks[axis] - (pAxis->profilePulsePositions_[pulse] + pAxis->profileOrigin_) : 0.;
+    }
+    pushProfileReadbacks((int)pulse, 1, readbacks, errors);
+  }
+}
+
 static void motorSimTaskC(void *drvPvt);
 
 typedef struct motorSimControllerNode {
@@ -67,6 +91,8 @@ motorSimAxis::motorSimAxis(motorSimController *pController, int axis, double low
   nextpoint_.axis[0].p = start;
   route_ = routeNew( &(this->endpoint_), &pars );
   deferred_move_ = 0;
+  profileMoving_ = 0;
+  profileOrigin_ = 0.;
 }
 
 
@@ -95,10 +121,14 @@ motorSimController::motorSimController(const char *portName, int numAxes, int pr
   if (numAxes < 1 ) numAxes = 1;
   numAxes_ = numAxes;
   this->movesDeferred_ = 0;
+  profileState_ = PROFILE_EXECUTE_DONE;
+  nextPulse_ = 0;
+  streamRow_ = (double *)calloc(2*numAxes, sizeof(double));
   for (axis=0; axis<numAxes; axis++) {
     new motorSimAxis(this, axis, DEFAULT_LOW_LIMIT, DEFAULT_HI_LIMIT, DEFAULT_HOME, DEFAULT_START);
     setDoubleParam(axis, this->motorPosition_, DEFAULT_START);
   }
+  initializeProfile(SIM_MAX_PROFILE_POINTS);
 
   this->motorThread_ = epicsThreadCreate("motorSimThread", 
                                          epicsThreadPriorityLow,
@@ -232,6 +262,188 @@ asynStatus motorSimController::triggerProfile(asynUser *pasynUser)
   return asynError;
 }
 
+/** Starts a simulated profile move.
+  * The axes in the profile first move to the first profile point.  motorSimTask() then moves them
+  * along the profile, outputting the scheduled pulses; see processProfile().
+  * Uses the profile as it was built, in the execute slot.
+  * Called with the lock held from writeInt32(), with the execute slot selected. */
+asynStatus motorSimController::executeProfile()
+{
+  int numPoints, axis;
+  double travel, maxTravel = 0.;
+  motorSimAxis *pAxis;
+  static const char *functionName = "executeProfile";
+
+  if (profileState_ != PROFILE_EXECUTE_DONE) return asynError;
+  numPoints = numProfilePoints_;
+  if ((numPoints < 1) || ((size_t)numPoints > maxProfilePoints_)) {
+    endProfile(PROFILE_STATUS_FAILURE, "Profile has not been built");
+    return asynError;
+  }
+
+  pulseAxis_ = -1;
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = getAxis(axis);
+    if (!pAxis->builtUseAxis_) continue;
+    pAxis->profileOrigin_ = (builtMoveMode_ == PROFILE_MOVE_MODE_RELATIVE) ?
+                            pAxis->nextpoint_.axis[0].p + pAxis->enc_offset_ : 0.;
+    pAxis->endpoint_.axis[0].p = pAxis->profilePositions_[0] + pAxis->profileOrigin_ - pAxis->enc_offset_;
+    pAxis->endpoint_.axis[0].v = 0.0;
+    pAxis->reroute_ = ROUTE_NEW_ROUTE;
+    setIntegerParam(axis, motorStatusDone_, 0);
+    // Compare positions on the axis that moves furthest while pulses are output
+    if (numProfilePulses_ > 0) {
+      travel = fabs(pAxis->profilePulsePositions_[numProfilePulses_-1] - pAxis->profilePulsePositions_[0]);
+      if ((pulseAxis_ < 0) || (travel > maxTravel)) {
+        pulseAxis_ = axis;
+        maxTravel = travel;
+      }
+    }
+  }
+
+  executeNumPoints_ = numPoints;
+  profilePoint_ = 0;
+  profileTime_ = 0.;
+  segmentStart_ = 0.;
+  nextPulse_ = 0;
+  profileState_ = PROFILE_EXECUTE_MOVE_START;
+  setIntegerParam(profileExecuteState_, PROFILE_EXECUTE_MOVE_START);
+  setIntegerParam(profileExecuteStatus_, PROFILE_STATUS_UNDEFINED);
+  setStringParam(profileExecuteMessage_, " ");
+  setIntegerParam(profileCurrentPoint_, 0);
+  setProfileActualPulses(0);
+  asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+            "%s:%s: driver %s, %d points, %d pulses on axis %d\n",
+            driverName, functionName, this->portName, numPoints, (int)numProfilePulses_, pulseAxis_);
+  return asynSuccess;
+}
+
+/** Aborts a simulated profile move; the axes decelerate to a stop.
+  * Called with the lock held from writeInt32(). */
+asynStatus motorSimController::abortProfile()
+{
+  int axis;
+  motorSimAxis *pAxis;
+
+  if (profileState_ == PROFILE_EXECUTE_DONE) return asynSuccess;
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = getAxis(axis);
+    if (!pAxis->builtUseAxis_) continue;
+    pAxis->profileMoving_ = 0;
+    pAxis->stop(0.0);
+  }
+  endProfile(PROFILE_STATUS_ABORT, "Profile aborted");
+  return asynSuccess;
+}
+
+/** Ends a simulated profile move, reporting the pulses that were output. */
+void motorSimController::endProfile(int status, const char *message)
+{
+  profileState_ = PROFILE_EXECUTE_DONE;
+  setIntegerParam(profileExecuteState_, PROFILE_EXECUTE_DONE);
+  setIntegerParam(profileExecuteStatus_, status);
+  setStringParam(profileExecuteMessage_, message);
+  setIntegerParam(profileExecute_, 0);
+  setProfileActualPulses(nextPulse_);
+}
+
+/** Advances the simulated profile move by delta seconds.
+  * The axes follow the straight lines between the profile points exactly.
+  * A pulse is output when its time is reached (PROFILE_PULSE_MODE_TIME), or when the compared
+  * axis passes its pulse position (PROFILE_PULSE_MODE_POSITION).  Its actual time is found by
+  * interpolating between the previous and the new position, so in position mode it shows
+  * where the path of the axis differs from the schedule.
+  * Called with the lock held from motorSimTask(). */
+void motorSimController::processProfile(double delta)
+{
+  int axis, done;
+  size_t firstPulse;
+  double lastTime, fraction, position, lastPosition = 0., target;
+  double *positions;
+  motorSimAxis *pAxis;
+
+  if (profileState_ == PROFILE_EXECUTE_MOVE_START) {
+    for (axis=0, done=1; axis<numAxes_; axis++) {
+      pAxis = getAxis(axis);
+      if (pAxis->builtUseAxis_ && ((pAxis->nextpoint_.axis[0].v != 0) ||
+                      (pAxis->nextpoint_.axis[0].p != pAxis->endpoint_.axis[0].p))) done = 0;
+    }
+    if (!done) return;
+    for (axis=0; axis<numAxes_; axis++) {
+      pAxis = getAxis(axis);
+      pAxis->profileMoving_ = pAxis->builtUseAxis_;
+    }
+    profileState_ = PROFILE_EXECUTE_EXECUTING;
+    setIntegerParam(profileExecuteState_, PROFILE_EXECUTE_EXECUTING);
+    callParamCallbacks();
+    return;
+  }
+  if (profileState_ != PROFILE_EXECUTE_EXECUTING) return;
+
+  lastTime = profileTime_;
+  profileTime_ += delta;
+  while ((profilePoint_ < executeNumPoints_-1) &&
+         (profileTime_ >= segmentStart_ + profileTimes_[profilePoint_])) {
+    segmentStart_ += profileTimes_[profilePoint_];
+    profilePoint_++;
+  }
+  fraction = ((profilePoint_ < executeNumPoints_-1) && (profileTimes_[profilePoint_] > 0.)) ?
+             (profileTime_ - segmentStart_) / profileTimes_[profilePoint_] : 0.;
+
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = getAxis(axis);
+    if (!pAxis->profileMoving_) continue;
+    positions = pAxis->profilePositions_;
+    position = positions[profilePoint_] + pAxis->profileOrigin_;
+    if (fraction > 0.) position += fraction*(positions[profilePoint_+1] - positions[profilePoint_]);
+    if (axis == pulseAxis_) lastPosition = pAxis->nextpoint_.axis[0].p + pAxis->enc_offset_;
+    pAxis->nextpoint_.axis[0].v = (position - (pAxis->nextpoint_.axis[0].p + pAxis->enc_offset_)) / delta;
+    pAxis->nextpoint_.axis[0].p = position - pAxis->enc_offset_;
+    if ((pAxis->nextpoint_.axis[0].p > pAxis->hiHardLimit_) ||
+        (pAxis->nextpoint_.axis[0].p < pAxis->lowHardLimit_)) {
+      abortProfile();
+      setStringParam(profileExecuteMessage_, "Axis hit a hard limit");
+      setIntegerParam(profileExecuteStatus_, PROFILE_STATUS_FAILURE);
+      callParamCallbacks();
+      return;
+    }
+  }
+
+  firstPulse = nextPulse_;
+  if ((builtPulseMode_ == PROFILE_PULSE_MODE_POSITION) && (pulseAxis_ >= 0)) {
+    pAxis = getAxis(pulseAxis_);
+    position = pAxis->nextpoint_.axis[0].p + pAxis->enc_offset_;
+    while (nextPulse_ < numProfilePulses_) {
+      target = pAxis->profilePulsePositions_[nextPulse_] + pAxis->profileOrigin_;
+      if ((lastPosition - target) * (position - target) > 0.) break;
+      fraction = (position != lastPosition) ? (target - lastPosition) / (position - lastPosition) : 0.;
+      actualPulseTimes_[nextPulse_++] = lastTime + fraction*delta;
+    }
+  } else {
+    while ((nextPulse_ < numProfilePulses_) && (pulseTimes_[nextPulse_] <= profileTime_)) {
+      actualPulseTimes_[nextPulse_] = pulseTimes_[nextPulse_];
+      nextPulse_++;
+    }
+  }
+  streamPulses(firstPulse);
+  setIntegerParam(profileActualPulses_, (int)nextPulse_);
+  setIntegerParam(profileCurrentPoint_, profilePoint_+1);
+
+  if (profilePoint_ >= executeNumPoints_-1) {
+    for (axis=0; axis<numAxes_; axis++) {
+      pAxis = getAxis(axis);
+      if (!pAxis->profileMoving_) continue;
+      pAxis->profileMoving_ = 0;
+      pAxis->nextpoint_.axis[0].v = 0.0;
+      pAxis->endpoint_.axis[0].p = pAxis->nextpoint_.axis[0].p;
+      pAxis->endpoint_.axis[0].v = 0.0;
+      pAxis->reroute_ = ROUTE_NEW_ROUTE;
+    }
+    endProfile(PROFILE_STATUS_SUCCESS, " ");
+  }
+  callParamCallbacks();
+}
+
 static void motorSimTaskC(void *drvPvt)
 {
   motorSimController *pController = (motorSimController*)drvPvt;
@@ -244,7 +456,7 @@ void motorSimController::motorSimTask()
 {
   epicsTimeStamp now;
   double delta;
-  int axis;
+  int axis, slot;
   motorSimAxis *pAxis;
 
   while ( 1 )
@@ -257,6 +469,11 @@ void motorSimController::motorSimTask()
     if ( delta > (DELTA/4.0) && delta <= (4.0*DELTA) )
     {
       /* A reasonable time has elapsed, it's not a time step in the clock */
+      this->lock();
+      slot = selectExecuteSlot();
+      processProfile(delta);
+      selectProfileSlot(slot);
+      this->unlock();
       for (axis=0; axis<numAxes_; axis++) 
       {     
         this->lock();
@@ -396,9 +613,12 @@ void motorSimAxis::process(double delta )
 
   lastpos = nextpoint_.axis[0].p;
   nextpoint_.T += delta;
-  routeFind( route_, reroute_, &endpoint_, &nextpoint_ );
-  /*  if (reroute_ == ROUTE_NEW_ROUTE) routePrint( route_, reroute_, &endpoint_, &nextpoint_, stdout ); */
-  reroute_ = ROUTE_CALC_ROUTE;
+  /* An axis in a profile move is moved by motorSimController::processProfile() */
+  if (!profileMoving_) {
+    routeFind( route_, reroute_, &endpoint_, &nextpoint_ );
+    /*  if (reroute_ == ROUTE_NEW_ROUTE) routePrint( route_, reroute_, &endpoint_, &nextpoint_, stdout ); */
+    reroute_ = ROUTE_CALC_ROUTE;
+  }
 
   /* No, do a limits check */
   if (homing_ && 
@@ -431,7 +651,7 @@ void motorSimAxis::process(double delta )
     }
   }
 
-  if (nextpoint_.axis[0].v ==  0) {
+  if ((nextpoint_.axis[0].v ==  0) && !profileMoving_) {
     if (!deferred_move_) {
       if (!delayedDone_) {
 	done = 1;
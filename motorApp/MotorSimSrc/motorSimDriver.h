@@ -18,6 +18,7 @@ March 28, 2010
 #include "route.h"
 
 #define NUM_SIM_CONTROLLER_PARAMS 0
+#define SIM_MAX_PROFILE_POINTS    2048
 
 class epicsShareClass motorSimAxis : public asynMotorAxis
 {
@@ -55,6 +56,8 @@ private:
   double lastTimeSecs_;
   int delayedDone_;
   int lastDone_;
+  int profileMoving_;          /**< The controller is moving this axis along a profile */
+  double profileOrigin_;       /**< Position added to the profile positions; non-zero for relative profiles */
   
 friend class motorSimController;
 };
@@ -70,15 +73,28 @@ public:
   motorSimAxis* getAxis(int axisNo);
   asynStatus profileMove(asynUser *pasynUser, int npoints, double positions[], double times[], int relative, int trigger);
   asynStatus triggerProfile(asynUser *pasynUser);
+  asynStatus executeProfile();
+  asynStatus abortProfile();
 
   /* These are the functions that are new to this class */
   void motorSimTask();  // Should be pivate, but called from non-member function
 
 private:
   asynStatus processDeferredMoves();
+  void processProfile(double delta);
+  void endProfile(int status, const char *message);
+  void streamPulses(size_t firstPulse);
   epicsThreadId motorThread_;
   epicsTimeStamp prevTime_;
   int movesDeferred_;
+  int profileState_;           /**< ProfileExecuteState of the simulated profile */
+  int executeNumPoints_;       /**< Number of points in the executing profile */
+  int profilePoint_;           /**< Segment being executed, from point profilePoint_ to profilePoint_+1 */
+  double profileTime_;         /**< Time since the start of the executing profile */
+  double segmentStart_;        /**< Time of the start of segment profilePoint_ */
+  int pulseAxis_;              /**< Axis compared in PROFILE_PULSE_MODE_POSITION; -1 if none */
+  size_t nextPulse_;           /**< Next scheduled pulse to output */
+  double *streamRow_;          /**< Readbacks and following errors of one pulse for pushProfileReadbacks() */
   
 friend class motorSimAxis;
 };
@@ -0,0 +1,1230 @@
+/* asynKinematicController.cpp
+ *
+ * This file defines an asynMotorController whose axes are pseudo-axes computed
+ * from real axes on other asynMotorController ports.  See asynKinematicController.h.
+ *
+ * Configuration:
+ *   asynKinematicControllerCreate("KIN1", "rotation2D", 2, 2, "0 0 30", 100, 1000)
+ *   asynKinematicRealAxis("KIN1", 0, "MOTOR1", 0, 0)
+ *   asynKinematicRealAxis("KIN1", 1, "MOTOR1", 1, 0)
+ *   asynKinematicProfile("KIN1", 21)
+ * Each pseudo-axis is then loaded with the standard asyn motor record template.
+ *
+ * The pseudo-axis velocity and acceleration of a move (VELO, ACCL) set the time of
+ * the move in pseudo-axis space.  Each real axis is given the velocity that makes it
+ * arrive at the same time, so all real axes start and finish together; the move is
+ * stretched if the Jacobian shows that a real axis would exceed its maximum velocity
+ * (the last argument of asynKinematicRealAxis, in dial units/s, 0 for no limit).
+ * asynKinematicProfile executes each move as a profile move of numPoints points
+ * along the straight pseudo-axis path; all real axes must then be on one port whose
+ * driver supports profile moves.
+ *
+ * Built-in kinematics; parameters are separated by spaces or commas:
+ *   rotation2D  2 pseudo, 2 real; "x0 y0 theta"  rotation by theta degrees about (x0,y0)
+ *               (the transform of coordTrans2D.template).
+ *   sumDiff2D   2 pseudo, 2 real; "C D E"  SUM=(A*C+B*D)/(C+D), DIFF=(A-B)*E
+ *               (the transform of sumDiff2D.template).
+ *   linear      M pseudo, N real, M<=N; "a11 ... aMN b1 ... bM"  pseudo = A*real + b.
+ *               The inverse is the minimum change in the real positions.
+ * Other kinematics are added by calling asynKinematicsRegister() from a registrar.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdexcept>
+
+#include <epicsString.h>
+#include <ellLib.h>
+#include <iocsh.h>
+
+#include <asynPortDriver.h>
+#include <epicsExport.h>
+#define epicsExportSharedSymbols
+#include <shareLib.h>
+#include "motor.h"
+#include "asynKinematicController.h"
+
+static const char *driverName = "asynKinematicController";
+
+#define MAX_KINEMATIC_PARAMS 64
+
+/** Parses up to maxParams numbers separated by spaces or commas. Returns the number parsed. */
+static int parseParameters(const char *parameters, double *values, int maxParams)
+{
+  int n = 0;
+  const char *p = parameters;
+  char *end;
+
+  if (!p) return 0;
+  while (n < maxParams) {
+    while (*p == ' ' || *p == ',' || *p == '\t') p++;
+    if (*p == '\0') break;
+    values[n] = strtod(p, &end);
+    if (end == p) return -1;
+    n++;
+    p = end;
+  }
+  return n;
+}
+
+/** Solves the n x n system A x = b in place by Gaussian elimination with partial pivoting.
+  * The solution is returned in b. Returns -1 if A is singular. */
+static int solveLinear(int n, double *A, double *b)
+{
+  int i, j, k, pivot;
+  double tmp, factor;
+
+  for (k=0; k<n; k++) {
+    pivot = k;
+    for (i=k+1; i<n; i++)
+      if (fabs(A[i*n+k]) > fabs(A[pivot*n+k])) pivot = i;
+    if (fabs(A[pivot*n+k]) < 1e-12) return -1;
+    if (pivot != k) {
+      for (j=0; j<n; j++) {
+        tmp = A[k*n+j]; A[k*n+j] = A[pivot*n+j]; A[pivot*n+j] = tmp;
+      }
+      tmp = b[k]; b[k] = b[pivot]; b[pivot] = tmp;
+    }
+    for (i=k+1; i<n; i++) {
+      factor = A[i*n+k] / A[k*n+k];
+      for (j=k; j<n; j++) A[i*n+j] -= factor * A[k*n+j];
+      b[i] -= factor * b[k];
+    }
+  }
+  for (k=n-1; k>=0; k--) {
+    for (j=k+1; j<n; j++) b[k] -= A[k*n+j] * b[j];
+    b[k] /= A[k*n+k];
+  }
+  return 0;
+}
+
+
+asynKinematics::asynKinematics(int numPseudo, int numReal)
+  : numPseudo_(numPseudo), numReal_(numReal)
+{
+}
+
+asynKinematics::~asynKinematics()
+{
+}
+
+/** Computes the Jacobian of the inverse transform at pseudo, J[j*numPseudo+i] = d real[j] / d pseudo[i].
+  * This base class function uses central differences of inverse(); kinematics with
+  * an analytic Jacobian reimplement it. */
+asynStatus asynKinematics::jacobian(const double *pseudo, const double *realNow, double *J)
+{
+  double *p = (double *)calloc(numPseudo_, sizeof(double));
+  double *rPlus = (double *)calloc(numReal_, sizeof(double));
+  double *rMinus = (double *)calloc(numReal_, sizeof(double));
+  double h;
+  int i, j;
+  asynStatus status = asynSuccess;
+
+  memcpy(p, pseudo, numPseudo_*sizeof(double));
+  for (i=0; i<numPseudo_ && !status; i++) {
+    h = 1e-6 * ((fabs(pseudo[i]) > 1.) ? fabs(pseudo[i]) : 1.);
+    p[i] = pseudo[i] + h;
+    status = inverse(p, realNow, rPlus);
+    p[i] = pseudo[i] - h;
+    if (!status) status = inverse(p, realNow, rMinus);
+    p[i] = pseudo[i];
+    for (j=0; j<numReal_; j++) J[j*numPseudo_+i] = (rPlus[j] - rMinus[j]) / (2.*h);
+  }
+  free(p);
+  free(rPlus);
+  free(rMinus);
+  return status;
+}
+
+void asynKinematics::report(FILE *fp, int details)
+{
+  fprintf(fp, "  kinematics numPseudo=%d, numReal=%d\n", numPseudo_, numReal_);
+}
+
+
+/** Rotation of the (X,Y) plane by theta about (x0,y0). */
+class rotation2DKinematics : public asynKinematics {
+public:
+  rotation2DKinematics(double x0, double y0, double theta)
+    : asynKinematics(2, 2), x0_(x0), y0_(y0), theta_(theta),
+      sin_(sin(theta*M_PI/180.)), cos_(cos(theta*M_PI/180.)) {}
+  asynStatus forward(const double *real, double *pseudo)
+  {
+    pseudo[0] = (real[1]-y0_)*sin_ + (real[0]-x0_)*cos_;
+    pseudo[1] = (real[1]-y0_)*cos_ - (real[0]-x0_)*sin_;
+    return asynSuccess;
+  }
+  asynStatus inverse(const double *pseudo, const double *realNow, double *real)
+  {
+    real[0] = x0_ + pseudo[0]*cos_ - pseudo[1]*sin_;
+    real[1] = y0_ + pseudo[0]*sin_ + pseudo[1]*cos_;
+    return asynSuccess;
+  }
+  asynStatus jacobian(const double *pseudo, const double *realNow, double *J)
+  {
+    J[0] = cos_;  J[1] = -sin_;
+    J[2] = sin_;  J[3] = cos_;
+    return asynSuccess;
+  }
+  void report(FILE *fp, int details)
+  {
+    fprintf(fp, "  rotation2D kinematics x0=%g, y0=%g, theta=%g\n", x0_, y0_, theta_);
+  }
+private:
+  double x0_, y0_, theta_, sin_, cos_;
+};
+
+static asynKinematics *rotation2DFactory(int numPseudo, int numReal, const char *parameters)
+{
+  double values[3] = {0., 0., 0.};
+
+  if ((numPseudo != 2) || (numReal != 2)) return NULL;
+  if (parseParameters(parameters, values, 3) < 0) return NULL;
+  return new rotation2DKinematics(values[0], values[1], values[2]);
+}
+
+
+/** Weighted sum and scaled difference of two real axes. */
+class sumDiff2DKinematics : public asynKinematics {
+public:
+  sumDiff2DKinematics(double C, double D, double E)
+    : asynKinematics(2, 2), C_(C), D_(D), E_(E), F_(C+D) {}
+  asynStatus forward(const double *real, double *pseudo)
+  {
+    pseudo[0] = (real[0]*C_ + real[1]*D_) / F_;
+    pseudo[1] = (real[0] - real[1]) * E_;
+    return asynSuccess;
+  }
+  asynStatus inverse(const double *pseudo, const double *realNow, double *real)
+  {
+    real[0] = pseudo[0] + pseudo[1]*D_/(E_*F_);
+    real[1] = pseudo[0] - pseudo[1]*C_/(E_*F_);
+    return asynSuccess;
+  }
+  asynStatus jacobian(const double *pseudo, const double *realNow, double *J)
+  {
+    J[0] = 1.;  J[1] = D_/(E_*F_);
+    J[2] = 1.;  J[3] = -C_/(E_*F_);
+    return asynSuccess;
+  }
+  void report(FILE *fp, int details)
+  {
+    fprintf(fp, "  sumDiff2D kinematics C=%g, D=%g, E=%g\n", C_, D_, E_);
+  }
+private:
+  double C_, D_, E_, F_;
+};
+
+static asynKinematics *sumDiff2DFactory(int numPseudo, int numReal, const char *parameters)
+{
+  double values[3] = {1., 1., 1.};
+
+  if ((numPseudo != 2) || (numReal != 2)) return NULL;
+  if (parseParameters(parameters, values, 3) < 0) return NULL;
+  if ((values[0] + values[1] == 0.) || (values[2] == 0.)) return NULL;
+  return new sumDiff2DKinematics(values[0], values[1], values[2]);
+}
+
+
+/** Linear transform pseudo = A*real + b. */
+class linearKinematics : public asynKinematics {
+public:
+  linearKinematics(int numPseudo, int numReal, const double *values)
+    : asynKinematics(numPseudo, numReal)
+  {
+    A_ = (double *)calloc(numPseudo*numReal, sizeof(double));
+    b_ = (double *)calloc(numPseudo, sizeof(double));
+    AAT_ = (double *)calloc(numPseudo*numPseudo, sizeof(double));
+    work_ = (double *)calloc(numPseudo, sizeof(double));
+    memcpy(A_, values, numPseudo*numReal*sizeof(double));
+    memcpy(b_, values + numPseudo*numReal, numPseudo*sizeof(double));
+  }
+  ~linearKinematics()
+  {
+    free(A_); free(b_); free(AAT_); free(work_);
+  }
+  asynStatus forward(const double *real, double *pseudo)
+  {
+    int i, j;
+    for (i=0; i<numPseudo_; i++) {
+      pseudo[i] = b_[i];
+      for (j=0; j<numReal_; j++) pseudo[i] += A_[i*numReal_+j] * real[j];
+    }
+    return asynSuccess;
+  }
+  /* real = realNow + A^T (A A^T)^-1 (pseudo - forward(realNow)) */
+  asynStatus inverse(const double *pseudo, const double *realNow, double *real)
+  {
+    int i, j, k;
+    forward(realNow, work_);
+    for (i=0; i<numPseudo_; i++) {
+      work_[i] = pseudo[i] - work_[i];
+      for (j=0; j<numPseudo_; j++) {
+        AAT_[i*numPseudo_+j] = 0.;
+        for (k=0; k<numReal_; k++) AAT_[i*numPseudo_+j] += A_[i*numReal_+k] * A_[j*numReal_+k];
+      }
+    }
+    if (solveLinear(numPseudo_, AAT_, work_)) return asynError;
+    for (j=0; j<numReal_; j++) {
+      real[j] = realNow[j];
+      for (i=0; i<numPseudo_; i++) real[j] += A_[i*numReal_+j] * work_[i];
+    }
+    return asynSuccess;
+  }
+  void report(FILE *fp, int details)
+  {
+    int i, j;
+    fprintf(fp, "  linear kinematics numPseudo=%d, numReal=%d\n", numPseudo_, numReal_);
+    if (details < 1) return;
+    for (i=0; i<numPseudo_; i++) {
+      fprintf(fp, "    pseudo %d =", i);
+      for (j=0; j<numReal_; j++) fprintf(fp, " %+g*real%d", A_[i*numReal_+j], j);
+      fprintf(fp, " %+g\n", b_[i]);
+    }
+  }
+private:
+  double *A_, *b_, *AAT_, *work_;
+};
+
+static asynKinematics *linearFactory(int numPseudo, int numReal, const char *parameters)
+{
+  double values[MAX_KINEMATIC_PARAMS];
+  int nvalues = numPseudo*numReal + numPseudo;
+
+  if ((numPseudo > numReal) || (nvalues > MAX_KINEMATIC_PARAMS)) return NULL;
+  if (parseParameters(parameters, values, MAX_KINEMATIC_PARAMS) != nvalues) return NULL;
+  return new linearKinematics(numPseudo, numReal, values);
+}
+
+
+typedef struct kinematicsNode {
+  ELLNODE node;
+  const char *name;
+  asynKinematicsFactory factory;
+} kinematicsNode;
+
+static ELLLIST kinematicsList;
+static int kinematicsListInitialized = 0;
+
+static void kinematicsListInit()
+{
+  if (kinematicsListInitialized) return;
+  kinematicsListInitialized = 1;
+  ellInit(&kinematicsList);
+  asynKinematicsRegister("rotation2D", rotation2DFactory);
+  asynKinematicsRegister("sumDiff2D",  sumDiff2DFactory);
+  asynKinematicsRegister("linear",     linearFactory);
+}
+
+/** Adds a named kinematics to the list available to asynKinematicControllerCreate.
+  * \param[in] name The name used in asynKinematicControllerCreate.
+  * \param[in] factory Function that creates the kinematics object. */
+int asynKinematicsRegister(const char *name, asynKinematicsFactory factory)
+{
+  kinematicsNode *pNode;
+
+  kinematicsListInit();
+  for (pNode = (kinematicsNode *)ellFirst(&kinematicsList); pNode;
+       pNode = (kinematicsNode *)ellNext(&pNode->node)) {
+    if (strcmp(pNode->name, name) == 0) {
+      pNode->factory = factory;
+      return 0;
+    }
+  }
+  pNode = (kinematicsNode *)calloc(1, sizeof(kinematicsNode));
+  pNode->name = epicsStrDup(name);
+  pNode->factory = factory;
+  ellAdd(&kinematicsList, &pNode->node);
+  return 0;
+}
+
+static asynKinematicsFactory findKinematics(const char *name)
+{
+  kinematicsNode *pNode;
+
+  kinematicsListInit();
+  for (pNode = (kinematicsNode *)ellFirst(&kinematicsList); pNode;
+       pNode = (kinematicsNode *)ellNext(&pNode->node)) {
+    if (strcmp(pNode->name, name) == 0) return pNode->factory;
+  }
+  return NULL;
+}
+
+
+/** Creates the asyn clients for one axis of a real asynMotorController port.
+  * The asyn client constructors throw std::runtime_error if the port or parameter does not exist. */
+kinematicRealAxis::kinematicRealAxis(const char *portName, int axisNo)
+  : portName_(epicsStrDup(portName)), axisNo_(axisNo), resolution_(1.), position_(0.), maxVelocity_(0.),
+    moveAbs_(0), velBase_(0), velocity_(0), accel_(0), highLimit_(0), lowLimit_(0), recResolution_(0),
+    recOffset_(0), recDirection_(0), stop_(0), motorStatus_(0), profileUseAxis_(0), profilePositions_(0)
+{
+  memset(&status_, 0, sizeof(status_));
+  try {
+    moveAbs_          = new asynFloat64Client(portName, axisNo, motorMoveAbsString);
+    velBase_          = new asynFloat64Client(portName, axisNo, motorVelBaseString);
+    velocity_         = new asynFloat64Client(portName, axisNo, motorVelocityString);
+    accel_            = new asynFloat64Client(portName, axisNo, motorAccelString);
+    highLimit_        = new asynFloat64Client(portName, axisNo, motorHighLimitString);
+    lowLimit_         = new asynFloat64Client(portName, axisNo, motorLowLimitString);
+    recResolution_    = new asynFloat64Client(portName, axisNo, motorRecResolutionString);
+    recOffset_        = new asynFloat64Client(portName, axisNo, motorRecOffsetString);
+    recDirection_     = new asynInt32Client(portName, axisNo, motorRecDirectionString);
+    stop_             = new asynInt32Client(portName, axisNo, motorStopString);
+    motorStatus_      = new asynGenericPointerClient(portName, axisNo, motorStatusString);
+    profileUseAxis_   = new asynInt32Client(portName, axisNo, profileUseAxisString);
+    profilePositions_ = new asynFloat64ArrayClient(portName, axisNo, profilePositionsString);
+  }
+  catch (...) {
+    deleteClients();
+    free(portName_);
+    throw;
+  }
+}
+
+kinematicRealAxis::~kinematicRealAxis()
+{
+  deleteClients();
+  free(portName_);
+}
+
+/** Deletes the asyn clients; used by the destructor and when the constructor fails. */
+void kinematicRealAxis::deleteClients()
+{
+  delete moveAbs_;
+  delete velBase_;
+  delete velocity_;
+  delete accel_;
+  delete highLimit_;
+  delete lowLimit_;
+  delete recResolution_;
+  delete recOffset_;
+  delete recDirection_;
+  delete stop_;
+  delete motorStatus_;
+  delete profileUseAxis_;
+  delete profilePositions_;
+}
+
+/** Reads the MotorStatus of the real axis and converts its position to dial units. */
+asynStatus kinematicRealAxis::readStatus()
+{
+  asynStatus status;
+
+  status = motorStatus_->read(&status_);
+  if (status) return status;
+  position_ = status_.position * resolution_;
+  return asynSuccess;
+}
+
+/** Reads the motor record resolution the real axis was given by devMotorAsyn. */
+asynStatus kinematicRealAxis::readResolution()
+{
+  double resolution;
+  asynStatus status;
+
+  status = recResolution_->read(&resolution);
+  if (status) return status;
+  if (resolution != 0.) resolution_ = resolution;
+  return asynSuccess;
+}
+
+/** Moves the real axis; the velocities and acceleration are in dial units and are
+  * only written if maxVelocity is non-zero, otherwise those of the last move are used. */
+asynStatus kinematicRealAxis::moveTo(double dialPosition, double minVelocity, double maxVelocity, double acceleration)
+{
+  double scale = 1. / fabs(resolution_);
+  int status = 0;
+
+  if (maxVelocity > 0.) {
+    status |= velBase_->write(minVelocity * scale);
+    status |= velocity_->write(maxVelocity * scale);
+    if (acceleration > 0.) status |= accel_->write(acceleration * scale);
+  }
+  status |= moveAbs_->write(dialPosition / resolution_);
+  return status ? asynError : asynSuccess;
+}
+
+/** Returns true if dialPosition is within the soft limits of the real axis.
+  * devMotorAsyn keeps motorHighLimit and motorLowLimit in step with the motor record DHLM
+  * and DLLM, in raw units; there are no limits if both are 0 or they cannot be read. */
+bool kinematicRealAxis::withinLimits(double dialPosition)
+{
+  double highLimit, lowLimit;
+  double raw = dialPosition / resolution_;
+
+  if (highLimit_->read(&highLimit) || lowLimit_->read(&lowLimit)) return true;
+  if ((highLimit == 0.) && (lowLimit == 0.)) return true;
+  return (raw >= lowLimit) && (raw <= highLimit);
+}
+
+asynStatus kinematicRealAxis::stop()
+{
+  return stop_->write(1);
+}
+
+/** Defines the profile positions of the real axis. The real controller takes profile
+  * positions in user units, so the dial positions are converted with the motor record
+  * direction and offset. */
+asynStatus kinematicRealAxis::defineProfile(const double *dialPositions, size_t numPoints)
+{
+  double *user;
+  double offset;
+  epicsInt32 direction;
+  size_t i;
+  int status = 0;
+
+  status |= recOffset_->read(&offset);
+  status |= recDirection_->read(&direction);
+  if (status) return asynError;
+  user = (double *)calloc(numPoints, sizeof(double));
+  for (i=0; i<numPoints; i++) {
+    user[i] = offset + (direction ? -dialPositions[i] : dialPositions[i]);
+  }
+  status |= profileUseAxis_->write(1);
+  status |= profilePositions_->write(user, numPoints);
+  free(user);
+  return status ? asynError : asynSuccess;
+}
+
+
+/** Creates the asyn clients for the profile-move parameters of a real controller. */
+kinematicProfile::kinematicProfile(const char *portName, int numPoints, int numReal)
+  : numPoints_(numPoints), positions_(0),
+    numPointsClient_(0), timeMode_(0), moveMode_(0), fixedTime_(0), acceleration_(0),
+    build_(0), buildStatus_(0), execute_(0), executeState_(0), abort_(0)
+{
+  try {
+    numPointsClient_ = new asynInt32Client(portName, 0, profileNumPointsString);
+    timeMode_        = new asynInt32Client(portName, 0, profileTimeModeString);
+    moveMode_        = new asynInt32Client(portName, 0, profileMoveModeString);
+    fixedTime_       = new asynFloat64Client(portName, 0, profileFixedTimeString);
+    acceleration_    = new asynFloat64Client(portName, 0, profileAccelerationString);
+    build_           = new asynInt32Client(portName, 0, profileBuildString);
+    buildStatus_     = new asynInt32Client(portName, 0, profileBuildStatusString);
+    execute_         = new asynInt32Client(portName, 0, profileExecuteString);
+    executeState_    = new asynInt32Client(portName, 0, profileExecuteStateString);
+    abort_           = new asynInt32Client(portName, 0, profileAbortString);
+  }
+  catch (...) {
+    deleteClients();
+    throw;
+  }
+  positions_ = (double *)calloc(numReal*numPoints, sizeof(double));
+}
+
+kinematicProfile::~kinematicProfile()
+{
+  deleteClients();
+  free(positions_);
+}
+
+/** Deletes the asyn clients; used by the destructor and when the constructor fails. */
+void kinematicProfile::deleteClients()
+{
+  delete numPointsClient_;
+  delete timeMode_;
+  delete moveMode_;
+  delete fixedTime_;
+  delete acceleration_;
+  delete build_;
+  delete buildStatus_;
+  delete execute_;
+  delete executeState_;
+  delete abort_;
+}
+
+/** Builds and executes the profile; the positions have already been defined on each real axis. */
+asynStatus kinematicProfile::start(double fixedTime, double accelerationTime)
+{
+  epicsInt32 buildStatus;
+  int status = 0;
+
+  status |= numPointsClient_->write(numPoints_);
+  status |= timeMode_->write(PROFILE_TIME_MODE_FIXED);
+  status |= moveMode_->write(PROFILE_MOVE_MODE_ABSOLUTE);
+  status |= fixedTime_->write(fixedTime);
+  status |= acceleration_->write(accelerationTime);
+  if (status) return asynError;
+  if (build_->write(1)) return asynError;
+  if (buildStatus_->read(&buildStatus)) return asynError;
+  if (buildStatus == PROFILE_STATUS_FAILURE) return asynError;
+  return execute_->write(1);
+}
+
+asynStatus kinematicProfile::readExecuteState(int *state)
+{
+  epicsInt32 value;
+  asynStatus status;
+
+  status = executeState_->read(&value);
+  *state = value;
+  return status;
+}
+
+asynStatus kinematicProfile::abort()
+{
+  return abort_->write(1);
+}
+
+
+/** Creates a new asynKinematicController object.
+  * \param[in] portName         The name of the asyn port that will be created for this driver
+  * \param[in] numPseudo        The number of pseudo-axes; the axes of this controller
+  * \param[in] numReal          The number of real axes, configured with asynKinematicRealAxis
+  * \param[in] pKinematics      The forward and inverse kinematics
+  * \param[in] movingPollPeriod The time between polls when any axis is moving
+  * \param[in] idlePollPeriod   The time between polls when no axis is moving
+  */
+asynKinematicController::asynKinematicController(const char *portName, int numPseudo, int numReal,
+                                                 asynKinematics *pKinematics,
+                                                 double movingPollPeriod, double idlePollPeriod)
+  :  asynMotorController(portName, numPseudo, 0,
+                         0, // No additional interfaces beyond those in base class
+                         0, // No additional callback interfaces beyond those in base class
+                         ASYN_CANBLOCK | ASYN_MULTIDEVICE,
+                         1, // autoconnect
+                         0, 0), // Default priority and stack size
+    pKinematics_(pKinematics), numReal_(numReal), pProfile_(0), profileActive_(false), realDone_(true),
+    realProblem_(false), realCommsError_(false), movesDeferred_(false)
+{
+  int axis;
+
+  pReal_           = (kinematicRealAxis **)calloc(numReal, sizeof(kinematicRealAxis *));
+  realPositions_   = (double *)calloc(numReal, sizeof(double));
+  realTargets_     = (double *)calloc(numReal, sizeof(double));
+  pseudoPositions_ = (double *)calloc(numPseudo, sizeof(double));
+  pseudoTargets_   = (double *)calloc(numPseudo, sizeof(double));
+  jacobian_        = (double *)calloc(numReal*numPseudo, sizeof(double));
+  realVelocities_  = (double *)calloc(numReal, sizeof(double));
+
+  for (axis=0; axis<numPseudo; axis++) {
+    new asynKinematicAxis(this, axis);
+  }
+
+  startPoller(movingPollPeriod, idlePollPeriod, 2);
+}
+
+/** Connects a real axis of this controller to an axis on an asynMotorController port.
+  * \param[in] index    The index of the real axis in the kinematics (0 to numReal-1)
+  * \param[in] realPort The asyn port of the real motor controller
+  * \param[in] realAxis The axis number on realPort
+  * \param[in] maxVelocity The maximum velocity of the real axis in dial units/s; 0 for no limit
+  */
+asynStatus asynKinematicController::configRealAxis(int index, const char *realPort, int realAxis, double maxVelocity)
+{
+  kinematicRealAxis *pReal;
+  static const char *functionName = "configRealAxis";
+
+  if ((index < 0) || (index >= numReal_)) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: port %s real axis index %d out of range\n",
+      driverName, functionName, portName, index);
+    return asynError;
+  }
+  try {
+    pReal = new kinematicRealAxis(realPort, realAxis);
+  }
+  catch (std::exception &e) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: port %s cannot connect to %s axis %d: %s\n",
+      driverName, functionName, portName, realPort, realAxis, e.what());
+    return asynError;
+  }
+  pReal->maxVelocity_ = fabs(maxVelocity);
+  lock();
+  delete pReal_[index];
+  pReal_[index] = pReal;
+  unlock();
+  return asynSuccess;
+}
+
+/** Executes pseudo-axis moves as profile moves on the real controller.
+  * \param[in] numPoints The number of points along the pseudo-axis path; 0 to use independent real-axis moves
+  */
+asynStatus asynKinematicController::configProfile(int numPoints)
+{
+  kinematicProfile *pProfile = 0;
+  int i;
+  static const char *functionName = "configProfile";
+
+  if (numPoints >= 2) {
+    for (i=0; i<numReal_; i++) {
+      if (!pReal_[i] || strcmp(pReal_[i]->portName_, pReal_[0]->portName_)) {
+        asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+          "%s:%s: port %s all real axes must be configured on one port for profile moves\n",
+          driverName, functionName, portName);
+        return asynError;
+      }
+    }
+    try {
+      pProfile = new kinematicProfile(pReal_[0]->portName_, numPoints, numReal_);
+    }
+    catch (std::exception &e) {
+      asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+        "%s:%s: port %s cannot connect to profile parameters of %s: %s\n",
+        driverName, functionName, portName, pReal_[0]->portName_, e.what());
+      return asynError;
+    }
+  }
+  lock();
+  delete pProfile_;
+  pProfile_ = pProfile;
+  profileActive_ = false;
+  unlock();
+  return asynSuccess;
+}
+
+/** Reports on status of the driver
+  * \param[in] fp The file pointer on which report information will be written
+  * \param[in] level The level of report detail desired
+  */
+void asynKinematicController::report(FILE *fp, int level)
+{
+  int i;
+
+  fprintf(fp, "Kinematic motor controller %s, numPseudo=%d, numReal=%d, moving poll period=%f, idle poll period=%f\n",
+    this->portName, numAxes_, numReal_, movingPollPeriod_, idlePollPeriod_);
+  pKinematics_->report(fp, level);
+  if (pProfile_)
+    fprintf(fp, "  profile moves with %d points, active=%d\n", pProfile_->numPoints_, profileActive_);
+  for (i=0; i<numReal_; i++) {
+    if (pReal_[i])
+      fprintf(fp, "  real axis %d: port %s axis %d, resolution=%g, max. velocity=%g, position=%f, status=0x%x\n",
+        i, pReal_[i]->portName_, pReal_[i]->axisNo_, pReal_[i]->resolution_, pReal_[i]->maxVelocity_,
+        realPositions_[i], pReal_[i]->status_.status);
+    else
+      fprintf(fp, "  real axis %d: not configured\n", i);
+  }
+
+  // Call the base class method
+  asynMotorController::report(fp, level);
+}
+
+/** Returns a pointer to an asynKinematicAxis object.
+  * Returns NULL if the axis number encoded in pasynUser is invalid.
+  * \param[in] pasynUser asynUser structure that encodes the axis index number. */
+asynKinematicAxis* asynKinematicController::getAxis(asynUser *pasynUser)
+{
+  return static_cast<asynKinematicAxis*>(asynMotorController::getAxis(pasynUser));
+}
+
+/** Returns a pointer to an asynKinematicAxis object.
+  * Returns NULL if the axis number encoded in pasynUser is invalid.
+  * \param[in] axisNo Axis index number. */
+asynKinematicAxis* asynKinematicController::getAxis(int axisNo)
+{
+  return static_cast<asynKinematicAxis*>(asynMotorController::getAxis(axisNo));
+}
+
+/** Reads all of the real axes and computes the pseudo-axis positions.
+  * realDone_ is set only if every real axis reports done. */
+asynStatus asynKinematicController::readReal()
+{
+  msta_field msta;
+  int i;
+  asynStatus status = asynSuccess;
+  static const char *functionName = "readReal";
+
+  realDone_ = true;
+  realProblem_ = false;
+  realCommsError_ = false;
+  for (i=0; i<numReal_; i++) {
+    if (!pReal_[i]) return asynError;
+    if (pReal_[i]->readStatus()) {
+      asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+        "%s:%s: port %s error reading %s axis %d\n",
+        driverName, functionName, portName, pReal_[i]->portName_, pReal_[i]->axisNo_);
+      realCommsError_ = true;
+      status = asynError;
+      continue;
+    }
+    realPositions_[i] = pReal_[i]->position_;
+    msta.All = pReal_[i]->status_.status;
+    if (!msta.Bits.RA_DONE) realDone_ = false;
+    if (msta.Bits.RA_PROBLEM) realProblem_ = true;
+    if (msta.Bits.CNTRL_COMM_ERR) realCommsError_ = true;
+  }
+  if (profileActive_) {
+    int state;
+    if (pProfile_->readExecuteState(&state)) {
+      realCommsError_ = true;
+      status = asynError;
+    } else if (state != PROFILE_EXECUTE_DONE) {
+      realDone_ = false;
+    } else {
+      profileActive_ = false;
+    }
+  }
+  if (status) return status;
+  return pKinematics_->forward(realPositions_, pseudoPositions_);
+}
+
+/** Computes the real-axis targets for the pending pseudo-axis targets and starts all real axes.
+  * Pseudo-axes that were not given a new target hold their target if they are moving,
+  * or their current position if they are not.
+  *
+  * The requested pseudo-axis with the longest move at its own velocity sets the cruise time.
+  * Each real axis gets the velocity that covers its distance in that time, so that all real
+  * axes arrive together. The Jacobian at the start, middle and end of the pseudo-axis path
+  * gives the peak real-axis velocities, and the move is stretched to keep them below
+  * the real-axis maximum velocities. */
+asynStatus asynKinematicController::moveReal()
+{
+  asynKinematicAxis *pAxis;
+  double cruiseTime = 0., accelerationTime = 0., baseRatio = 1., scale = 1.;
+  double distance, velocity, rate;
+  double *pseudoPath, *realPath;
+  int i, j, k;
+  asynStatus status;
+  static const char *functionName = "moveReal";
+
+  for (i=0; i<numReal_; i++) {
+    if (!pReal_[i]) return asynError;
+    pReal_[i]->readResolution();
+  }
+  status = readReal();
+  if (status) return status;
+  for (i=0; i<numAxes_; i++) {
+    pAxis = getAxis(i);
+    if (pAxis->moveRequested_ || pAxis->busy_) pseudoTargets_[i] = pAxis->target_;
+    else                                       pseudoTargets_[i] = pseudoPositions_[i];
+  }
+  status = pKinematics_->inverse(pseudoTargets_, realPositions_, realTargets_);
+  if (status) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: port %s no real-axis solution for the requested pseudo-axis positions\n",
+      driverName, functionName, portName);
+    for (i=0; i<numAxes_; i++) getAxis(i)->moveRequested_ = false;
+    return status;
+  }
+
+  /* Check every real target before any real axis is sent, so that a move that would take
+   * one of them past its soft limits leaves all of them where they are */
+  for (j=0; j<numReal_; j++) {
+    distance = fabs(realTargets_[j] - realPositions_[j]);
+    if (distance < 0.5*fabs(pReal_[j]->resolution_)) continue;
+    if (!pReal_[j]->withinLimits(realTargets_[j])) {
+      asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+        "%s:%s: port %s target %f of %s axis %d is outside its soft limits\n",
+        driverName, functionName, portName, realTargets_[j], pReal_[j]->portName_, pReal_[j]->axisNo_);
+      for (i=0; i<numAxes_; i++) {
+        pAxis = getAxis(i);
+        if (!pAxis->moveRequested_) continue;
+        pAxis->moveRequested_ = false;
+        pAxis->limitViolation_ = true;
+        setIntegerParam(i, motorStatusProblem_, 1);
+        callParamCallbacks(i);
+      }
+      return asynError;
+    }
+  }
+
+  for (i=0; i<numAxes_; i++) {
+    pAxis = getAxis(i);
+    if (!pAxis->moveRequested_ || (pAxis->maxVelocity_ <= 0.)) continue;
+    distance = fabs(pseudoTargets_[i] - pseudoPositions_[i]);
+    if (distance / pAxis->maxVelocity_ > cruiseTime) cruiseTime = distance / pAxis->maxVelocity_;
+    if ((pAxis->acceleration_ > 0.) && (pAxis->maxVelocity_ / pAxis->acceleration_ > accelerationTime))
+      accelerationTime = pAxis->maxVelocity_ / pAxis->acceleration_;
+    if (pAxis->minVelocity_ / pAxis->maxVelocity_ < baseRatio) baseRatio = pAxis->minVelocity_ / pAxis->maxVelocity_;
+  }
+
+  if (cruiseTime > 0.) {
+    pseudoPath = (double *)calloc(numAxes_, sizeof(double));
+    realPath = (double *)calloc(numReal_, sizeof(double));
+    memset(realVelocities_, 0, numReal_*sizeof(double));
+    for (k=0; k<3; k++) {
+      for (i=0; i<numAxes_; i++)
+        pseudoPath[i] = pseudoPositions_[i] + 0.5*k*(pseudoTargets_[i] - pseudoPositions_[i]);
+      for (j=0; j<numReal_; j++)
+        realPath[j] = realPositions_[j] + 0.5*k*(realTargets_[j] - realPositions_[j]);
+      if (pKinematics_->jacobian(pseudoPath, realPath, jacobian_)) continue;
+      for (j=0; j<numReal_; j++) {
+        rate = 0.;
+        for (i=0; i<numAxes_; i++)
+          rate += jacobian_[j*numAxes_+i] * (pseudoTargets_[i] - pseudoPositions_[i]);
+        rate = fabs(rate) / cruiseTime;
+        if (rate > realVelocities_[j]) realVelocities_[j] = rate;
+      }
+    }
+    free(pseudoPath);
+    free(realPath);
+    for (j=0; j<numReal_; j++) {
+      if ((pReal_[j]->maxVelocity_ > 0.) && (realVelocities_[j] / pReal_[j]->maxVelocity_ > scale))
+        scale = realVelocities_[j] / pReal_[j]->maxVelocity_;
+    }
+    if (scale > 1.) {
+      asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+        "%s:%s: port %s move stretched by %f to keep the real axes below their maximum velocity\n",
+        driverName, functionName, portName, scale);
+      cruiseTime *= scale;
+    }
+  }
+
+  if (pProfile_ && (cruiseTime > 0.)) {
+    status = moveRealProfile(cruiseTime, accelerationTime);
+  } else {
+    for (i=0; i<numReal_; i++) {
+      /* Skip real axes that would move by less than half a step */
+      distance = fabs(realTargets_[i] - realPositions_[i]);
+      if (distance < 0.5*fabs(pReal_[i]->resolution_)) continue;
+      /* The average rate, not the Jacobian-derived rate; see asynKinematicController.h */
+      velocity = (cruiseTime > 0.) ? distance / cruiseTime : 0.;
+      if (pReal_[i]->moveTo(realTargets_[i], velocity*baseRatio, velocity,
+                            (accelerationTime > 0.) ? velocity / accelerationTime : 0.)) {
+        asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+          "%s:%s: port %s error moving %s axis %d to %f\n",
+          driverName, functionName, portName, pReal_[i]->portName_, pReal_[i]->axisNo_, realTargets_[i]);
+        status = asynError;
+      }
+    }
+  }
+  for (i=0; i<numAxes_; i++) {
+    pAxis = getAxis(i);
+    if (pAxis->moveRequested_) {
+      pAxis->moveRequested_ = false;
+      pAxis->busy_ = true;
+    }
+  }
+  if (status) stopReal();
+  return status;
+}
+
+/** Executes the move as a profile move along the straight pseudo-axis path.
+  * \param[in] cruiseTime The time from the first to the last point
+  * \param[in] accelerationTime The time to accelerate before the first point and decelerate after the last */
+asynStatus asynKinematicController::moveRealProfile(double cruiseTime, double accelerationTime)
+{
+  int numPoints = pProfile_->numPoints_;
+  double *pseudoPath = (double *)calloc(numAxes_, sizeof(double));
+  double *realNow = (double *)calloc(numReal_, sizeof(double));
+  double s;
+  int i, j, k;
+  asynStatus status = asynSuccess;
+  static const char *functionName = "moveRealProfile";
+
+  memcpy(realNow, realPositions_, numReal_*sizeof(double));
+  for (k=0; k<numPoints && !status; k++) {
+    s = (double)k / (numPoints - 1);
+    for (i=0; i<numAxes_; i++)
+      pseudoPath[i] = pseudoPositions_[i] + s*(pseudoTargets_[i] - pseudoPositions_[i]);
+    status = pKinematics_->inverse(pseudoPath, realNow, realTargets_);
+    for (j=0; j<numReal_; j++) {
+      pProfile_->positions_[j*numPoints+k] = realTargets_[j];
+      realNow[j] = realTargets_[j];
+    }
+  }
+  free(pseudoPath);
+  free(realNow);
+  for (j=0; j<numReal_ && !status; j++) {
+    status = pReal_[j]->defineProfile(&pProfile_->positions_[j*numPoints], numPoints);
+  }
+  if (!status) status = pProfile_->start(cruiseTime / (numPoints - 1), accelerationTime);
+  if (status) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: port %s error building or executing the profile on %s\n",
+      driverName, functionName, portName, pReal_[0]->portName_);
+    return status;
+  }
+  profileActive_ = true;
+  return asynSuccess;
+}
+
+asynStatus asynKinematicController::stopReal()
+{
+  int i;
+  asynStatus status = asynSuccess;
+
+  if (profileActive_) {
+    if (pProfile_->abort()) status = asynError;
+    profileActive_ = false;
+  }
+
+  for (i=0; i<numReal_; i++) {
+    if (pReal_[i] && pReal_[i]->stop()) status = asynError;
+  }
+  for (i=0; i<numAxes_; i++) {
+    getAxis(i)->moveRequested_ = false;
+    getAxis(i)->busy_ = false;
+  }
+  return status;
+}
+
+/** Polls all of the real axes once per poll cycle; the pseudo-axis poll() functions
+  * then use the positions computed here. */
+asynStatus asynKinematicController::poll()
+{
+  return readReal();
+}
+
+/** Holds pseudo-axis moves while deferred, and dispatches them all as one set
+  * of real-axis moves when the deferral is released. */
+asynStatus asynKinematicController::setDeferredMoves(bool defer)
+{
+  int i;
+  bool pending = false;
+
+  movesDeferred_ = defer;
+  if (defer) return asynSuccess;
+  for (i=0; i<numAxes_; i++) {
+    if (getAxis(i)->moveRequested_) pending = true;
+  }
+  if (!pending) return asynSuccess;
+  wakeupPoller();
+  return moveReal();
+}
+
+
+/** Creates a new asynKinematicAxis object.
+  * \param[in] pC Pointer to the asynKinematicController to which this axis belongs.
+  * \param[in] axisNo Index number of this axis, range 0 to pC->numAxes_-1.
+  */
+asynKinematicAxis::asynKinematicAxis(asynKinematicController *pC, int axisNo)
+  : asynMotorAxis(pC, axisNo),
+    pC_(pC), offset_(0.), target_(0.), minVelocity_(0.), maxVelocity_(0.), acceleration_(0.),
+    moveRequested_(false), busy_(false), limitViolation_(false)
+{
+}
+
+/** Reports on status of the axis
+  * \param[in] fp The file pointer on which report information will be written
+  * \param[in] level The level of report detail desired
+  */
+void asynKinematicAxis::report(FILE *fp, int level)
+{
+  if (level > 0) {
+    fprintf(fp, "  pseudo axis %d\n"
+                "    position %f\n"
+                "    offset %f\n"
+                "    target %f, busy %d\n",
+            axisNo_, pC_->pseudoPositions_[axisNo_] + offset_, offset_, target_ + offset_, busy_);
+  }
+
+  // Call the base class method
+  asynMotorAxis::report(fp, level);
+}
+
+/** Returns the motor record resolution of this pseudo-axis, or 1 if it has not been set. */
+double asynKinematicAxis::resolution()
+{
+  double resolution = 0.;
+
+  pC_->getDoubleParam(axisNo_, pC_->motorRecResolution_, &resolution);
+  return (resolution == 0.) ? 1. : resolution;
+}
+
+asynStatus asynKinematicAxis::move(double position, int relative, double minVelocity, double maxVelocity, double acceleration)
+{
+  double res = resolution();
+  double target;
+  asynStatus status;
+
+  status = pC_->readReal();
+  if (status) return status;
+  if (relative) target = pC_->pseudoPositions_[axisNo_] + position*res;
+  else          target = position*res - offset_;
+  target_ = target;
+  minVelocity_ = fabs(minVelocity*res);
+  maxVelocity_ = fabs(maxVelocity*res);
+  acceleration_ = fabs(acceleration*res);
+  moveRequested_ = true;
+  limitViolation_ = false;
+  if (pC_->movesDeferred_) return asynSuccess;
+  return pC_->moveReal();
+}
+
+asynStatus asynKinematicAxis::moveVelocity(double minVelocity, double maxVelocity, double acceleration)
+{
+  static const char *functionName = "moveVelocity";
+
+  asynPrint(pasynUser_, ASYN_TRACE_ERROR,
+    "%s:%s: port %s axis %d jog is not supported on pseudo-axes\n",
+    driverName, functionName, pC_->portName, axisNo_);
+  return asynError;
+}
+
+asynStatus asynKinematicAxis::home(double minVelocity, double maxVelocity, double acceleration, int forwards)
+{
+  static const char *functionName = "home";
+
+  asynPrint(pasynUser_, ASYN_TRACE_ERROR,
+    "%s:%s: port %s axis %d home the real axes instead\n",
+    driverName, functionName, pC_->portName, axisNo_);
+  return asynError;
+}
+
+/** Stops all of the real axes; the pseudo-axes are coupled, so there is no partial stop. */
+asynStatus asynKinematicAxis::stop(double acceleration)
+{
+  return pC_->stopReal();
+}
+
+/** Redefines the position of this pseudo-axis by changing its offset; the real axes are not changed. */
+asynStatus asynKinematicAxis::setPosition(double position)
+{
+  offset_ = position*resolution() - pC_->pseudoPositions_[axisNo_];
+  setDoubleParam(pC_->motorPosition_, position);
+  setDoubleParam(pC_->motorEncoderPosition_, position);
+  callParamCallbacks();
+  return asynSuccess;
+}
+
+/** Polls the axis.
+  * The positions were computed from the real axes by asynKinematicController::poll();
+  * the pseudo-axis is done when all of the real axes are done.
+  * \param[out] moving A flag that is set indicating that the axis is moving (true) or done (false). */
+asynStatus asynKinematicAxis::poll(bool *moving)
+{
+  double position = (pC_->pseudoPositions_[axisNo_] + offset_) / resolution();
+  bool done = pC_->realDone_ && !moveRequested_;
+
+  if (done) busy_ = false;
+  setDoubleParam(pC_->motorPosition_, position);
+  setDoubleParam(pC_->motorEncoderPosition_, position);
+  setIntegerParam(pC_->motorStatusDone_, done);
+  setIntegerParam(pC_->motorStatusMoving_, !done);
+  setIntegerParam(pC_->motorStatusProblem_, pC_->realProblem_ || limitViolation_);
+  setIntegerParam(pC_->motorStatusCommsError_, pC_->realCommsError_);
+  callParamCallbacks();
+  *moving = !done;
+  return asynSuccess;
+}
+
+
+/** Creates a new asynKinematicController object.
+  * Configuration command, called directly or from iocsh
+  * \param[in] portName         The name of the asyn port that will be created for this driver
+  * \param[in] kinematics       The name of the kinematics, e.g. "rotation2D"
+  * \param[in] numPseudo        The number of pseudo-axes
+  * \param[in] numReal          The number of real axes
+  * \param[in] parameters       The kinematics parameters
+  * \param[in] movingPollPeriod The time in ms between polls when any axis is moving
+  * \param[in] idlePollPeriod   The time in ms between polls when no axis is moving
+  */
+extern "C" int asynKinematicControllerCreate(const char *portName, const char *kinematics,
+                                             int numPseudo, int numReal, const char *parameters,
+                                             int movingPollPeriod, int idlePollPeriod)
+{
+  asynKinematicsFactory factory;
+  asynKinematics *pKinematics;
+  static const char *functionName = "asynKinematicControllerCreate";
+
+  factory = findKinematics(kinematics);
+  if (!factory) {
+    printf("%s:%s: Error unknown kinematics %s\n", driverName, functionName, kinematics);
+    return asynError;
+  }
+  if ((numPseudo < 1) || (numReal < 1)) {
+    printf("%s:%s: Error numPseudo and numReal must be positive\n", driverName, functionName);
+    return asynError;
+  }
+  pKinematics = factory(numPseudo, numReal, parameters);
+  if (!pKinematics) {
+    printf("%s:%s: Error invalid parameters \"%s\" for %s kinematics with numPseudo=%d, numReal=%d\n",
+      driverName, functionName, parameters ? parameters : "", kinematics, numPseudo, numReal);
+    return asynError;
+  }
+  new asynKinematicController(portName, numPseudo, numReal, pKinematics,
+                              movingPollPeriod/1000., idlePollPeriod/1000.);
+  return asynSuccess;
+}
+
+/** Connects a real axis of an asynKinematicController.
+  * Configuration command, called directly or from iocsh
+  * \param[in] portName The name of the asynKinematicController port
+  * \param[in] index    The index of the real axis in the kinematics
+  * \param[in] realPort The asyn port of the real motor controller
+  * \param[in] realAxis The axis number on realPort
+  * \param[in] maxVelocity The maximum velocity of the real axis in dial units/s; 0 for no limit
+  */
+extern "C" int asynKinematicRealAxis(const char *portName, int index, const char *realPort, int realAxis,
+                                     double maxVelocity)
+{
+  asynKinematicController *pC;
+  static const char *functionName = "asynKinematicRealAxis";
+
+  pC = (asynKinematicController*) findAsynPortDriver(portName);
+  if (!pC) {
+    printf("%s:%s: Error port %s not found\n", driverName, functionName, portName);
+    return asynError;
+  }
+  return pC->configRealAxis(index, realPort, realAxis, maxVelocity);
+}
+
+/** Executes the moves of an asynKinematicController as profile moves on the real controller.
+  * Configuration command, called directly or from iocsh; call after asynKinematicRealAxis.
+  * \param[in] portName The name of the asynKinematicController port
+  * \param[in] numPoints The number of profile points; 0 for independent real-axis moves
+  */
+extern "C" int asynKinematicProfile(const char *portName, int numPoints)
+{
+  asynKinematicController *pC;
+  static const char *functionName = "asynKinematicProfile";
+
+  pC = (asynKinematicController*) findAsynPortDriver(portName);
+  if (!pC) {
+    printf("%s:%s: Error port %s not found\n", driverName, functionName, portName);
+    return asynError;
+  }
+  return pC->configProfile(numPoints);
+}
+
+/** Code for iocsh registration */
+static const iocshArg asynKinematicControllerCreateArg0 = {"Port name", iocshArgString};
+static const iocshArg asynKinematicControllerCreateArg1 = {"Kinematics", iocshArgString};
+static const iocshArg asynKinematicControllerCreateArg2 = {"Number of pseudo-axes", iocshArgInt};
+static const iocshArg asynKinematicControllerCreateArg3 = {"Number of real axes", iocshArgInt};
+static const iocshArg asynKinematicControllerCreateArg4 = {"Kinematics parameters", iocshArgString};
+static const iocshArg asynKinematicControllerCreateArg5 = {"Moving poll period (ms)", iocshArgInt};
+static const iocshArg asynKinematicControllerCreateArg6 = {"Idle poll period (ms)", iocshArgInt};
+static const iocshArg * const asynKinematicControllerCreateArgs[] = {&asynKinematicControllerCreateArg0,
+                                                                     &asynKinematicControllerCreateArg1,
+                                                                     &asynKinematicControllerCreateArg2,
+                                                                     &asynKinematicControllerCreateArg3,
+                                                                     &asynKinematicControllerCreateArg4,
+                                                                     &asynKinematicControllerCreateArg5,
+                                                                     &asynKinematicControllerCreateArg6};
+static const iocshFuncDef asynKinematicControllerCreateDef = {"asynKinematicControllerCreate", 7,
+                                                              asynKinematicControllerCreateArgs};
+static void asynKinematicControllerCreateCallFunc(const iocshArgBuf *args)
+{
+  asynKinematicControllerCreate(args[0].sval, args[1].sval, args[2].ival, args[3].ival,
+                                args[4].sval, args[5].ival, args[6].ival);
+}
+
+static const iocshArg asynKinematicRealAxisArg0 = {"Port name", iocshArgString};
+static const iocshArg asynKinematicRealAxisArg1 = {"Real axis index", iocshArgInt};
+static const iocshArg asynKinematicRealAxisArg2 = {"Real port name", iocshArgString};
+static const iocshArg asynKinematicRealAxisArg3 = {"Real axis number", iocshArgInt};
+static const iocshArg asynKinematicRealAxisArg4 = {"Max. velocity (EGU/s)", iocshArgDouble};
+static const iocshArg * const asynKinematicRealAxisArgs[] = {&asynKinematicRealAxisArg0,
+                                                             &asynKinematicRealAxisArg1,
+                                                             &asynKinematicRealAxisArg2,
+                                                             &asynKinematicRealAxisArg3,
+                                                             &asynKinematicRealAxisArg4};
+static const iocshFuncDef asynKinematicRealAxisDef = {"asynKinematicRealAxis", 5, asynKinematicRealAxisArgs};
+static void asynKinematicRealAxisCallFunc(const iocshArgBuf *args)
+{
+  asynKinematicRealAxis(args[0].sval, args[1].ival, args[2].sval, args[3].ival, args[4].dval);
+}
+
+static const iocshArg asynKinematicProfileArg0 = {"Port name", iocshArgString};
+static const iocshArg asynKinematicProfileArg1 = {"Number of profile points", iocshArgInt};
+static const iocshArg * const asynKinematicProfileArgs[] = {&asynKinematicProfileArg0,
+                                                            &asynKinematicProfileArg1};
+static const iocshFuncDef asynKinematicProfileDef = {"asynKinematicProfile", 2, asynKinematicProfileArgs};
+static void asynKinematicProfileCallFunc(const iocshArgBuf *args)
+{
+  asynKinematicProfile(args[0].sval, args[1].ival);
+}
+
+static void asynKinematicControllerRegister(void)
+{
+  iocshRegister(&asynKinematicControllerCreateDef, asynKinematicControllerCreateCallFunc);
+  iocshRegister(&asynKinematicRealAxisDef,         asynKinematicRealAxisCallFunc);
+  iocshRegister(&asynKinematicProfileDef,          asynKinematicProfileCallFunc);
+}
+
+extern "C" {
+epicsExportRegistrar(asynKinematicControllerRegister);
+}
@@ -0,0 +1,184 @@
+/* asynKinematicController.h
+ *
+ * This file defines an asynMotorController whose axes are pseudo-axes.  The
+ * positions of the pseudo-axes are computed from the positions of real axes on
+ * other asynMotorController ports by compiled forward and inverse kinematics.
+ * It replaces the coordTrans2D, sumDiff2D and pseudoMotor database chains with
+ * a single driver: a pseudo-axis move is one call that dispatches all of the
+ * real-axis moves, and the pseudo-axis readbacks are updated on every poll.
+ * Each real axis is given the velocity distance/cruiseTime, so that all real axes
+ * start and finish together; this is a simplification, as a point-to-point move of the
+ * real axes only follows a straight pseudo-axis path if the transform is linear.
+ * The Jacobian of the transform is only used to stretch cruiseTime until the peak rate
+ * of every real axis along that path is below its maximum velocity.  Optionally, the move
+ * is executed as a profile move on the real controller so that the pseudo-axis path is straight.
+ * A move is refused, and none of the real axes is sent, if any real target is outside
+ * the soft limits of its axis.
+ *
+ * Positions used by the kinematics are in dial coordinates; i.e., raw position
+ * times the motor record resolution (MRES) of each real and pseudo axis.
+ */
+#ifndef asynKinematicController_H
+#define asynKinematicController_H
+
+#include "asynMotorController.h"
+#include "asynMotorAxis.h"
+
+#ifdef __cplusplus
+#include <asynPortClient.h>
+
+/** Base class for the kinematics of an asynKinematicController.
+  * numPseudo pseudo-axis positions are a function of numReal real-axis positions. */
+class epicsShareClass asynKinematics {
+  public:
+  asynKinematics(int numPseudo, int numReal);
+  virtual ~asynKinematics();
+
+  /** Computes the pseudo-axis positions from the real-axis positions. */
+  virtual asynStatus forward(const double *real, double *pseudo) = 0;
+  /** Computes the real-axis positions that put the pseudo-axes at pseudo; realNow holds
+    * the current real-axis positions, for transforms that have more than one solution. */
+  virtual asynStatus inverse(const double *pseudo, const double *realNow, double *real) = 0;
+  virtual asynStatus jacobian(const double *pseudo, const double *realNow, double *J);
+  virtual void report(FILE *fp, int details);
+
+  int numPseudo_;
+  int numReal_;
+};
+
+/** Factory function for a named kinematics; parameters is the string passed to
+  * asynKinematicControllerCreate. Returns NULL if the parameters are not valid. */
+typedef asynKinematics *(*asynKinematicsFactory)(int numPseudo, int numReal, const char *parameters);
+
+/** Real axis of an asynKinematicController; an axis on another asynMotorController port. */
+class kinematicRealAxis {
+  public:
+  kinematicRealAxis(const char *portName, int axisNo);
+  ~kinematicRealAxis();
+  asynStatus readStatus();
+  asynStatus readResolution();
+  asynStatus moveTo(double dialPosition, double minVelocity, double maxVelocity, double acceleration);
+  bool withinLimits(double dialPosition);
+  asynStatus stop();
+  asynStatus defineProfile(const double *dialPositions, size_t numPoints);
+
+  char *portName_;
+  int axisNo_;
+  double resolution_;           /**< Motor record resolution (MRES) of the real axis */
+  double position_;             /**< Dial position from the last readStatus() */
+  double maxVelocity_;          /**< Maximum dial velocity; 0 if there is no limit */
+  MotorStatus status_;          /**< Status from the last readStatus() */
+
+  private:
+  void deleteClients();
+  asynFloat64Client *moveAbs_;
+  asynFloat64Client *velBase_;
+  asynFloat64Client *velocity_;
+  asynFloat64Client *accel_;
+  asynFloat64Client *highLimit_;
+  asynFloat64Client *lowLimit_;
+  asynFloat64Client *recResolution_;
+  asynFloat64Client *recOffset_;
+  asynInt32Client *recDirection_;
+  asynInt32Client *stop_;
+  asynGenericPointerClient *motorStatus_;
+  asynInt32Client *profileUseAxis_;
+  asynFloat64ArrayClient *profilePositions_;
+};
+
+/** Profile-move parameters of the real controller, used when all real axes are on one port. */
+class kinematicProfile {
+  public:
+  kinematicProfile(const char *portName, int numPoints, int numReal);
+  ~kinematicProfile();
+  asynStatus start(double fixedTime, double accelerationTime);
+  asynStatus readExecuteState(int *state);
+  asynStatus abort();
+
+  int numPoints_;
+  double *positions_;           /**< numReal x numPoints dial positions of the real axes */
+
+  private:
+  void deleteClients();
+  asynInt32Client *numPointsClient_;
+  asynInt32Client *timeMode_;
+  asynInt32Client *moveMode_;
+  asynFloat64Client *fixedTime_;
+  asynFloat64Client *acceleration_;
+  asynInt32Client *build_;
+  asynInt32Client *buildStatus_;
+  asynInt32Client *execute_;
+  asynInt32Client *executeState_;
+  asynInt32Client *abort_;
+};
+
+class epicsShareClass asynKinematicAxis : public asynMotorAxis
+{
+public:
+  asynKinematicAxis(class asynKinematicController *pC, int axisNo);
+  asynStatus move(double position, int relative, double minVelocity, double maxVelocity, double acceleration);
+  asynStatus moveVelocity(double minVelocity, double maxVelocity, double acceleration);
+  asynStatus home(double minVelocity, double maxVelocity, double acceleration, int forwards);
+  asynStatus stop(double acceleration);
+  asynStatus poll(bool *moving);
+  asynStatus setPosition(double position);
+  void report(FILE *fp, int details);
+
+private:
+  double resolution();
+  asynKinematicController *pC_;
+  double offset_;               /**< Added to the kinematic position; set by setPosition() */
+  double target_;               /**< Dial target, without offset_ */
+  double minVelocity_;          /**< Dial velocities and acceleration of the last move request */
+  double maxVelocity_;
+  double acceleration_;
+  bool moveRequested_;          /**< target_ is waiting to be dispatched */
+  bool busy_;                   /**< target_ has been dispatched and the real axes are moving */
+  bool limitViolation_;         /**< The last move was refused because a real target was outside its soft limits */
+
+friend class asynKinematicController;
+};
+
+class epicsShareClass asynKinematicController : public asynMotorController {
+public:
+  asynKinematicController(const char *portName, int numPseudo, int numReal, asynKinematics *pKinematics,
+                          double movingPollPeriod, double idlePollPeriod);
+  asynKinematicAxis* getAxis(asynUser *pasynUser);
+  asynKinematicAxis* getAxis(int axisNo);
+  asynStatus poll();
+  asynStatus setDeferredMoves(bool defer);
+  void report(FILE *fp, int level);
+
+  /* These are the functions that are new to this class */
+  asynStatus configRealAxis(int index, const char *realPort, int realAxis, double maxVelocity);
+  asynStatus configProfile(int numPoints);
+
+protected:
+  asynStatus readReal();
+  asynStatus moveReal();
+  asynStatus moveRealProfile(double cruiseTime, double accelerationTime);
+  asynStatus stopReal();
+
+  asynKinematics *pKinematics_;
+  int numReal_;
+  kinematicRealAxis **pReal_;
+  double *realPositions_;       /**< Dial positions of the real axes */
+  double *realTargets_;
+  double *pseudoPositions_;     /**< Kinematic (offset free) positions of the pseudo-axes */
+  double *pseudoTargets_;
+  double *jacobian_;            /**< numReal x numPseudo Jacobian of the inverse transform */
+  double *realVelocities_;
+  kinematicProfile *pProfile_;  /**< NULL unless moves are executed as profile moves */
+  bool profileActive_;
+  bool realDone_;               /**< All real axes are done */
+  bool realProblem_;
+  bool realCommsError_;
+  bool movesDeferred_;
+
+friend class asynKinematicAxis;
+};
+
+extern "C" epicsShareFunc int asynKinematicsRegister(const char *name, asynKinematicsFactory factory);
+
+#endif /* _cplusplus */
+#endif /* asynKinematicController_H */
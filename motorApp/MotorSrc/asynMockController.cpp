@@ -0,0 +1,359 @@
+/* asynMockController.cpp
+ *
+ * In-process loopback asynOctet port for testing and benchmarking asyn motor
+ * drivers.  See asynMockController.h.
+ *
+ * Configuration:
+ *   asynMockControllerConfig("MOCK1", "echo", "\r\n", 2.0, 0.5, 1)
+ * creates port MOCK1 whose replies arrive 2.0-2.5 ms after each write; the
+ * jitter sequence depends only on the seed, so runs are repeatable.  A driver
+ * is then created with MOCK1 in place of its serial or IP port.  An EOS
+ * interpose layer is installed on the port, so drivers set their input and
+ * output terminators exactly as they do for a real serial or IP port.
+ *
+ * A write is split at CR/LF into commands; every command is passed to the
+ * handler and the replies are concatenated into one reply to the write.
+ * A read with no pending reply waits for the asynUser timeout and returns
+ * asynTimeout, as a silent controller would.
+ *
+ * Built-in handlers:
+ *   echo   replies with each command followed by the parameter string
+ *          (escape sequences allowed; default "\r\n").
+ * Other handlers are added by calling asynMockHandlerRegister() from a registrar.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <epicsString.h>
+#include <epicsStdio.h>
+#include <epicsThread.h>
+#include <ellLib.h>
+#include <iocsh.h>
+
+#include <asynPortDriver.h>
+#include <asynOctet.h>
+#include <asynInterposeEos.h>
+#include <epicsExport.h>
+#define epicsExportSharedSymbols
+#include <shareLib.h>
+#include "asynMockController.h"
+
+#ifndef VERSION_INT
+#  define VERSION_INT(V,R,M,P) ( ((V)<<24) | ((R)<<16) | ((M)<<8) | (P))
+#endif
+
+#define MOTOR_ASYN_VERSION_INT VERSION_INT(ASYN_VERSION,ASYN_REVISION,ASYN_MODIFICATION,0)
+
+#define VERSION_INT_4_32 VERSION_INT(4,32,0,0)
+
+static const char *driverName = "asynMockController";
+
+#define MOCK_MAX_COMMAND 1024
+
+
+/** Handler that replies with each command followed by a fixed terminator. */
+class echoHandler : public asynMockHandler {
+  public:
+  echoHandler(const char *terminator) {
+    terminatorLen_ = epicsStrnRawFromEscaped(terminator_, sizeof(terminator_), terminator, strlen(terminator));
+  }
+  int command(const char *command, char *reply, int maxReply) {
+    int len = strlen(command);
+    if (len + terminatorLen_ >= maxReply) return 0;
+    memcpy(reply, command, len);
+    memcpy(reply + len, terminator_, terminatorLen_);
+    return len + terminatorLen_;
+  }
+  private:
+  char terminator_[16];
+  int terminatorLen_;
+};
+
+static asynMockHandler *echoFactory(const char *parameters)
+{
+  return new echoHandler((parameters && *parameters) ? parameters : "\\r\\n");
+}
+
+
+typedef struct mockHandlerNode {
+  ELLNODE node;
+  const char *name;
+  asynMockHandlerFactory factory;
+} mockHandlerNode;
+
+static ELLLIST mockHandlerList;
+static int mockHandlerListInitialized = 0;
+
+static void mockHandlerListInit()
+{
+  if (mockHandlerListInitialized) return;
+  mockHandlerListInitialized = 1;
+  ellInit(&mockHandlerList);
+  asynMockHandlerRegister("echo", echoFactory);
+}
+
+/** Adds a named handler to the list available to asynMockControllerConfig.
+  * \param[in] name The controller type used in asynMockControllerConfig.
+  * \param[in] factory Function that creates the handler object. */
+int asynMockHandlerRegister(const char *name, asynMockHandlerFactory factory)
+{
+  mockHandlerNode *pNode;
+
+  mockHandlerListInit();
+  for (pNode = (mockHandlerNode *)ellFirst(&mockHandlerList); pNode;
+       pNode = (mockHandlerNode *)ellNext(&pNode->node)) {
+    if (strcmp(pNode->name, name) == 0) {
+      pNode->factory = factory;
+      return 0;
+    }
+  }
+  pNode = (mockHandlerNode *)calloc(1, sizeof(mockHandlerNode));
+  pNode->name = epicsStrDup(name);
+  pNode->factory = factory;
+  ellAdd(&mockHandlerList, &pNode->node);
+  return 0;
+}
+
+static asynMockHandlerFactory findMockHandler(const char *name)
+{
+  mockHandlerNode *pNode;
+
+  mockHandlerListInit();
+  for (pNode = (mockHandlerNode *)ellFirst(&mockHandlerList); pNode;
+       pNode = (mockHandlerNode *)ellNext(&pNode->node)) {
+    if (strcmp(pNode->name, name) == 0) return pNode->factory;
+  }
+  return NULL;
+}
+
+
+/** Creates a new asynMockController object.
+  * \param[in] portName The name of the asyn port that will be created
+  * \param[in] type     The handler type name, for reports
+  * \param[in] pHandler The handler that implements the controller
+  * \param[in] latency  The fixed delay between a write and its reply (s)
+  * \param[in] jitter   The maximum random extra delay (s)
+  * \param[in] seed     The seed of the jitter sequence
+  */
+asynMockController::asynMockController(const char *portName, const char *type, asynMockHandler *pHandler,
+                                       double latency, double jitter, unsigned int seed)
+  : asynPortDriver(portName, 1,
+#if MOTOR_ASYN_VERSION_INT < VERSION_INT_4_32
+                   1,
+#endif
+                   asynOctetMask | asynDrvUserMask, 0, ASYN_CANBLOCK, 1, 0, 0),
+    type_(epicsStrDup(type)), pHandler_(pHandler), latency_(latency), jitter_(jitter), seed_(seed),
+    head_(0), numPending_(0), writes_(0), replies_(0), timeouts_(0), overflows_(0),
+    totalDelay_(0.), maxDelay_(0.)
+{
+  startTime_ = epicsTime::getCurrent();
+  asynInterposeEosConfig(portName, -1, 1, 1);
+}
+
+/** Returns the delay of the next reply; latency_ plus a repeatable pseudo-random
+  * fraction of jitter_ (linear congruential generator, so the sequence only
+  * depends on the seed). */
+double asynMockController::delay()
+{
+  seed_ = seed_ * 1103515245u + 12345u;
+  return latency_ + jitter_ * ((seed_ >> 16) & 0x7fff) / 32768.;
+}
+
+/** Passes the commands in a write to the handler and queues the reply.
+  * \param[in] pasynUser asynUser structure that encodes the reason and address.
+  * \param[in] value Address of the string to write.
+  * \param[in] maxChars Number of characters to write.
+  * \param[out] nActual Number of characters actually written. */
+asynStatus asynMockController::writeOctet(asynUser *pasynUser, const char *value, size_t maxChars,
+                                          size_t *nActual)
+{
+  char command[MOCK_MAX_COMMAND];
+  mockReply *pReply;
+  epicsTime now = epicsTime::getCurrent();
+  size_t i, len = 0;
+  double d;
+  int n;
+  static const char *functionName = "writeOctet";
+
+  *nActual = maxChars;
+  writes_++;
+  pHandler_->advance(now - startTime_);
+  if (numPending_ == MOCK_MAX_PENDING) {
+    asynPrint(pasynUser, ASYN_TRACE_WARNING,
+      "%s:%s: port %s discarding unread reply\n",
+      driverName, functionName, portName);
+    head_ = (head_ + 1) % MOCK_MAX_PENDING;
+    numPending_--;
+    overflows_++;
+  }
+  pReply = &pending_[(head_ + numPending_) % MOCK_MAX_PENDING];
+  pReply->len = 0;
+  pReply->offset = 0;
+  for (i = 0; i <= maxChars; i++) {
+    if ((i == maxChars) || (value[i] == '\r') || (value[i] == '\n')) {
+      if (len == 0) continue;
+      command[len] = '\0';
+      len = 0;
+      n = pHandler_->command(command, &pReply->text[pReply->len], MOCK_MAX_REPLY - pReply->len);
+      if (n > 0) pReply->len += n;
+    } else if (len < sizeof(command) - 1) {
+      command[len++] = value[i];
+    }
+  }
+  asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, value, maxChars,
+    "%s:%s: port %s wrote %d chars\n",
+    driverName, functionName, portName, (int)maxChars);
+  if (pReply->len == 0) return asynSuccess;
+
+  d = delay();
+  pReply->ready = now + d;
+  totalDelay_ += d;
+  if (d > maxDelay_) maxDelay_ = d;
+  replies_++;
+  numPending_++;
+  return asynSuccess;
+}
+
+/** Returns the oldest pending reply once its delay has expired.
+  * \param[in] pasynUser asynUser structure that encodes the reason and address.
+  * \param[out] value Address of the string to read.
+  * \param[in] maxChars Maximum number of characters to read.
+  * \param[out] nActual Number of characters actually read.
+  * \param[out] eomReason ASYN_EOM_END at the end of a reply, else ASYN_EOM_CNT. */
+asynStatus asynMockController::readOctet(asynUser *pasynUser, char *value, size_t maxChars, size_t *nActual,
+                                         int *eomReason)
+{
+  mockReply *pReply;
+  double wait;
+  size_t n;
+  static const char *functionName = "readOctet";
+
+  *nActual = 0;
+  if (eomReason) *eomReason = 0;
+  if (numPending_ == 0) {
+    unlock();
+    if (pasynUser->timeout > 0.) epicsThreadSleep(pasynUser->timeout);
+    lock();
+    timeouts_++;
+    epicsSnprintf(pasynUser->errorMessage, pasynUser->errorMessageSize,
+      "%s:%s: port %s no reply", driverName, functionName, portName);
+    return asynTimeout;
+  }
+  pReply = &pending_[head_];
+  wait = pReply->ready - epicsTime::getCurrent();
+  if (wait > 0.) {
+    unlock();
+    epicsThreadSleep(wait);
+    lock();
+  }
+  n = pReply->len - pReply->offset;
+  if (n > maxChars) n = maxChars;
+  memcpy(value, &pReply->text[pReply->offset], n);
+  pReply->offset += n;
+  *nActual = n;
+  if (pReply->offset == pReply->len) {
+    head_ = (head_ + 1) % MOCK_MAX_PENDING;
+    numPending_--;
+    if (eomReason) *eomReason = ASYN_EOM_END;
+  } else {
+    if (eomReason) *eomReason = ASYN_EOM_CNT;
+  }
+  asynPrintIO(pasynUser, ASYN_TRACEIO_DRIVER, value, n,
+    "%s:%s: port %s read %d chars\n",
+    driverName, functionName, portName, (int)n);
+  return asynSuccess;
+}
+
+/** Discards all pending replies. */
+asynStatus asynMockController::flushOctet(asynUser *pasynUser)
+{
+  head_ = 0;
+  numPending_ = 0;
+  return asynSuccess;
+}
+
+/** Reports on status of the mock controller
+  * \param[in] fp The file pointer on which report information will be written
+  * \param[in] details The level of report detail desired */
+void asynMockController::report(FILE *fp, int details)
+{
+  fprintf(fp, "Mock controller %s, type %s, latency %g ms, jitter %g ms\n",
+    portName, type_, latency_*1000., jitter_*1000.);
+  fprintf(fp, "  writes=%lu, replies=%lu, pending=%d, timeouts=%lu, overflows=%lu\n",
+    writes_, replies_, numPending_, timeouts_, overflows_);
+  if (replies_ > 0)
+    fprintf(fp, "  mean delay=%.3f ms, max delay=%.3f ms\n",
+      totalDelay_/replies_*1000., maxDelay_*1000.);
+  pHandler_->report(fp, details);
+  asynPortDriver::report(fp, details);
+}
+
+
+/** Creates a new asynMockController object.
+  * Configuration command, called directly or from iocsh
+  * \param[in] portName   The name of the asyn port that will be created
+  * \param[in] type       The name of the handler, e.g. "echo"
+  * \param[in] parameters The handler parameters
+  * \param[in] latency    The fixed delay between a write and its reply in ms
+  * \param[in] jitter     The maximum random extra delay in ms
+  * \param[in] seed       The seed of the jitter sequence
+  */
+extern "C" int asynMockControllerConfig(const char *portName, const char *type, const char *parameters,
+                                        double latency, double jitter, int seed)
+{
+  asynMockHandlerFactory factory;
+  asynMockHandler *pHandler;
+  static const char *functionName = "asynMockControllerConfig";
+
+  if (!portName || !type) {
+    printf("%s:%s: Error port name and type are required\n", driverName, functionName);
+    return asynError;
+  }
+  factory = findMockHandler(type);
+  if (!factory) {
+    printf("%s:%s: Error unknown controller type %s\n", driverName, functionName, type);
+    return asynError;
+  }
+  if ((latency < 0.) || (jitter < 0.)) {
+    printf("%s:%s: Error latency and jitter must not be negative\n", driverName, functionName);
+    return asynError;
+  }
+  pHandler = factory(parameters);
+  if (!pHandler) {
+    printf("%s:%s: Error invalid parameters \"%s\" for %s\n",
+      driverName, functionName, parameters ? parameters : "", type);
+    return asynError;
+  }
+  new asynMockController(portName, type, pHandler, latency/1000., jitter/1000., (unsigned int)seed);
+  return asynSuccess;
+}
+
+/** Code for iocsh registration */
+static const iocshArg asynMockControllerConfigArg0 = {"Port name", iocshArgString};
+static const iocshArg asynMockControllerConfigArg1 = {"Controller type", iocshArgString};
+static const iocshArg asynMockControllerConfigArg2 = {"Parameters", iocshArgString};
+static const iocshArg asynMockControllerConfigArg3 = {"Latency (ms)", iocshArgDouble};
+static const iocshArg asynMockControllerConfigArg4 = {"Jitter (ms)", iocshArgDouble};
+static const iocshArg asynMockControllerConfigArg5 = {"Seed", iocshArgInt};
+static const iocshArg * const asynMockControllerConfigArgs[] = {&asynMockControllerConfigArg0,
+                                                                &asynMockControllerConfigArg1,
+                                                                &asynMockControllerConfigArg2,
+                                                                &asynMockControllerConfigArg3,
+                                                                &asynMockControllerConfigArg4,
+                                                                &asynMockControllerConfigArg5};
+static const iocshFuncDef asynMockControllerConfigDef = {"asynMockControllerConfig", 6,
+                                                         asynMockControllerConfigArgs};
+static void asynMockControllerConfigCallFunc(const iocshArgBuf *args)
+{
+  asynMockControllerConfig(args[0].sval, args[1].sval, args[2].sval, args[3].dval, args[4].dval,
+                           args[5].ival);
+}
+
+static void asynMockControllerRegister(void)
+{
+  iocshRegister(&asynMockControllerConfigDef, asynMockControllerConfigCallFunc);
+}
+
+extern "C" {
+epicsExportRegistrar(asynMockControllerRegister);
+}
@@ -0,0 +1,81 @@
+/* asynMockController.h
+ *
+ * This file defines an in-process loopback asynOctet port that stands in for
+ * the serial or TCP link to a motor controller.  Commands written to the port
+ * are passed to a pluggable asynMockHandler, which implements the command
+ * grammar and state of one controller type, and its replies are returned by
+ * the following reads after a configurable latency and jitter.  Any driver
+ * that talks to its controller through writeController()/writeReadController()
+ * can then be exercised and benchmarked inside one IOC, with no simulator
+ * process or socket in the path.
+ */
+#ifndef asynMockController_H
+#define asynMockController_H
+
+#include <epicsTime.h>
+#include <asynPortDriver.h>
+
+#define MOCK_MAX_REPLY   4096   /**< Maximum reply to one write */
+#define MOCK_MAX_PENDING 16     /**< Maximum replies waiting to be read */
+
+#ifdef __cplusplus
+
+/** Command grammar and state of one simulated controller type. */
+class epicsShareClass asynMockHandler {
+  public:
+  virtual ~asynMockHandler() {}
+  /** Processes one command, without its terminator.
+    * Writes the complete reply, including any terminator the controller sends, to reply.
+    * Returns the reply length; 0 if the controller does not reply. */
+  virtual int command(const char *command, char *reply, int maxReply) = 0;
+  /** Called before each write with the seconds since the port was created,
+    * for handlers whose state evolves with time. */
+  virtual void advance(double time) {}
+  virtual void report(FILE *fp, int details) {}
+};
+
+/** Factory function for a named handler; parameters is the string passed to
+  * asynMockControllerConfig. Returns NULL if the parameters are not valid. */
+typedef asynMockHandler *(*asynMockHandlerFactory)(const char *parameters);
+
+/** Reply waiting to be read; ready is the time the reply "arrives". */
+typedef struct mockReply {
+  char text[MOCK_MAX_REPLY];
+  size_t len;
+  size_t offset;
+  epicsTime ready;
+} mockReply;
+
+class epicsShareClass asynMockController : public asynPortDriver {
+  public:
+  asynMockController(const char *portName, const char *type, asynMockHandler *pHandler,
+                     double latency, double jitter, unsigned int seed);
+  virtual asynStatus writeOctet(asynUser *pasynUser, const char *value, size_t maxChars, size_t *nActual);
+  virtual asynStatus readOctet(asynUser *pasynUser, char *value, size_t maxChars, size_t *nActual,
+                               int *eomReason);
+  virtual asynStatus flushOctet(asynUser *pasynUser);
+  virtual void report(FILE *fp, int details);
+
+  private:
+  double delay();
+  char *type_;
+  asynMockHandler *pHandler_;
+  double latency_;              /**< Fixed reply delay (s) */
+  double jitter_;               /**< Random extra delay, uniform in [0, jitter_] (s) */
+  unsigned int seed_;           /**< State of the jitter generator; fixed seed, repeatable runs */
+  epicsTime startTime_;
+  mockReply pending_[MOCK_MAX_PENDING];
+  int head_;
+  int numPending_;
+  unsigned long writes_;
+  unsigned long replies_;
+  unsigned long timeouts_;
+  unsigned long overflows_;
+  double totalDelay_;
+  double maxDelay_;
+};
+
+extern "C" epicsShareFunc int asynMockHandlerRegister(const char *name, asynMockHandlerFactory factory);
+
+#endif /* _cplusplus */
+#endif /* asynMockController_H */
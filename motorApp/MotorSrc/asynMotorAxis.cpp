@@ -7,6 +7,7 @@
  */
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include <epicsThread.h>
 
@@ -47,6 +48,12 @@ asynMotorAxis::asynMotorAxis(class asynMotorController *pC, int axisNo)
   profilePositions_       = NULL;
   profileReadbacks_       = NULL;
   profileFollowingErrors_ = NULL;
+  profilePulsePositions_  = NULL;
+  profileVelocities_      = NULL;
+  profileSamplePositions_ = NULL;
+  profileSampleVelocities_ = NULL;
+  profileSlots_           = NULL;
+  builtUseAxis_           = 0;
   
   /* Used to keep track of referencing mode in the driver.*/
   referencingMode_ = 0;
@@ -56,6 +63,8 @@ asynMotorAxis::asynMotorAxis(class asynMotorController *pC, int axisNo)
   wasMovingFlag_ = 0;
   disableFlag_ = 0;
   lastEndOfMoveTime_ = 0;
+  expectDone_ = 0;
+  donePolls_ = 0;
 
   // Create the asynUser, connect to this axis
   pasynUser_ = pasynManager->createAsynUser(NULL, NULL);
@@ -207,7 +216,7 @@ asynStatus asynMotorAxis::doMoveToHome()
   
   asynPrint(pasynUser_, ASYN_TRACE_ERROR, 
     "%s:%s: Axis=%d no implementation\n",
-    driverName, functionName, pC_->moveToHomeAxis_);
+    driverName, functionName, axisNo_);
   return asynSuccess;
 }
 
@@ -321,6 +330,8 @@ asynStatus asynMotorAxis::initializeProfile(size_t maxProfilePoints)
   profileReadbacks_ =         (double *)calloc(maxProfilePoints, sizeof(double));
   if (profileFollowingErrors_) free(profileFollowingErrors_);
   profileFollowingErrors_ =   (double *)calloc(maxProfilePoints, sizeof(double));
+  if (profileVelocities_)      free(profileVelocities_);
+  profileVelocities_ =        (double *)calloc(maxProfilePoints, sizeof(double));
   return asynSuccess;
 }
   
@@ -402,6 +413,20 @@ asynStatus asynMotorAxis::abortProfile()
 
 
 
+/** Function to load the profile output pulses of this axis into the controller.
+  * Drivers with position compare outputs per axis implement this.
+  * \param[in] pulseMode PROFILE_PULSE_MODE_TIME to output pulses at pC_->pulseTimes_,
+  *            PROFILE_PULSE_MODE_POSITION to output them as the axis reaches profilePulsePositions_.
+  * \param[in] numPulses The number of pulses. */
+asynStatus asynMotorAxis::loadProfilePulses(int pulseMode, size_t numPulses)
+{
+  // static const char *functionName = "loadProfilePulses";
+
+  return asynSuccess;
+}
+
+
+
 /** Function to readback the actual motor positions from a coordinated move of multiple axes.
   * This base class function converts the readbacks and following errors from controller units 
   * to user units and does callbacks on the arrays.
@@ -488,6 +513,52 @@ void asynMotorAxis::setLastEndOfMoveTime(double time)
   lastEndOfMoveTime_ = time;
 }
 
+/**
+ * Returns the time in seconds of a trapezoidal (or triangular) move profile, or 0 if it
+ * cannot be estimated.
+ * \param[in] distance The distance of the move. Units=steps.
+ * \param[in] minVelocity The base velocity. Units=steps/sec.
+ * \param[in] maxVelocity The slew velocity. Units=steps/sec.
+ * \param[in] acceleration The acceleration. Units=steps/sec/sec.
+ */
+double asynMotorAxis::moveTime(double distance, double minVelocity, double maxVelocity, double acceleration)
+{
+  double accelTime, accelDistance, t;
+
+  distance = fabs(distance);
+  minVelocity = fabs(minVelocity);
+  maxVelocity = fabs(maxVelocity);
+  if (maxVelocity <= 0.) return 0.;
+  if (minVelocity > maxVelocity) minVelocity = maxVelocity;
+  if (acceleration <= 0.) return distance / maxVelocity;
+
+  accelTime = (maxVelocity - minVelocity) / acceleration;
+  accelDistance = (minVelocity + maxVelocity) / 2. * accelTime;
+  if (2. * accelDistance <= distance)
+    return 2. * accelTime + (distance - 2. * accelDistance) / maxVelocity;
+
+  /* Triangular profile; accelerate over half of the distance */
+  t = (sqrt(minVelocity * minVelocity + acceleration * distance) - minVelocity) / acceleration;
+  return 2. * t;
+}
+
+/**
+ * Sets the time at which the current move is expected to be done; the base class poller
+ * polls at that time, and then does a burst of fast polls until the move is done.
+ * \param[in] moveTime The expected duration of the move from now, in seconds; 0 if unknown.
+ */
+void asynMotorAxis::setExpectedDoneTime(double moveTime)
+{
+  if (moveTime <= 0.) {
+    expectDone_ = 0;
+    return;
+  }
+  epicsTimeGetCurrent(&expectedDone_);
+  epicsTimeAddSeconds(&expectedDone_, moveTime);
+  donePolls_ = pC_->donePollCount_;
+  expectDone_ = 1;
+}
+
 
 /********************************************************************/
 
@@ -10,6 +10,7 @@
 
 #include <epicsEvent.h>
 #include <epicsTypes.h>
+#include <epicsTime.h>
 
 #ifdef __cplusplus
 #include <asynPortDriver.h>
@@ -52,6 +53,7 @@ class epicsShareClass asynMotorAxis {
   virtual asynStatus executeProfile();
   virtual asynStatus abortProfile();
   virtual asynStatus readbackProfile();
+  virtual asynStatus loadProfilePulses(int pulseMode, size_t numPulses);
 
   void setReferencingModeMove(int distance);
   int getReferencingModeMove();
@@ -63,6 +65,9 @@ class epicsShareClass asynMotorAxis {
   double getLastEndOfMoveTime();
   void setLastEndOfMoveTime(double time);
 
+  static double moveTime(double distance, double minVelocity, double maxVelocity, double acceleration);
+  void setExpectedDoneTime(double moveTime);
+
   protected:
   class asynMotorController *pC_;    /**< Pointer to the asynMotorController to which this axis belongs.
                                       *   Abbreviated because it is used very frequently */
@@ -71,6 +76,12 @@ class epicsShareClass asynMotorAxis {
   double *profilePositions_;         /**< Array of target positions for profile moves */
   double *profileReadbacks_;         /**< Array of readback positions for profile moves */
   double *profileFollowingErrors_;   /**< Array of following errors for profile moves */   
+  double *profilePulsePositions_;    /**< Array of positions at the scheduled profile pulses; controller units */
+  double *profileVelocities_;        /**< Array of velocities at the profile points, for PVT controllers */
+  double *profileSamplePositions_;   /**< Array of profile positions resampled at the controller segment time */
+  double *profileSampleVelocities_;  /**< Array of profile velocities resampled at the controller segment time */
+  asynMotorAxisProfileSlot *profileSlots_; /**< The profile arrays of each slot; see asynMotorController::selectProfileSlot() */
+  int builtUseAxis_;                 /**< profileUseAxis_ when the selected slot was built */
   int referencingMode_;
 
   MotorStatus status_;
@@ -81,6 +92,9 @@ class epicsShareClass asynMotorAxis {
   int wasMovingFlag_;
   int disableFlag_;
   double lastEndOfMoveTime_;
+  int expectDone_;                   /**< expectedDone_ is valid; the move has not been seen done */
+  epicsTimeStamp expectedDone_;      /**< Expected completion time of the current move */
+  int donePolls_;                    /**< Fast polls left after expectedDone_ */
   
   friend class asynMotorController;
 };
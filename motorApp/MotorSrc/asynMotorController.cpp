@@ -6,9 +6,13 @@
  * from which real motor controllers are derived.  It derives from asynPortDriver.
  */
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 #include <epicsThread.h>
+#include <epicsString.h>
+#include <epicsStdio.h>
 #include <iocsh.h>
 
 #include <asynPortDriver.h>
@@ -30,6 +34,42 @@
 static const char *driverName = "asynMotorController";
 static void asynMotorPollerC(void *drvPvt);
 static void asynMotorMoveToHomeC(void *drvPvt);
+static void prepareProfileC(void *drvPvt);
+static void asynMotorProfileStreamC(void *drvPvt);
+
+/* Axis-state snapshot file.  The file is written in host byte order; it is only
+ * read back by the IOC that wrote it. */
+#define SNAPSHOT_MAGIC "MOTSNAP"
+#define SNAPSHOT_VERSION 1
+
+typedef struct snapshotHeader {
+  char magic[8];
+  epicsUInt32 version;
+  epicsUInt32 numAxes;
+  epicsTimeStamp time;          /**< Time the snapshot was written */
+} snapshotHeader;
+
+typedef struct snapshotAxis {
+  double position;
+  double encoderPosition;
+  double encoderRatio;
+  double highLimit;
+  double lowLimit;
+  epicsUInt32 status;
+  epicsUInt32 valid;            /**< The axis exists */
+  epicsTimeStamp time;          /**< Time the values of this axis last changed */
+} snapshotAxis;
+
+/* Snapshot files configured with asynMotorSnapshot() before the controller started its poller */
+typedef struct snapshotConfig {
+  struct snapshotConfig *next;
+  char *portName;
+  char *fileName;
+  double period;
+  int positionAxes;
+} snapshotConfig;
+
+static snapshotConfig *snapshotConfigs = NULL;
 
 
 
@@ -81,6 +121,10 @@ asynMotorController::asynMotorController(const char *portName, int numAxes, int
   createParam(motorPostMoveDelayString,          asynParamFloat64,    &motorPostMoveDelay_);
   createParam(motorStatusString,                 asynParamInt32,      &motorStatus_);
   createParam(motorUpdateStatusString,           asynParamInt32,      &motorUpdateStatus_);
+  createParam(motorStopAllString,                asynParamInt32,      &motorStopAll_);
+  createParam(motorMoveToHomeStateString,        asynParamInt32,      &motorMoveToHomeState_);
+  createParam(motorMoveToHomeQueueString,        asynParamInt32,      &motorMoveToHomeQueue_);
+  createParam(motorMoveToHomeTimeString,         asynParamFloat64,    &motorMoveToHomeTime_);
   createParam(motorStatusDirectionString,        asynParamInt32,      &motorStatusDirection_);
   createParam(motorStatusDoneString,             asynParamInt32,      &motorStatusDone_);
   createParam(motorStatusHighLimitString,        asynParamInt32,      &motorStatusHighLimit_);
@@ -110,6 +154,25 @@ asynMotorController::asynMotorController(const char *portName, int numAxes, int
   createParam(profileStartPulsesString,          asynParamInt32,      &profileStartPulses_);
   createParam(profileEndPulsesString,            asynParamInt32,      &profileEndPulses_);
   createParam(profileActualPulsesString,         asynParamInt32,      &profileActualPulses_);
+  createParam(profilePulseModeString,            asynParamInt32,      &profilePulseMode_);
+  createParam(profilePulseTimesString,    asynParamFloat64Array,      &profilePulseTimes_);
+  createParam(profileActualPulseTimesString, asynParamFloat64Array,   &profileActualPulseTimes_);
+  createParam(profileAutoScaleString,            asynParamInt32,      &profileAutoScale_);
+  createParam(profileTimeScaleString,            asynParamFloat64,    &profileTimeScale_);
+  createParam(profileBadPointString,             asynParamInt32,      &profileBadPoint_);
+  createParam(profileFitModeString,              asynParamInt32,      &profileFitMode_);
+  createParam(profileSegmentTimeString,          asynParamFloat64,    &profileSegmentTime_);
+  createParam(profileNumSamplesString,           asynParamInt32,      &profileNumSamples_);
+  createParam(profileNumSlotsString,             asynParamInt32,      &profileNumSlots_);
+  createParam(profileBuildSlotString,            asynParamInt32,      &profileBuildSlot_);
+  createParam(profileExecuteSlotString,          asynParamInt32,      &profileExecuteSlot_);
+  createParam(profileReadbackSlotString,         asynParamInt32,      &profileReadbackSlot_);
+  createParam(profileSwapSlotsString,            asynParamInt32,      &profileSwapSlots_);
+  createParam(profileStreamRateString,           asynParamFloat64,    &profileStreamRate_);
+  createParam(profileStreamSequenceString,       asynParamInt32,      &profileStreamSequence_);
+  createParam(profileStreamNumPointsString,      asynParamInt32,      &profileStreamNumPoints_);
+  createParam(profileStreamOverrunsString,       asynParamInt32,      &profileStreamOverruns_);
+  createParam(profileStreamPointsString,  asynParamFloat64Array,      &profileStreamPoints_);
   createParam(profileNumReadbacksString,         asynParamInt32,      &profileNumReadbacks_);
   createParam(profileTimeModeString,             asynParamInt32,      &profileTimeMode_);
   createParam(profileFixedTimeString,          asynParamFloat64,      &profileFixedTime_);
@@ -135,6 +198,12 @@ asynMotorController::asynMotorController(const char *portName, int numAxes, int
   createParam(profilePositionsString,     asynParamFloat64Array,      &profilePositions_);
   createParam(profileReadbacksString,     asynParamFloat64Array,      &profileReadbacks_);
   createParam(profileFollowingErrorsString, asynParamFloat64Array,    &profileFollowingErrors_);
+  createParam(profilePulsePositionsString, asynParamFloat64Array,     &profilePulsePositions_);
+  createParam(profileMaxVelocityString,          asynParamFloat64,    &profileMaxVelocity_);
+  createParam(profileMaxAccelerationString,      asynParamFloat64,    &profileMaxAcceleration_);
+  createParam(profileVelocitiesString,    asynParamFloat64Array,      &profileVelocities_);
+  createParam(profileStreamReadbacksString, asynParamFloat64Array,    &profileStreamReadbacks_);
+  createParam(profileStreamFollowingErrorsString, asynParamFloat64Array, &profileStreamFollowingErrors_);
 
   pAxes_ = (asynMotorAxis**) calloc(numAxes, sizeof(asynMotorAxis*));
   pollEventId_ = epicsEventMustCreate(epicsEventEmpty);
@@ -142,9 +211,71 @@ asynMotorController::asynMotorController(const char *portName, int numAxes, int
 
   maxProfilePoints_ = 0;
   profileTimes_ = NULL;
+  profileInverseTimes_ = NULL;
+  profileSegmentVelocities_ = NULL;
+  profileAccelerations_ = NULL;
+  maxProfileSamples_ = 0;
+  numProfileSamples_ = 0;
+  profileThreads_ = 1;
+  maxProfilePulses_ = 0;
+  numProfilePulses_ = 0;
+  pulseTimes_ = NULL;
+  actualPulseTimes_ = NULL;
+  numProfilePoints_ = 0;
+  builtMoveMode_ = 0;
+  builtPulseMode_ = PROFILE_PULSE_MODE_TIME;
+  builtStartPulses_ = 0;
+  builtEndPulses_ = 0;
+  numProfileSlots_ = 1;
+  profileSlots_ = NULL;
+  profileSlot_ = 0;
+  buildSlot_ = 0;
+  executeSlot_ = 0;
+  readbackSlot_ = 0;
+  readbackRing_ = NULL;
+  streamEventId_ = epicsEventMustCreate(epicsEventEmpty);
+  streamSequence_ = 0;
   setIntegerParam(profileExecuteState_, PROFILE_EXECUTE_DONE);
+  setIntegerParam(profilePulseMode_, PROFILE_PULSE_MODE_TIME);
+  setIntegerParam(profileAutoScale_, 0);
+  setDoubleParam(profileTimeScale_, 1.0);
+  setIntegerParam(profileBadPoint_, 0);
+  setIntegerParam(profileFitMode_, PROFILE_FIT_MODE_LINEAR);
+  setDoubleParam(profileSegmentTime_, 0.);
+  setIntegerParam(profileNumSamples_, 0);
+  setIntegerParam(profileNumSlots_, numProfileSlots_);
+  setIntegerParam(profileBuildSlot_, 0);
+  setIntegerParam(profileExecuteSlot_, 0);
+  setIntegerParam(profileReadbackSlot_, 0);
+  setDoubleParam(profileStreamRate_, 0.);
+  setIntegerParam(profileStreamSequence_, 0);
+  setIntegerParam(profileStreamNumPoints_, 0);
+  setIntegerParam(profileStreamOverruns_, 0);
+  for (int axis=0; axis<numAxes; axis++) {
+    setDoubleParam(axis, profileMaxVelocity_, 0.);
+    setDoubleParam(axis, profileMaxAcceleration_, 0.);
+  }
 
   moveToHomeAxis_ = 0;
+  moveToHomeQueue_ = (int *) calloc(numAxes, sizeof(int));
+  moveToHomeQueued_ = 0;
+  moveToHomeActive_ = 0;
+  moveToHomeMaxActive_ = 1;
+  moveToHomeThreads_ = 0;
+  for (int axis=0; axis<numAxes; axis++) {
+    setIntegerParam(axis, motorMoveToHomeState_, MOVE_TO_HOME_IDLE);
+    setIntegerParam(axis, motorMoveToHomeQueue_, 0);
+    setDoubleParam(axis, motorMoveToHomeTime_, 0.);
+  }
+
+  donePollPeriod_ = 0.;
+  donePollCount_ = 10;
+
+  snapshotFile_ = NULL;
+  snapshotPeriod_ = 0.;
+  snapshot_ = NULL;
+  snapshotVerify_ = 0;
+  snapshotPositionAxes_ = 0;
 
   asynPrint(this->pasynUserSelf, ASYN_TRACE_FLOW,
     "%s:%s: constructor complete\n",
@@ -170,6 +301,9 @@ void asynMotorController::report(FILE *fp, int level)
     if (!pAxis) continue; 
     pAxis->report(fp, level);
   }
+  if (numProfileSlots_ > 1)
+    fprintf(fp, "  profile slots %d, build %d, execute %d, readback %d\n",
+            numProfileSlots_, buildSlot_, executeSlot_, readbackSlot_);
 
   // Call the base class method
   asynPortDriver::report(fp, level);
@@ -180,7 +314,11 @@ void asynMotorController::report(FILE *fp, int level)
   * Extracts the function and axis number from pasynUser.
   * Sets the value in the parameter library.
   * If the function is motorStop_ then it calls pAxis->stop().
+  * If the function is motorStopAll_ then it calls stopAll().
   * If the function is motorUpdateStatus_ then it does a poll and forces a callback.
+  * If the function is motorMoveToHome_ then it queues (value=1) or cancels (value=0) a move to home.
+  * Profile execute and abort run with the execute slot selected, and profile readback with the readback slot;
+  * see selectProfileSlot().
   * Calls any registered callbacks for this pasynUser->reason and address.  
   * Motor drivers will reimplement this function if they support 
   * controller-specific parameters on the asynInt32 interface. They should call this
@@ -193,6 +331,8 @@ asynStatus asynMotorController::writeInt32(asynUser *pasynUser, epicsInt32 value
   asynStatus status=asynSuccess;
   asynMotorAxis *pAxis;
   int axis;
+  int slot;
+  int executeState;
   static const char *functionName = "writeInt32";
 
   pAxis = getAxis(pasynUser);
@@ -207,6 +347,9 @@ asynStatus asynMotorController::writeInt32(asynUser *pasynUser, epicsInt32 value
     getDoubleParam(axis, motorAccel_, &accel);
     status = pAxis->stop(accel);
   
+  } else if (function == motorStopAll_) {
+    status = stopAll();
+
   } else if (function == motorDeferMoves_) {
     status = setDeferredMoves(value);
   
@@ -221,23 +364,55 @@ asynStatus asynMotorController::writeInt32(asynUser *pasynUser, epicsInt32 value
     pAxis->statusChanged_ = 1;
 
   } else if (function == profileBuild_) {
-    status = buildProfile();
+    getIntegerParam(profileExecuteState_, &executeState);
+    if ((numProfileSlots_ > 1) && (buildSlot_ == executeSlot_) && (executeState != PROFILE_EXECUTE_DONE)) {
+      setStringParam(profileBuildMessage_, "Cannot build in the slot that is executing");
+      status = asynError;
+    } else {
+      status = buildProfile();
+    }
+    // buildProfile() has returned, so the build of a derived driver is complete too
+    setIntegerParam(profileBuild_, 0);
+    setIntegerParam(profileBuildState_, PROFILE_BUILD_DONE);
+    setIntegerParam(profileBuildStatus_, status ? PROFILE_STATUS_FAILURE : PROFILE_STATUS_SUCCESS);
+    callParamCallbacks();
 
   } else if (function == profileExecute_) {
-    status = executeProfile();
+    slot = selectExecuteSlot();
+    if ((numProfileSlots_ > 1) && (numProfilePoints_ == 0)) {
+      setStringParam(profileExecuteMessage_, "Execute slot has not been built");
+      setIntegerParam(profileExecuteStatus_, PROFILE_STATUS_FAILURE);
+      setIntegerParam(profileExecute_, 0);
+      status = asynError;
+    } else {
+      status = executeProfile();
+    }
+    selectProfileSlot(slot);
 
   } else if (function == profileAbort_) {
+    slot = selectExecuteSlot();
     status = abortProfile();
+    selectProfileSlot(slot);
 
   } else if (function == profileReadback_) {
+    slot = selectProfileSlot(readbackSlot_);
     status = readbackProfile();
+    selectProfileSlot(slot);
+
+  } else if ((function == profileBuildSlot_) || (function == profileExecuteSlot_) ||
+             (function == profileReadbackSlot_)) {
+    status = setProfileSlot(function, value);
+
+  } else if (function == profileSwapSlots_) {
+    status = swapProfileSlots();
 
   } else if (function == motorMoveToHome_) {
     if (value == 1) {
       asynPrint(pasynUser, ASYN_TRACE_FLOW, 
-        "%s:%s:: Starting a move to home for axis %d\n",  driverName, functionName, axis);
-      moveToHomeAxis_ = axis;
-      epicsEventSignal(moveToHomeId_);
+        "%s:%s:: Queueing a move to home for axis %d\n",  driverName, functionName, axis);
+      status = queueMoveToHome(axis);
+    } else if (value == 0) {
+      status = cancelMoveToHome(axis);
     }
   }
 
@@ -268,7 +443,7 @@ asynStatus asynMotorController::writeInt32(asynUser *pasynUser, epicsInt32 value
 asynStatus asynMotorController::writeFloat64(asynUser *pasynUser, epicsFloat64 value)
 {
   int function = pasynUser->reason;
-  double baseVelocity, velocity, acceleration;
+  double baseVelocity, velocity, acceleration, position;
   asynMotorAxis *pAxis;
   int axis;
   int forwards;
@@ -297,6 +472,7 @@ asynStatus asynMotorController::writeFloat64(asynUser *pasynUser, epicsFloat64 v
     getDoubleParam(axis, motorVelocity_, &velocity);
     getDoubleParam(axis, motorAccel_, &acceleration);
     status = pAxis->move(value, 1, baseVelocity, velocity, acceleration);
+    pAxis->setExpectedDoneTime(asynMotorAxis::moveTime(value, baseVelocity, velocity, acceleration));
     pAxis->setIntegerParam(motorStatusDone_, 0);
     pAxis->callParamCallbacks();
     wakeupPoller();
@@ -313,7 +489,9 @@ asynStatus asynMotorController::writeFloat64(asynUser *pasynUser, epicsFloat64 v
     getDoubleParam(axis, motorVelBase_, &baseVelocity);
     getDoubleParam(axis, motorVelocity_, &velocity);
     getDoubleParam(axis, motorAccel_, &acceleration);
+    getDoubleParam(axis, motorPosition_, &position);
     status = pAxis->move(value, 0, baseVelocity, velocity, acceleration);
+    pAxis->setExpectedDoneTime(asynMotorAxis::moveTime(value - position, baseVelocity, velocity, acceleration));
     pAxis->setIntegerParam(motorStatusDone_, 0);
     pAxis->callParamCallbacks();
     wakeupPoller();
@@ -412,6 +590,10 @@ asynStatus asynMotorController::writeFloat64(asynUser *pasynUser, epicsFloat64 v
       "%s:%s: Set driver %s, axis %d encoder ratio=%f\n",
       driverName, functionName, portName, pAxis->axisNo_, value);
 
+  } else if (function == profileStreamRate_) {
+    /* Wake the stream thread so that the new rate applies at once */
+    epicsEventSignal(streamEventId_);
+
   }
   /* Do callbacks so higher layers see any changes */
   pAxis->callParamCallbacks();
@@ -460,7 +642,10 @@ asynStatus asynMotorController::writeFloat64Array(asynUser *pasynUser, epicsFloa
 }
 
 /** Called when asyn clients call pasynFloat64Array->read().
-  * Returns the readbacks or following error arrays from profile moves.
+  * Returns the readbacks or following error arrays from profile moves,
+  * the scheduled and actual output pulses, or the velocities at the profile points.
+  * Readbacks and following errors are those of the readback slot, actual pulses those of the execute slot,
+  * and the others those of the build slot.
   * \param[in] pasynUser pasynUser structure that encodes the reason and address.
   * \param[in] value Pointer to the array to read.
   * \param[in] nElements Maximum number of elements to read. 
@@ -471,15 +656,42 @@ asynStatus asynMotorController::readFloat64Array(asynUser *pasynUser, epicsFloat
   int function = pasynUser->reason;
   asynMotorAxis *pAxis;
   int numReadbacks;
+  int numActualPulses;
+  int slot;
+  asynStatus status = asynSuccess;
   static const char *functionName = "readFloat64Array";
 
   pAxis = getAxis(pasynUser);
   if (!pAxis) return asynError;
+
+  if (function == profilePulseTimes_) {
+    *nRead = (numProfilePulses_ < nElements) ? numProfilePulses_ : nElements;
+    memcpy(value, pulseTimes_, *nRead*sizeof(double));
+    return asynSuccess;
+  }
+  else if (function == profileActualPulseTimes_) {
+    slot = selectExecuteSlot();
+    getIntegerParam(profileActualPulses_, &numActualPulses);
+    *nRead = ((size_t)numActualPulses < nElements) ? numActualPulses : nElements;
+    if (*nRead > maxProfilePulses_) *nRead = maxProfilePulses_;
+    memcpy(value, actualPulseTimes_, *nRead*sizeof(double));
+    selectProfileSlot(slot);
+    return asynSuccess;
+  }
+  else if (function == profilePulsePositions_) {
+    *nRead = getPulsePositions(pAxis, value, nElements);
+    return asynSuccess;
+  }
+  else if (function == profileVelocities_) {
+    *nRead = getProfileVelocities(pAxis, value, nElements);
+    return asynSuccess;
+  }
   
   getIntegerParam(profileNumReadbacks_, &numReadbacks);
   *nRead = numReadbacks;
   if (*nRead > nElements) *nRead = nElements;
 
+  slot = selectProfileSlot(readbackSlot_);
   if (function == profileReadbacks_) {
     memcpy(value, pAxis->profileReadbacks_, *nRead*sizeof(double));
   } 
@@ -490,9 +702,10 @@ asynStatus asynMotorController::readFloat64Array(asynUser *pasynUser, epicsFloat
     asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
       "%s:%s: unknown parameter number %d\n", 
       driverName, functionName, function);
-    return asynError ;
+    status = asynError;
   }
-  return asynSuccess;
+  selectProfileSlot(slot);
+  return status;
 }
 
 
@@ -523,6 +736,25 @@ asynStatus asynMotorController::readGenericPointer(asynUser *pasynUser, void *po
   return asynSuccess;
 }  
 
+/** Stops all axes of this controller with one request; used by motorUtil's allstop.
+  * This base class function calls stop() on each axis with its own acceleration.
+  * Drivers for controllers that have a single stop-all command should reimplement it. */
+asynStatus asynMotorController::stopAll()
+{
+  int axis;
+  double accel;
+  asynMotorAxis *pAxis;
+  asynStatus status = asynSuccess;
+
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = getAxis(axis);
+    if (!pAxis) continue;
+    getDoubleParam(axis, motorAccel_, &accel);
+    if (pAxis->stop(accel)) status = asynError;
+  }
+  return status;
+}
+
 /** Returns a pointer to an asynMotorAxis object.
   * Returns NULL if the axis number encoded in pasynUser is invalid.
   * Derived classes will reimplement this function to return a pointer to the derived
@@ -565,9 +797,23 @@ asynMotorAxis* asynMotorController::getAxis(int axisNo)
   * report that an axis is moving after it has been told to start. */
 asynStatus asynMotorController::startPoller(double movingPollPeriod, double idlePollPeriod, int forcedFastPolls)
 {
+  snapshotConfig *pConfig;
+
   movingPollPeriod_ = movingPollPeriod;
   idlePollPeriod_   = idlePollPeriod;
   forcedFastPolls_  = forcedFastPolls;
+
+  /* Restore the snapshot before the first poll, which verifies it */
+  for (pConfig = snapshotConfigs; pConfig; pConfig = pConfig->next) {
+    if (strcmp(pConfig->portName, portName) != 0) continue;
+    snapshotFile_ = epicsStrDup(pConfig->fileName);
+    snapshotPeriod_ = pConfig->period;
+    snapshotPositionAxes_ = pConfig->positionAxes;
+    lock();
+    readSnapshot();
+    unlock();
+    break;
+  }
   epicsThreadCreate("motorPoller", 
                     epicsThreadPriorityLow,
                     epicsThreadGetStackSize(epicsThreadStackMedium),
@@ -646,6 +892,12 @@ void asynMotorController::asynMotorPoller()
       break;
     }
 
+    if (snapshotVerify_) {
+      /* The restored axes are unverified until this poll; the driver reports its own problems */
+      snapshotAxis *pAxes = (snapshotAxis *)((snapshotHeader *)snapshot_ + 1);
+      for (i=0; i<numAxes_; i++)
+        if (getAxis(i) && pAxes[i].valid) setIntegerParam(i, motorStatusProblem_, 0);
+    }
     poll();
     for (i=0; i<numAxes_; i++) {
       pAxis=getAxis(i);
@@ -682,6 +934,26 @@ void asynMotorController::asynMotorPoller()
       }
 
     }
+    if (snapshotVerify_) {
+      /* Report axes whose controller position differs from the snapshot, e.g. after a power cycle.
+       * Device support may already have used a restored position, so those axes are also marked
+       * with a problem. */
+      snapshotAxis *pAxes = (snapshotAxis *)((snapshotHeader *)snapshot_ + 1);
+      double position;
+      for (i=0; i<numAxes_; i++) {
+        if (!getAxis(i) || !pAxes[i].valid) continue;
+        getDoubleParam(i, motorPosition_, &position);
+        if (fabs(position - pAxes[i].position) < 1.0) continue;
+        asynPrint(this->pasynUserSelf, ASYN_TRACE_ERROR,
+          "%s:%s: %s axis %d position %f differs from snapshot %f\n",
+          driverName, "asynMotorPoller", portName, i, position, pAxes[i].position);
+        if ((i < 32) && (snapshotPositionAxes_ & (1 << i))) {
+          setIntegerParam(i, motorStatusProblem_, 1);
+          callParamCallbacks(i);
+        }
+      }
+      snapshotVerify_ = 0;
+    }
     if (forcedFastPolls > 0) {
       timeout = movingPollPeriod_;
       forcedFastPolls--;
@@ -690,18 +962,227 @@ void asynMotorController::asynMotorPoller()
     } else {
       timeout = idlePollPeriod_;
     }
+    timeout = donePollTimeout(timeout);
     unlock();
+    if (snapshotFile_) writeSnapshot();
+  }
+}
+
+/** Sets the axis-state snapshot file of a running controller; it is written from now on.
+  * \param[in] fileName The snapshot file.
+  * \param[in] period The minimum time between snapshot writes. */
+asynStatus asynMotorController::setSnapshotFile(const char *fileName, double period)
+{
+  lock();
+  free(snapshotFile_);
+  snapshotFile_ = epicsStrDup(fileName);
+  snapshotPeriod_ = period;
+  unlock();
+  return asynSuccess;
+}
+
+/** Returns the time to the next poll, shortened so that axes whose moves are expected to be done
+  * are polled at the expected time, and then every donePollPeriod_ for at most donePollCount_ polls
+  * until they are seen done.  Called by the base class poller with the lock held, after a poll.
+  * \param[in] timeout The time to the next poll from the moving and idle poll periods. */
+double asynMotorController::donePollTimeout(double timeout)
+{
+  double period = (donePollPeriod_ > 0.) ? donePollPeriod_ : movingPollPeriod_ / 4.;
+  double remaining;
+  epicsTimeStamp now;
+  asynMotorAxis *pAxis;
+  int axis, done;
+
+  epicsTimeGetCurrent(&now);
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = getAxis(axis);
+    if (!pAxis || !pAxis->expectDone_) continue;
+    getIntegerParam(axis, motorStatusDone_, &done);
+    if (done || donePollCount_ <= 0 || period <= 0.) {
+      pAxis->expectDone_ = 0;
+      continue;
+    }
+    remaining = epicsTimeDiffInSeconds(&pAxis->expectedDone_, &now);
+    if (remaining <= 0.) {
+      if (pAxis->donePolls_-- <= 0) {
+        pAxis->expectDone_ = 0;
+        continue;
+      }
+      remaining = period;
+    }
+    if ((timeout == 0.) || (remaining < timeout)) timeout = remaining;
+  }
+  return timeout;
+}
+
+/** Sets the fast polls done when a move is expected to be done.
+  * \param[in] donePollPeriod The time between polls; 0 selects a quarter of the moving poll period.
+  * \param[in] donePollCount The maximum number of fast polls per move; 0 disables them. */
+asynStatus asynMotorController::setDonePolls(double donePollPeriod, int donePollCount)
+{
+  lock();
+  donePollPeriod_ = donePollPeriod;
+  donePollCount_ = donePollCount;
+  unlock();
+  wakeupPoller();
+  return asynSuccess;
+}
+
+/** Restores the axis state from the snapshot file snapshotFile_.
+  * Sets the encoder ratio, limits and status of each axis in the parameter library to the values
+  * of the last snapshot, with the axis done and not moving, and does callbacks so that device
+  * support sees them before the first poll.  The position and encoder position are only restored
+  * for the axes in snapshotPositionAxes_: the position devMotorAsyn reads at init_record must
+  * otherwise come from the controller, or it would not load the autosaved position after the
+  * controller was power cycled.
+  * The restored axes are marked with a problem until the first poll verifies them; it reports
+  * axes whose controller position differs from the snapshot.
+  * Called with the lock held from startPoller(). */
+asynStatus asynMotorController::readSnapshot()
+{
+  size_t size = sizeof(snapshotHeader) + numAxes_ * sizeof(snapshotAxis);
+  snapshotHeader *pHeader;
+  snapshotAxis *pSnap;
+  asynMotorAxis *pAxis;
+  FILE *fp;
+  int axis, bit;
+  static const char *functionName = "readSnapshot";
+
+  if (!snapshot_) snapshot_ = calloc(1, size);
+  pHeader = (snapshotHeader *)snapshot_;
+  pSnap = (snapshotAxis *)(pHeader + 1);
+
+  fp = fopen(snapshotFile_, "rb");
+  if (!fp) {
+    asynPrint(this->pasynUserSelf, ASYN_TRACE_FLOW,
+      "%s:%s: no snapshot file %s\n", driverName, functionName, snapshotFile_);
+    memset(snapshot_, 0, size);
+    return asynError;
+  }
+  if ((fread(snapshot_, 1, size, fp) != size) ||
+      (strcmp(pHeader->magic, SNAPSHOT_MAGIC) != 0) ||
+      (pHeader->version != SNAPSHOT_VERSION) ||
+      (pHeader->numAxes != (epicsUInt32)numAxes_)) {
+    fclose(fp);
+    asynPrint(this->pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: %s is not a snapshot of %d axes, ignored\n",
+      driverName, functionName, snapshotFile_, numAxes_);
+    memset(snapshot_, 0, size);
+    return asynError;
+  }
+  fclose(fp);
+
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = getAxis(axis);
+    if (!pAxis || !pSnap[axis].valid) continue;
+    if ((axis < 32) && (snapshotPositionAxes_ & (1 << axis))) {
+      pAxis->setDoubleParam(motorPosition_, pSnap[axis].position);
+      pAxis->setDoubleParam(motorEncoderPosition_, pSnap[axis].encoderPosition);
+    }
+    setDoubleParam(axis, motorEncoderRatio_, pSnap[axis].encoderRatio);
+    setDoubleParam(axis, motorHighLimit_, pSnap[axis].highLimit);
+    setDoubleParam(axis, motorLowLimit_, pSnap[axis].lowLimit);
+    for (bit=0; bit<=motorStatusHomed_-motorStatusDirection_; bit++)
+      pAxis->setIntegerParam(motorStatusDirection_+bit, (pSnap[axis].status >> bit) & 1);
+    pAxis->setIntegerParam(motorStatusMoving_, 0);
+    pAxis->setIntegerParam(motorStatusDone_, 1);
+    pAxis->setIntegerParam(motorStatusProblem_, 1);
+    pAxis->callParamCallbacks();
+  }
+  snapshotVerify_ = 1;
+  asynPrint(this->pasynUserSelf, ASYN_TRACE_FLOW,
+    "%s:%s: restored %s\n", driverName, functionName, snapshotFile_);
+  return asynSuccess;
+}
+
+/** Writes the axis state to the snapshot file snapshotFile_.
+  * Called by the base class poller after each poll, without the lock held.  The file is
+  * written at most once every snapshotPeriod_ seconds, and only when the state of an axis
+  * has changed.  It is written to a temporary file which is then renamed, so a crash
+  * during the write leaves the previous snapshot intact. */
+asynStatus asynMotorController::writeSnapshot()
+{
+  size_t size = sizeof(snapshotHeader) + numAxes_ * sizeof(snapshotAxis);
+  snapshotHeader *pHeader;
+  snapshotAxis *pSnap, snap;
+  epicsTimeStamp now;
+  char tempFile[MAX_CONTROLLER_STRING_SIZE];
+  FILE *fp;
+  int axis, changed = 0;
+  static const char *functionName = "writeSnapshot";
+
+  epicsTimeGetCurrent(&now);
+  if (snapshot_ && epicsTimeDiffInSeconds(&now, &snapshotTime_) < snapshotPeriod_) return asynSuccess;
+  if (!snapshot_) snapshot_ = calloc(1, size);
+  pHeader = (snapshotHeader *)snapshot_;
+  pSnap = (snapshotAxis *)(pHeader + 1);
+  snapshotTime_ = now;
+
+  lock();
+  for (axis=0; axis<numAxes_; axis++) {
+    if (!getAxis(axis)) continue;
+    memset(&snap, 0, sizeof(snap));
+    getDoubleParam(axis, motorPosition_, &snap.position);
+    getDoubleParam(axis, motorEncoderPosition_, &snap.encoderPosition);
+    getDoubleParam(axis, motorEncoderRatio_, &snap.encoderRatio);
+    getDoubleParam(axis, motorHighLimit_, &snap.highLimit);
+    getDoubleParam(axis, motorLowLimit_, &snap.lowLimit);
+    getIntegerParam(axis, motorStatus_, (int *)&snap.status);
+    snap.valid = 1;
+    snap.time = pSnap[axis].time;
+    if (memcmp(&snap, &pSnap[axis], sizeof(snap)) != 0) {
+      snap.time = now;
+      pSnap[axis] = snap;
+      changed = 1;
+    }
+  }
+  unlock();
+  if (!changed) return asynSuccess;
+
+  strcpy(pHeader->magic, SNAPSHOT_MAGIC);
+  pHeader->version = SNAPSHOT_VERSION;
+  pHeader->numAxes = numAxes_;
+  pHeader->time = now;
+
+  epicsSnprintf(tempFile, sizeof(tempFile), "%s.tmp", snapshotFile_);
+  fp = fopen(tempFile, "wb");
+  if (!fp || (fwrite(snapshot_, 1, size, fp) != size)) {
+    if (fp) fclose(fp);
+    asynPrint(this->pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: error writing %s\n", driverName, functionName, tempFile);
+    return asynError;
+  }
+  fclose(fp);
+  if (rename(tempFile, snapshotFile_) != 0) {
+    /* rename() does not replace an existing file on all platforms */
+    remove(snapshotFile_);
+    if (rename(tempFile, snapshotFile_) != 0) {
+      asynPrint(this->pasynUserSelf, ASYN_TRACE_ERROR,
+        "%s:%s: error renaming %s to %s\n", driverName, functionName, tempFile, snapshotFile_);
+      return asynError;
+    }
   }
+  return asynSuccess;
 }
 
 /**
  * Start the thread which deals with moving axes to their home position.
  * This is called by the derived concrete controller class at object instatiation, so
  * that drivers that don't need this functionality don't have the overhead of the thread.
+ * setMoveToHomeConcurrency() starts further threads to home several axes at once.
  */
 asynStatus asynMotorController::startMoveToHomeThread()
 {
-  epicsThreadCreate("motorMoveToHome", 
+  char threadName[32];
+
+  lock();
+  if (moveToHomeThreads_ == 0)
+    strcpy(threadName, "motorMoveToHome");
+  else
+    epicsSnprintf(threadName, sizeof(threadName), "motorMoveToHome%d", moveToHomeThreads_);
+  moveToHomeThreads_++;
+  unlock();
+  epicsThreadCreate(threadName, 
                     epicsThreadPriorityMedium,
                     epicsThreadGetStackSize(epicsThreadStackMedium),
                     (EPICSTHREADFUNC)asynMotorMoveToHomeC, (void *)this);
@@ -714,30 +1195,146 @@ static void asynMotorMoveToHomeC(void *drvPvt)
   pController->asynMotorMoveToHome();
 }
 
+/** Sets the maximum number of axes that move to home at the same time.
+  * Starts more move to home threads if needed; does nothing to a controller that
+  * has not called startMoveToHomeThread(), since it does not support moveToHome.
+  * Axes of one controller that must not home together should keep the default of 1.
+  * \param[in] maxActive The maximum number of axes homing at once, 1 to numAxes_. */
+asynStatus asynMotorController::setMoveToHomeConcurrency(int maxActive)
+{
+  int threads;
+
+  if ((maxActive < 1) || (maxActive > numAxes_)) return asynError;
+  lock();
+  moveToHomeMaxActive_ = maxActive;
+  threads = moveToHomeThreads_;
+  unlock();
+  if (threads == 0) return asynError;
+  for (; threads < maxActive; threads++)
+    startMoveToHomeThread();
+  /* Waiting axes may now start */
+  epicsEventSignal(moveToHomeId_);
+  return asynSuccess;
+}
+
+/** Sets the queue position of each axis and does callbacks for all axes.
+  * The position is 1 for the next axis to home and 0 for axes that are not queued.
+  * Called with the lock held. */
+void asynMotorController::updateMoveToHomeQueue()
+{
+  int axis, i;
+
+  for (axis=0; axis<numAxes_; axis++)
+    setIntegerParam(axis, motorMoveToHomeQueue_, 0);
+  for (i=0; i<moveToHomeQueued_; i++)
+    setIntegerParam(moveToHomeQueue_[i], motorMoveToHomeQueue_, i+1);
+  for (axis=0; axis<numAxes_; axis++)
+    callParamCallbacks(axis);
+}
+
+/** Adds an axis to the move to home queue and wakes up a move to home thread.
+  * Requests for an axis that is already queued or homing are ignored.
+  * Called with the lock held from writeInt32().
+  * \param[in] axis The axis to move to home. */
+asynStatus asynMotorController::queueMoveToHome(int axis)
+{
+  int state;
+  static const char *functionName = "queueMoveToHome";
+
+  if (moveToHomeThreads_ == 0) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: move to home is not supported by this controller. Axis number=%d\n",
+      driverName, functionName, axis);
+    return asynError;
+  }
+  getIntegerParam(axis, motorMoveToHomeState_, &state);
+  if ((state == MOVE_TO_HOME_QUEUED) || (state == MOVE_TO_HOME_ACTIVE)) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+      "%s:%s: axis %d is already queued or moving to home\n",
+      driverName, functionName, axis);
+    return asynSuccess;
+  }
+  moveToHomeQueue_[moveToHomeQueued_++] = axis;
+  setIntegerParam(axis, motorMoveToHomeState_, MOVE_TO_HOME_QUEUED);
+  updateMoveToHomeQueue();
+  epicsEventSignal(moveToHomeId_);
+  return asynSuccess;
+}
+
+/** Removes an axis from the move to home queue.
+  * An axis that is already homing is not affected; it is stopped with motorStop_.
+  * Called with the lock held from writeInt32().
+  * \param[in] axis The axis to remove. */
+asynStatus asynMotorController::cancelMoveToHome(int axis)
+{
+  int i;
+
+  for (i=0; i<moveToHomeQueued_; i++) {
+    if (moveToHomeQueue_[i] == axis) break;
+  }
+  if (i == moveToHomeQueued_) return asynSuccess;
+  for (moveToHomeQueued_--; i<moveToHomeQueued_; i++)
+    moveToHomeQueue_[i] = moveToHomeQueue_[i+1];
+  setIntegerParam(axis, motorMoveToHomeState_, MOVE_TO_HOME_IDLE);
+  updateMoveToHomeQueue();
+  return asynSuccess;
+}
 
 
 /**
  * Default move to home thread. Not normally overridden.
+ * Each thread takes the oldest queued axis while fewer than moveToHomeMaxActive_ axes
+ * are homing, and calls its doMoveToHome() without the lock held. The thread is busy
+ * until doMoveToHome() returns, so the concurrency limit applies to drivers whose
+ * doMoveToHome() waits for the axis to reach home.
  */
 void asynMotorController::asynMotorMoveToHome()
 {
   
   asynMotorAxis *pAxis;
   int status = 0;
+  int axis, i;
+  epicsTimeStamp start, end;
   static const char *functionName = "asynMotorMoveToHome";
 
   while(1) {
     status = epicsEventWait(moveToHomeId_);
-    if (status == epicsEventWaitOK) { 
-      pAxis = getAxis(this->moveToHomeAxis_);
-      if (!pAxis) continue;
-      status = pAxis->doMoveToHome();
-      if (status) {
+    if (status != epicsEventWaitOK) continue;
+    lock();
+    if ((moveToHomeQueued_ == 0) || (moveToHomeActive_ >= moveToHomeMaxActive_)) {
+      unlock();
+      continue;
+    }
+    axis = moveToHomeQueue_[0];
+    for (moveToHomeQueued_--, i=0; i<moveToHomeQueued_; i++)
+      moveToHomeQueue_[i] = moveToHomeQueue_[i+1];
+    moveToHomeActive_++;
+    moveToHomeAxis_ = axis;
+    setIntegerParam(axis, motorMoveToHomeState_, MOVE_TO_HOME_ACTIVE);
+    updateMoveToHomeQueue();
+    /* Pass the remaining work on to another thread */
+    if ((moveToHomeQueued_ > 0) && (moveToHomeActive_ < moveToHomeMaxActive_))
+      epicsEventSignal(moveToHomeId_);
+    unlock();
+
+    epicsTimeGetCurrent(&start);
+    pAxis = getAxis(axis);
+    status = pAxis ? pAxis->doMoveToHome() : asynError;
+    epicsTimeGetCurrent(&end);
+    if (status) {
       asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
         "%s:%s: move to home failed in asynMotorController::asynMotorMoveToHome. Axis number=%d\n", 
-        driverName, functionName, this->moveToHomeAxis_);
-      }
-    } 
+        driverName, functionName, axis);
+    }
+
+    lock();
+    moveToHomeActive_--;
+    setIntegerParam(axis, motorMoveToHomeState_, status ? MOVE_TO_HOME_FAILED : MOVE_TO_HOME_DONE);
+    setDoubleParam(axis, motorMoveToHomeTime_, epicsTimeDiffInSeconds(&end, &start));
+    callParamCallbacks(axis);
+    if (moveToHomeQueued_ > 0)
+      epicsEventSignal(moveToHomeId_);
+    unlock();
   } 
 }
 
@@ -797,25 +1394,300 @@ asynStatus asynMotorController::writeReadController(const char *output, char *in
 
 
 /* These are the functions for profile moves */
-/** Initialize a profile move of multiple axes. */
+/** Initialize a profile move of multiple axes.
+  * Allocates the arrays of each of the numProfileSlots_ profile slots and selects slot 0. */
 asynStatus asynMotorController::initializeProfile(size_t maxProfilePoints)
 {
-  int axis;
+  int axis, slot;
   asynMotorAxis *pAxis;
   // static const char *functionName = "initializeProfile";
   
+  freeProfileSlots();
   maxProfilePoints_ = maxProfilePoints;
-  if (profileTimes_) free(profileTimes_);
-  profileTimes_ = (double *)calloc(maxProfilePoints, sizeof(double));
+  free(profileInverseTimes_);
+  profileInverseTimes_ = (double *)calloc(maxProfilePoints, sizeof(double));
+  free(profileSegmentVelocities_);
+  profileSegmentVelocities_ = (double *)calloc(maxProfilePoints, sizeof(double));
+  free(profileAccelerations_);
+  profileAccelerations_ = (double *)calloc(maxProfilePoints, sizeof(double));
+  profileSlots_ = (asynMotorProfileSlot *)calloc(numProfileSlots_, sizeof(asynMotorProfileSlot));
   for (axis=0; axis<numAxes_; axis++) {
     pAxis = getAxis(axis);
     if (!pAxis) continue;
-    pAxis->initializeProfile(maxProfilePoints);
+    pAxis->profileSlots_ = (asynMotorAxisProfileSlot *)calloc(numProfileSlots_, sizeof(asynMotorAxisProfileSlot));
+  }
+  // Loading an empty slot clears the members, which the allocations below then fill
+  for (slot=0; slot<numProfileSlots_; slot++) {
+    loadProfileSlot(slot);
+    profileTimes_ = (double *)calloc(maxProfilePoints, sizeof(double));
+    for (axis=0; axis<numAxes_; axis++) {
+      pAxis = getAxis(axis);
+      if (!pAxis) continue;
+      pAxis->initializeProfile(maxProfilePoints);
+    }
+    storeProfileSlot();
+  }
+  loadProfileSlot(0);
+  buildSlot_ = executeSlot_ = readbackSlot_ = 0;
+  setIntegerParam(profileNumSlots_, numProfileSlots_);
+  setIntegerParam(profileBuildSlot_, 0);
+  setIntegerParam(profileExecuteSlot_, 0);
+  setIntegerParam(profileReadbackSlot_, 0);
+  return asynSuccess;
+}
+
+/** Copies the profile arrays in the members, and the parameters saved by buildProfile(), into the slot profileSlot_. */
+void asynMotorController::storeProfileSlot()
+{
+  asynMotorProfileSlot *pSlot = &profileSlots_[profileSlot_];
+  asynMotorAxisProfileSlot *pAxisSlot;
+  asynMotorAxis *pAxis;
+  int axis;
+
+  pSlot->times            = profileTimes_;
+  pSlot->pulseTimes       = pulseTimes_;
+  pSlot->actualPulseTimes = actualPulseTimes_;
+  pSlot->maxPulses        = maxProfilePulses_;
+  pSlot->numPulses        = numProfilePulses_;
+  pSlot->maxSamples       = maxProfileSamples_;
+  pSlot->numSamples       = numProfileSamples_;
+  pSlot->numPoints        = numProfilePoints_;
+  pSlot->moveMode         = builtMoveMode_;
+  pSlot->pulseMode        = builtPulseMode_;
+  pSlot->startPulses      = builtStartPulses_;
+  pSlot->endPulses        = builtEndPulses_;
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = pAxes_[axis];
+    if (!pAxis || !pAxis->profileSlots_) continue;
+    pAxisSlot = &pAxis->profileSlots_[profileSlot_];
+    pAxisSlot->positions        = pAxis->profilePositions_;
+    pAxisSlot->readbacks        = pAxis->profileReadbacks_;
+    pAxisSlot->followingErrors  = pAxis->profileFollowingErrors_;
+    pAxisSlot->pulsePositions   = pAxis->profilePulsePositions_;
+    pAxisSlot->velocities       = pAxis->profileVelocities_;
+    pAxisSlot->samplePositions  = pAxis->profileSamplePositions_;
+    pAxisSlot->sampleVelocities = pAxis->profileSampleVelocities_;
+    pAxisSlot->useAxis          = pAxis->builtUseAxis_;
+  }
+}
+
+/** Copies the profile arrays of a slot into the members and makes it profileSlot_.
+  * \param[in] slot The slot. */
+void asynMotorController::loadProfileSlot(int slot)
+{
+  asynMotorProfileSlot *pSlot = &profileSlots_[slot];
+  asynMotorAxisProfileSlot *pAxisSlot;
+  asynMotorAxis *pAxis;
+  int axis;
+
+  profileTimes_      = pSlot->times;
+  pulseTimes_        = pSlot->pulseTimes;
+  actualPulseTimes_  = pSlot->actualPulseTimes;
+  maxProfilePulses_  = pSlot->maxPulses;
+  numProfilePulses_  = pSlot->numPulses;
+  maxProfileSamples_ = pSlot->maxSamples;
+  numProfileSamples_ = pSlot->numSamples;
+  numProfilePoints_  = pSlot->numPoints;
+  builtMoveMode_     = pSlot->moveMode;
+  builtPulseMode_    = pSlot->pulseMode;
+  builtStartPulses_  = pSlot->startPulses;
+  builtEndPulses_    = pSlot->endPulses;
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = pAxes_[axis];
+    if (!pAxis || !pAxis->profileSlots_) continue;
+    pAxisSlot = &pAxis->profileSlots_[slot];
+    pAxis->profilePositions_        = pAxisSlot->positions;
+    pAxis->profileReadbacks_        = pAxisSlot->readbacks;
+    pAxis->profileFollowingErrors_  = pAxisSlot->followingErrors;
+    pAxis->profilePulsePositions_   = pAxisSlot->pulsePositions;
+    pAxis->profileVelocities_       = pAxisSlot->velocities;
+    pAxis->profileSamplePositions_  = pAxisSlot->samplePositions;
+    pAxis->profileSampleVelocities_ = pAxisSlot->sampleVelocities;
+    pAxis->builtUseAxis_            = pAxisSlot->useAxis;
+  }
+  profileSlot_ = slot;
+}
+
+/** Frees the arrays of all profile slots; the members are left NULL. */
+void asynMotorController::freeProfileSlots()
+{
+  asynMotorAxis *pAxis;
+  int axis, slot;
+
+  if (!profileSlots_) return;
+  storeProfileSlot();
+  for (slot=0; slot<numProfileSlots_; slot++) {
+    loadProfileSlot(slot);
+    free(profileTimes_);
+    free(pulseTimes_);
+    free(actualPulseTimes_);
+    for (axis=0; axis<numAxes_; axis++) {
+      pAxis = pAxes_[axis];
+      if (!pAxis || !pAxis->profileSlots_) continue;
+      free(pAxis->profilePositions_);
+      free(pAxis->profileReadbacks_);
+      free(pAxis->profileFollowingErrors_);
+      free(pAxis->profilePulsePositions_);
+      free(pAxis->profileVelocities_);
+      free(pAxis->profileSamplePositions_);
+      free(pAxis->profileSampleVelocities_);
+    }
+  }
+  // Clear every slot so that loading one leaves no freed pointers in the members
+  memset(profileSlots_, 0, numProfileSlots_*sizeof(asynMotorProfileSlot));
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = pAxes_[axis];
+    if (!pAxis || !pAxis->profileSlots_) continue;
+    memset(pAxis->profileSlots_, 0, numProfileSlots_*sizeof(asynMotorAxisProfileSlot));
+  }
+  loadProfileSlot(0);
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = pAxes_[axis];
+    if (!pAxis) continue;
+    free(pAxis->profileSlots_);
+    pAxis->profileSlots_ = NULL;
+  }
+  free(profileSlots_);
+  profileSlots_ = NULL;
+}
+
+/** Sets the number of profile slots.
+  * With more than one slot a profile can be defined and built in the build slot while the profile
+  * in the execute slot runs and the one in the readback slot is read back; see swapProfileSlots().
+  * Reallocates the profile arrays, so this should be called at startup.
+  * \param[in] numSlots The number of slots; 1, the default, gives a single set of profile arrays. */
+asynStatus asynMotorController::setProfileSlots(int numSlots)
+{
+  if (numSlots < 1) return asynError;
+  lock();
+  freeProfileSlots();
+  numProfileSlots_ = numSlots;
+  if (maxProfilePoints_ > 0) initializeProfile(maxProfilePoints_);
+  else setIntegerParam(profileNumSlots_, numSlots);
+  callParamCallbacks();
+  unlock();
+  return asynSuccess;
+}
+
+/** Makes the arrays of a profile slot the ones in the members, profileTimes_, pulseTimes_,
+  * the profile arrays of each axis and so on, and returns the slot that was selected.
+  * The members are normally those of the build slot, so that array writes, buildProfile() and
+  * the driver functions it calls use the build slot without knowing about slots.
+  * Code that runs for another slot selects it and then restores the previous slot, with the lock held:
+  * \code
+  *   slot = selectProfileSlot(readbackSlot_);
+  *   ...
+  *   selectProfileSlot(slot);
+  * \endcode
+  * Only pointers are copied, so this is cheap.
+  * Drivers that execute profiles asynchronously, from their own thread or poller, must use
+  * selectExecuteSlot() in that code; the members there would otherwise be those of the next
+  * profile being built.
+  * \param[in] slot The slot to select. */
+int asynMotorController::selectProfileSlot(int slot)
+{
+  int previous = profileSlot_;
+
+  if (!profileSlots_ || (slot == profileSlot_) || (slot < 0) || (slot >= numProfileSlots_)) return previous;
+  storeProfileSlot();
+  loadProfileSlot(slot);
+  return previous;
+}
+
+/** Selects the execute slot, the one whose profile is executing, and returns the slot that was selected.
+  * Use this in code that reads the profile arrays while a profile executes, such as the thread or poller
+  * of a driver that executes profiles asynchronously, and restore the previous slot afterwards:
+  * \code
+  *   lock();
+  *   slot = selectExecuteSlot();
+  *   ...
+  *   selectProfileSlot(slot);
+  *   unlock();
+  * \endcode */
+int asynMotorController::selectExecuteSlot()
+{
+  return selectProfileSlot(executeSlot_);
+}
+
+/** Sets the build, execute or readback slot from writeInt32().
+  * The execute slot cannot change during a profile, and the build slot cannot be the executing slot.
+  * \param[in] function profileBuildSlot_, profileExecuteSlot_ or profileReadbackSlot_.
+  * \param[in] slot The new slot. */
+asynStatus asynMotorController::setProfileSlot(int function, int slot)
+{
+  int executeState;
+  int *pSlot;
+  const char *message = NULL;
+  static const char *functionName = "setProfileSlot";
+
+  pSlot = (function == profileBuildSlot_)   ? &buildSlot_ :
+          (function == profileExecuteSlot_) ? &executeSlot_ : &readbackSlot_;
+  if (slot == *pSlot) return asynSuccess;
+  getIntegerParam(profileExecuteState_, &executeState);
+  if ((slot < 0) || (slot >= numProfileSlots_))
+    message = "slot out of range";
+  else if ((executeState != PROFILE_EXECUTE_DONE) && (function == profileExecuteSlot_))
+    message = "cannot change the execute slot during a profile";
+  else if ((executeState != PROFILE_EXECUTE_DONE) && (function == profileBuildSlot_) && (slot == executeSlot_))
+    message = "cannot build in the slot that is executing";
+  if (message) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: slot %d: %s\n", driverName, functionName, slot, message);
+    setIntegerParam(function, *pSlot);
+    return asynError;
+  }
+  *pSlot = slot;
+  if (function == profileBuildSlot_) selectProfileSlot(slot);
+  return asynSuccess;
+}
+
+/** Swaps the profile slots so that the profile just built runs next.
+  * The readback slot becomes the previous execute slot, the execute slot becomes the build slot,
+  * and the build slot moves on to the next slot, so with 3 or more slots the next profile is built,
+  * the current one executed and the previous one read back in different slots.
+  * With 2 slots the readbacks of the previous profile are kept while the next one is built in its slot.
+  * The swap is done with the lock held so drivers and clients never see a partial swap.
+  * Fails during a profile, or with more than one slot if the build slot has not been built. */
+asynStatus asynMotorController::swapProfileSlots()
+{
+  int executeState;
+  static const char *functionName = "swapProfileSlots";
+
+  setIntegerParam(profileSwapSlots_, 0);
+  getIntegerParam(profileExecuteState_, &executeState);
+  if (executeState != PROFILE_EXECUTE_DONE) {
+    setStringParam(profileExecuteMessage_, "Cannot swap profile slots during a profile");
+    return asynError;
+  }
+  if ((numProfileSlots_ > 1) && (numProfilePoints_ == 0)) {
+    setStringParam(profileExecuteMessage_, "Build slot has not been built");
+    return asynError;
   }
+  readbackSlot_ = executeSlot_;
+  executeSlot_ = buildSlot_;
+  buildSlot_ = (buildSlot_ + 1) % numProfileSlots_;
+  selectProfileSlot(buildSlot_);
+  // The new build slot must be built again before it can be swapped in
+  if (numProfileSlots_ > 1) numProfilePoints_ = 0;
+  setIntegerParam(profileBuildSlot_, buildSlot_);
+  setIntegerParam(profileExecuteSlot_, executeSlot_);
+  setIntegerParam(profileReadbackSlot_, readbackSlot_);
+  asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+    "%s:%s: build slot %d, execute slot %d, readback slot %d\n",
+    driverName, functionName, buildSlot_, executeSlot_, readbackSlot_);
   return asynSuccess;
 }
   
-/** Build a profile move of multiple axes. */
+/** Build a profile move of multiple axes.
+  * Fills profileTimes_ in fixed time mode, checks the profile with validateProfile(),
+  * computes the velocities and samples with prepareProfile() and checks them with validatePreparedProfile(),
+  * builds the pulse schedule and calls buildProfile() of each axis.
+  * All of these use the build slot.  Sets numProfilePoints_, and the build message on failure.
+  * Saves profileMoveMode_, profilePulseMode_, profileStartPulses_, profileEndPulses_ and the profileUseAxis_
+  * of each axis in the build slot, so that executing the profile uses them as they were built while they are
+  * changed for the next one; code that executes the profile reads builtUseAxis_ and so on, not the parameters.
+  * Derived classes that build their own profile call this first and return its status if it fails.
+  * writeInt32() sets the build state and status when this returns, so it must not return before the build is complete. */
 asynStatus asynMotorController::buildProfile()
 {
   //static const char *functionName = "buildProfile";
@@ -829,19 +1701,282 @@ asynStatus asynMotorController::buildProfile()
   status |= getIntegerParam(profileTimeMode_, &timeMode);
   status |= getDoubleParam(profileFixedTime_, &time);
   status |= getIntegerParam(profileNumPoints_, &numPoints);
+  status |= getIntegerParam(profileMoveMode_, &builtMoveMode_);
+  status |= getIntegerParam(profilePulseMode_, &builtPulseMode_);
+  status |= getIntegerParam(profileStartPulses_, &builtStartPulses_);
+  status |= getIntegerParam(profileEndPulses_, &builtEndPulses_);
   if (status) return asynError;
+  for (i=0; i<numAxes_; i++) {
+    pAxis = getAxis(i);
+    if (pAxis) getIntegerParam(i, profileUseAxis_, &pAxis->builtUseAxis_);
+  }
   if (timeMode == PROFILE_TIME_MODE_FIXED) {
     memset(profileTimes_, 0, maxProfilePoints_*sizeof(double));
     for (i=0; i<numPoints; i++) {
       profileTimes_[i] = time;
     }
   }
-  for (i=0; i<numAxes_; i++) {
-    pAxis = getAxis(i);
-    if (!pAxis) continue;
-    pAxis->buildProfile();
+  status = validateProfile();
+  if (status == asynSuccess) status = prepareProfile();
+  if (status == asynSuccess) status = validatePreparedProfile();
+  if (status == asynSuccess) status = buildPulseSchedule();
+  if (status == asynSuccess) {
+    for (i=0; i<numAxes_; i++) {
+      pAxis = getAxis(i);
+      if (!pAxis) continue;
+      pAxis->buildProfile();
+    }
+    status = loadProfilePulses();
   }
-  return asynSuccess;
+  numProfilePoints_ = status ? 0 : numPoints;
+  return status ? asynError : asynSuccess;
+}
+
+/** Checks a profile against the velocity, acceleration and soft limits of its axes.
+  * For each axis in the profile trajectoryCheckLimits() computes the velocity of every segment and
+  * the acceleration at every point in whole-array passes, using the times in profileTimes_ and the
+  * positions in controller units; it also checks the ramps to and from rest over profileAcceleration_ seconds.
+  * Axes are checked against profileMaxVelocity_ and profileMaxAcceleration_ (user units; 0 disables
+  * the check), and against motorLowLimit_ and motorHighLimit_ unless both are 0.
+  * Sets profileBadPoint_ to the first point (numbered from 1) that exceeds a limit and
+  * profileTimeScale_ to the factor by which all times must be multiplied to satisfy the velocity
+  * and acceleration limits.  Soft limits are only checked for absolute profiles.
+  * If profileAutoScale_ is set, the times are multiplied by that factor.
+  * Returns asynError, with profileBuildMessage_ set, if the profile cannot be executed.
+  * Called with the lock held from buildProfile(). */
+asynStatus asynMotorController::validateProfile()
+{
+  int numPoints, numSegments;
+  int autoScale, moveMode;
+  int axis, i, k, point, limit;
+  int badPoint = 0, badAxis = -1;
+  const char *badLimit = "";
+  double accelTime, resolution, maxVelocity, maxAccel, highLimit, lowLimit;
+  double required, scale = 1.;
+  double *positions;
+  asynMotorAxis *pAxis;
+  char message[MAX_CONTROLLER_STRING_SIZE];
+  static const char *functionName = "validateProfile";
+
+  getIntegerParam(profileNumPoints_, &numPoints);
+  getIntegerParam(profileAutoScale_, &autoScale);
+  moveMode = builtMoveMode_;
+  getDoubleParam(profileAcceleration_, &accelTime);
+  setIntegerParam(profileBadPoint_, 0);
+  setDoubleParam(profileTimeScale_, 1.);
+  setStringParam(profileBuildMessage_, " ");
+
+  if ((numPoints < 1) || ((size_t)numPoints > maxProfilePoints_)) {
+    epicsSnprintf(message, sizeof(message), "Number of points %d outside range 1 to %d",
+                  numPoints, (int)maxProfilePoints_);
+    setStringParam(profileBuildMessage_, message);
+    return asynError;
+  }
+  numSegments = numPoints - 1;
+
+  for (k=0; k<numSegments; k++) {
+    if (profileTimes_[k] <= 0.) {
+      epicsSnprintf(message, sizeof(message), "Time of point %d is not positive", k+1);
+      setStringParam(profileBuildMessage_, message);
+      setIntegerParam(profileBadPoint_, k+1);
+      return asynError;
+    }
+  }
+  for (k=0; k<numSegments; k++) profileInverseTimes_[k] = 1./profileTimes_[k];
+
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = getAxis(axis);
+    if (!pAxis || !pAxis->builtUseAxis_) continue;
+    getDoubleParam(axis, motorRecResolution_, &resolution);
+    getDoubleParam(axis, profileMaxVelocity_, &maxVelocity);
+    getDoubleParam(axis, profileMaxAcceleration_, &maxAccel);
+    getDoubleParam(axis, motorHighLimit_, &highLimit);
+    getDoubleParam(axis, motorLowLimit_, &lowLimit);
+    positions = pAxis->profilePositions_;
+
+    // Soft limits; time scaling cannot fix these.  Relative profiles are not known until they start.
+    if ((moveMode == PROFILE_MOVE_MODE_ABSOLUTE) && ((highLimit != 0.) || (lowLimit != 0.))) {
+      for (i=0; i<numPoints; i++) {
+        if ((positions[i] > highLimit) || (positions[i] < lowLimit)) {
+          epicsSnprintf(message, sizeof(message), "Axis %d point %d is outside the soft limits",
+                        axis, i+1);
+          setStringParam(profileBuildMessage_, message);
+          setIntegerParam(profileBadPoint_, i+1);
+          return asynError;
+        }
+      }
+    }
+    if ((numSegments < 1) || (resolution == 0.)) continue;
+
+    // Limits in controller units
+    required = trajectoryCheckLimits(numPoints, profileTimes_, profileInverseTimes_, positions,
+                                     maxVelocity / fabs(resolution), maxAccel / fabs(resolution), accelTime,
+                                     profileSegmentVelocities_, profileAccelerations_, &point, &limit);
+    if (required > scale) scale = required;
+    if (point && ((badAxis < 0) || (point < badPoint))) {
+      badPoint = point; badAxis = axis;
+      badLimit = (limit == TRAJECTORY_LIMIT_VELOCITY) ? "velocity" : "acceleration";
+    }
+  }
+
+  if (badAxis < 0) return asynSuccess;
+
+  setIntegerParam(profileBadPoint_, badPoint);
+  setDoubleParam(profileTimeScale_, scale);
+  asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+    "%s:%s: axis %d exceeds its %s limit at point %d, time scale %f\n",
+    driverName, functionName, badAxis, badLimit, badPoint, scale);
+  if (autoScale) {
+    for (k=0; k<numSegments; k++) profileTimes_[k] *= scale;
+    epicsSnprintf(message, sizeof(message), "Times scaled by %.4f for axis %d %s limit at point %d",
+                  scale, badAxis, badLimit, badPoint);
+    setStringParam(profileBuildMessage_, message);
+    return asynSuccess;
+  }
+  epicsSnprintf(message, sizeof(message), "Axis %d exceeds %s limit at point %d; scale times by %.4f",
+                badAxis, badLimit, badPoint, scale);
+  setStringParam(profileBuildMessage_, message);
+  return asynError;
+}
+
+/* Returns the profile point (numbered from 1) at the start of the segment that contains time */
+static int pointAtTime(const double *times, int numPoints, double time)
+{
+  int k;
+  double segmentStart = 0.;
+
+  for (k=0; k<numPoints-2; k++) {
+    if (time < segmentStart + times[k]) break;
+    segmentStart += times[k];
+  }
+  return k+1;
+}
+
+/** Checks the path that prepareProfile() computed against the limits of its axes.
+  * validateProfile() only sees the points; this checks what the controller will execute.
+  * With PROFILE_FIT_MODE_CUBIC the spline can overshoot between the points, so every segment is checked
+  * with trajectorySegmentExtremes().  If the path was resampled, the samples are checked too, with the
+  * acceleration from one sample to the next over profileSegmentTime_.
+  * The limits are those of validateProfile(), which sets profileBadPoint_ and profileTimeScale_ the same way.
+  * If profileAutoScale_ is set, the times are multiplied by the time scale and prepareProfile() is called again.
+  * Called with the lock held from buildProfile(), after prepareProfile(). */
+asynStatus asynMotorController::validatePreparedProfile()
+{
+  int numPoints, fitMode, autoScale, moveMode;
+  int axis, k, point;
+  int badPoint = 0, badAxis = -1;
+  const char *badLimit = "";
+  bool checkLimits;
+  double segmentTime, resolution, maxVelocity, maxAccel, highLimit, lowLimit;
+  double minPos, maxPos, peakVelocity, peakAccel, required, previousScale, scale = 1.;
+  double *positions, *velocities;
+  asynMotorAxis *pAxis;
+  char message[MAX_CONTROLLER_STRING_SIZE];
+  static const char *functionName = "validatePreparedProfile";
+
+  getIntegerParam(profileNumPoints_, &numPoints);
+  getIntegerParam(profileFitMode_, &fitMode);
+  getIntegerParam(profileAutoScale_, &autoScale);
+  moveMode = builtMoveMode_;
+  getDoubleParam(profileSegmentTime_, &segmentTime);
+  if ((fitMode != PROFILE_FIT_MODE_CUBIC) && (numProfileSamples_ == 0)) return asynSuccess;
+
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = getAxis(axis);
+    if (!pAxis || !pAxis->profileVelocities_ || !pAxis->builtUseAxis_) continue;
+    getDoubleParam(axis, motorRecResolution_, &resolution);
+    getDoubleParam(axis, profileMaxVelocity_, &maxVelocity);
+    getDoubleParam(axis, profileMaxAcceleration_, &maxAccel);
+    getDoubleParam(axis, motorHighLimit_, &highLimit);
+    getDoubleParam(axis, motorLowLimit_, &lowLimit);
+    checkLimits = (moveMode == PROFILE_MOVE_MODE_ABSOLUTE) && ((highLimit != 0.) || (lowLimit != 0.));
+    if (resolution == 0.) {
+      maxVelocity = maxAccel = 0.;
+    } else {
+      maxVelocity /= fabs(resolution);
+      maxAccel /= fabs(resolution);
+    }
+
+    if (fitMode == PROFILE_FIT_MODE_CUBIC) {
+      positions = pAxis->profilePositions_;
+      velocities = pAxis->profileVelocities_;
+      for (k=0; k<numPoints-1; k++) {
+        trajectorySegmentExtremes(profileTimes_[k], positions[k], velocities[k], positions[k+1], velocities[k+1],
+                                  &minPos, &maxPos, &peakVelocity, &peakAccel);
+        if (checkLimits && ((maxPos > highLimit) || (minPos < lowLimit))) {
+          epicsSnprintf(message, sizeof(message), "Axis %d spline after point %d is outside the soft limits",
+                        axis, k+1);
+          setStringParam(profileBuildMessage_, message);
+          setIntegerParam(profileBadPoint_, k+1);
+          return asynError;
+        }
+        required = 1.;
+        if ((maxVelocity > 0.) && (peakVelocity > maxVelocity)) {
+          required = peakVelocity / maxVelocity;
+          if ((badAxis < 0) || (k+1 < badPoint)) {
+            badPoint = k+1; badAxis = axis; badLimit = "spline velocity";
+          }
+        }
+        if ((maxAccel > 0.) && (peakAccel > maxAccel)) {
+          if (sqrt(peakAccel / maxAccel) > required) required = sqrt(peakAccel / maxAccel);
+          if ((badAxis < 0) || (k+1 < badPoint)) {
+            badPoint = k+1; badAxis = axis; badLimit = "spline acceleration";
+          }
+        }
+        if (required > scale) scale = required;
+      }
+    }
+
+    if (numProfileSamples_ == 0) continue;
+    positions = pAxis->profileSamplePositions_;
+    velocities = pAxis->profileSampleVelocities_;
+    for (k=0; k<(int)numProfileSamples_; k++) {
+      if (checkLimits && ((positions[k] > highLimit) || (positions[k] < lowLimit))) {
+        point = pointAtTime(profileTimes_, numPoints, k*segmentTime);
+        epicsSnprintf(message, sizeof(message), "Axis %d sample %d after point %d is outside the soft limits",
+                      axis, k+1, point);
+        setStringParam(profileBuildMessage_, message);
+        setIntegerParam(profileBadPoint_, point);
+        return asynError;
+      }
+      required = 1.;
+      if ((maxVelocity > 0.) && (fabs(velocities[k]) > maxVelocity))
+        required = fabs(velocities[k]) / maxVelocity;
+      // The velocity changes by this step in one segment time; scaling the times reduces it linearly
+      if ((maxAccel > 0.) && (k > 0)) {
+        peakAccel = fabs(velocities[k] - velocities[k-1]) / segmentTime;
+        if (peakAccel / maxAccel > required) required = peakAccel / maxAccel;
+      }
+      if (required <= 1.) continue;
+      if (required > scale) scale = required;
+      point = pointAtTime(profileTimes_, numPoints, k*segmentTime);
+      if ((badAxis < 0) || (point < badPoint)) {
+        badPoint = point; badAxis = axis; badLimit = "sample velocity or acceleration";
+      }
+    }
+  }
+
+  if (badAxis < 0) return asynSuccess;
+
+  // validateProfile() may already have scaled the times
+  getDoubleParam(profileTimeScale_, &previousScale);
+  setIntegerParam(profileBadPoint_, badPoint);
+  setDoubleParam(profileTimeScale_, previousScale * scale);
+  asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+    "%s:%s: axis %d exceeds its %s limit at point %d, time scale %f\n",
+    driverName, functionName, badAxis, badLimit, badPoint, scale);
+  if (autoScale) {
+    for (k=0; k<numPoints-1; k++) profileTimes_[k] *= scale;
+    if (prepareProfile()) return asynError;
+    epicsSnprintf(message, sizeof(message), "Times scaled by %.4f for axis %d %s limit at point %d",
+                  previousScale * scale, badAxis, badLimit, badPoint);
+    setStringParam(profileBuildMessage_, message);
+    return asynSuccess;
+  }
+  epicsSnprintf(message, sizeof(message), "Axis %d exceeds %s limit at point %d; scale times by %.4f",
+                badAxis, badLimit, badPoint, scale);
+  setStringParam(profileBuildMessage_, message);
+  return asynError;
 }
 
 /** Execute a profile move of multiple axes. */
@@ -889,6 +2024,454 @@ asynStatus asynMotorController::readbackProfile()
   return asynSuccess;
 }
 
+/** Builds the output pulse schedule of a profile move.
+  * profileNumPulses_ pulses are spaced evenly in time from profile point profileStartPulses_
+  * to point profileEndPulses_ (numbered from 1), so the first and last pulses are at those points.
+  * profileTimes_[i] is the time from point i to point i+1.
+  * Computes the time of each pulse from the start of the profile in pulseTimes_ with trajectoryPulseTimes() and,
+  * with trajectoryInterpolate(), by linear interpolation between the profile points, the position of each axis
+  * in the profile at each pulse in its profilePulsePositions_, in controller units; with PROFILE_FIT_MODE_CUBIC
+  * the positions are on the spline computed by prepareProfile().
+  * Drivers load these into time or position compare hardware in loadProfilePulses().
+  * Called with the lock held from buildProfile(), after the times and positions are defined. */
+asynStatus asynMotorController::buildPulseSchedule()
+{
+  int numPulses, startPulses, endPulses, numPoints, fitMode;
+  int *useAxis;
+  double period;
+  double *buffer;
+  asynMotorAxis *pAxis;
+  int axis;
+  int status=0;
+  static const char *functionName = "buildPulseSchedule";
+
+  status |= getIntegerParam(profileNumPulses_,   &numPulses);
+  status |= getIntegerParam(profileNumPoints_,   &numPoints);
+  status |= getIntegerParam(profileFitMode_,     &fitMode);
+  if (status) return asynError;
+  startPulses = builtStartPulses_;
+  endPulses = builtEndPulses_;
+
+  numProfilePulses_ = 0;
+  setIntegerParam(profileActualPulses_, 0);
+  if (numPulses <= 0) return asynSuccess;
+
+  // Check valid range of start and end pulses;  these start at 1, not 0
+  if ((startPulses < 1)           || (endPulses > numPoints) ||
+      (endPulses   < startPulses) || ((size_t)numPoints > maxProfilePoints_)) {
+    setStringParam(profileBuildMessage_, "Start or end pulses outside valid range");
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: start pulses=%d or end pulses=%d outside range 1 to %d\n",
+      driverName, functionName, startPulses, endPulses, numPoints);
+    return asynError;
+  }
+
+  if ((size_t)numPulses > maxProfilePulses_) {
+    free(pulseTimes_);
+    free(actualPulseTimes_);
+    pulseTimes_       = (double *)calloc(numPulses, sizeof(double));
+    actualPulseTimes_ = (double *)calloc(numPulses, sizeof(double));
+    for (axis=0; axis<numAxes_; axis++) {
+      pAxis = getAxis(axis);
+      if (!pAxis) continue;
+      free(pAxis->profilePulsePositions_);
+      pAxis->profilePulsePositions_ = (double *)calloc(numPulses, sizeof(double));
+    }
+    maxProfilePulses_ = numPulses;
+  }
+
+  useAxis = (int *)calloc(numAxes_, sizeof(int));
+  for (axis=0; axis<numAxes_; axis++) {
+    if (getAxis(axis)) useAxis[axis] = getAxis(axis)->builtUseAxis_;
+  }
+
+  period = trajectoryPulseTimes(numPoints, profileTimes_, startPulses, endPulses, numPulses, pulseTimes_);
+  for (axis=0; axis<numAxes_; axis++) {
+    if (!useAxis[axis]) continue;
+    trajectoryInterpolate(fitMode, numPoints, profileTimes_, pAxes_[axis]->profilePositions_,
+                          pAxes_[axis]->profileVelocities_, numPulses, pulseTimes_,
+                          pAxes_[axis]->profilePulsePositions_);
+  }
+  numProfilePulses_ = numPulses;
+
+  asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+    "%s:%s: %d pulses from %f to %f s, period %f s\n",
+    driverName, functionName, numPulses, pulseTimes_[0], pulseTimes_[numPulses-1], period);
+
+  doCallbacksFloat64Array(pulseTimes_, numPulses, profilePulseTimes_, 0);
+  buffer = (double *)calloc(numPulses, sizeof(double));
+  for (axis=0; axis<numAxes_; axis++) {
+    if (!useAxis[axis]) continue;
+    getPulsePositions(pAxes_[axis], buffer, numPulses);
+    doCallbacksFloat64Array(buffer, numPulses, profilePulsePositions_, axis);
+  }
+  free(buffer);
+  free(useAxis);
+  return asynSuccess;
+}
+
+/** Pre-processes the trajectory of a profile move for the controller.
+  * Computes the velocity of each axis at each point in its profileVelocities_ for PVT controllers,
+  * either for straight lines between the points or for a cubic spline through them (profileFitMode_).
+  * If profileSegmentTime_ is not 0 it also resamples the path at that interval into
+  * profileSamplePositions_ and profileSampleVelocities_ for controllers with a fixed segment time;
+  * numProfileSamples_ is the number of samples.  All are in controller units.
+  * The axes are shared between up to profileThreads_ threads; see setProfileThreads().
+  * Called with the lock held from buildProfile(), after validateProfile(). */
+asynStatus asynMotorController::prepareProfile()
+{
+  int numPoints, fitMode;
+  int numUsed = 0, numThreads;
+  int axis, i;
+  int *axes;
+  double segmentTime;
+  size_t numSamples = 0;
+  asynMotorAxis *pAxis;
+  prepareProfileJob *pJobs;
+  epicsTimeStamp start, end;
+  char threadName[32];
+  int status = 0;
+  static const char *functionName = "prepareProfile";
+
+  getIntegerParam(profileNumPoints_, &numPoints);
+  getIntegerParam(profileFitMode_, &fitMode);
+  getDoubleParam(profileSegmentTime_, &segmentTime);
+  epicsTimeGetCurrent(&start);
+
+  numProfileSamples_ = 0;
+  if (segmentTime > 0.) numSamples = trajectoryNumSamples(numPoints, profileTimes_, segmentTime);
+  if (numSamples > maxProfileSamples_) {
+    for (axis=0; axis<numAxes_; axis++) {
+      pAxis = getAxis(axis);
+      if (!pAxis) continue;
+      free(pAxis->profileSamplePositions_);
+      free(pAxis->profileSampleVelocities_);
+      pAxis->profileSamplePositions_  = (double *)calloc(numSamples, sizeof(double));
+      pAxis->profileSampleVelocities_ = (double *)calloc(numSamples, sizeof(double));
+      if (!pAxis->profileSamplePositions_ || !pAxis->profileSampleVelocities_) status = -1;
+    }
+    maxProfileSamples_ = status ? 0 : numSamples;
+    if (status) {
+      setStringParam(profileBuildMessage_, "Cannot allocate memory for the profile samples");
+      return asynError;
+    }
+  }
+
+  axes = (int *)calloc(numAxes_, sizeof(int));
+  for (axis=0; axis<numAxes_; axis++) {
+    if (!getAxis(axis) || !getAxis(axis)->profileVelocities_) continue;
+    if (getAxis(axis)->builtUseAxis_) axes[numUsed++] = axis;
+  }
+  numThreads = (profileThreads_ < numUsed) ? profileThreads_ : numUsed;
+  if (numThreads < 1) numThreads = 1;
+
+  pJobs = (prepareProfileJob *)calloc(numThreads, sizeof(prepareProfileJob));
+  for (i=0; i<numThreads; i++) {
+    pJobs[i].pC = this;
+    pJobs[i].axes = axes;
+    pJobs[i].numAxes = numUsed;
+    pJobs[i].first = i;
+    pJobs[i].stride = numThreads;
+    pJobs[i].fitMode = fitMode;
+    pJobs[i].numPoints = numPoints;
+    pJobs[i].segmentTime = segmentTime;
+    pJobs[i].numSamples = numSamples;
+  }
+  for (i=1; i<numThreads; i++) {
+    pJobs[i].done = epicsEventMustCreate(epicsEventEmpty);
+    epicsSnprintf(threadName, sizeof(threadName), "motorProfile%d", i);
+    if (!epicsThreadCreate(threadName, epicsThreadPriorityMedium,
+                           epicsThreadGetStackSize(epicsThreadStackSmall),
+                           (EPICSTHREADFUNC)prepareProfileC, (void *)&pJobs[i])) {
+      // Do this thread's axes here instead; prepareProfileC() signals done so the wait below returns
+      asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+        "%s:%s: cannot create thread %s, processing its axes in this thread\n",
+        driverName, functionName, threadName);
+      prepareProfileC(&pJobs[i]);
+    }
+  }
+  prepareProfileAxes(&pJobs[0]);
+  status = pJobs[0].status;
+  for (i=1; i<numThreads; i++) {
+    epicsEventMustWait(pJobs[i].done);
+    epicsEventDestroy(pJobs[i].done);
+    status |= pJobs[i].status;
+  }
+  free(pJobs);
+
+  epicsTimeGetCurrent(&end);
+  asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+    "%s:%s: %d axes, %d points, %d samples in %f s with %d threads\n",
+    driverName, functionName, numUsed, numPoints, (int)numSamples,
+    epicsTimeDiffInSeconds(&end, &start), numThreads);
+
+  if (status) {
+    free(axes);
+    setStringParam(profileBuildMessage_, "Cannot allocate memory for the profile velocities");
+    return asynError;
+  }
+  numProfileSamples_ = numSamples;
+  setIntegerParam(profileNumSamples_, (int)numSamples);
+  for (i=0; i<numUsed; i++) {
+    getProfileVelocities(pAxes_[axes[i]], profileSegmentVelocities_, numPoints);
+    doCallbacksFloat64Array(profileSegmentVelocities_, numPoints, profileVelocities_, axes[i]);
+  }
+  free(axes);
+  return asynSuccess;
+}
+
+static void prepareProfileC(void *drvPvt)
+{
+  prepareProfileJob *pJob = (prepareProfileJob *)drvPvt;
+  pJob->pC->prepareProfileAxes(pJob);
+  epicsEventSignal(pJob->done);
+}
+
+/** Computes the velocities and samples of the axes of one prepareProfile() thread.
+  * Uses only the profile arrays of those axes and profileTimes_, and not the parameter library,
+  * so threads can run in parallel while prepareProfile() holds the lock. */
+void asynMotorController::prepareProfileAxes(prepareProfileJob *pJob)
+{
+  asynMotorAxis *pAxis;
+  int i;
+
+  for (i=pJob->first; i<pJob->numAxes; i+=pJob->stride) {
+    pAxis = pAxes_[pJob->axes[i]];
+    if (trajectoryVelocities(pJob->fitMode, pJob->numPoints, profileTimes_,
+                             pAxis->profilePositions_, pAxis->profileVelocities_)) {
+      pJob->status = -1;
+      continue;
+    }
+    if (pJob->numSamples == 0) continue;
+    trajectoryResample(pJob->fitMode, pJob->numPoints, profileTimes_,
+                       pAxis->profilePositions_, pAxis->profileVelocities_,
+                       pJob->segmentTime, pJob->numSamples,
+                       pAxis->profileSamplePositions_, pAxis->profileSampleVelocities_);
+  }
+}
+
+/** Sets the maximum number of threads that prepareProfile() uses; one axis is processed by one thread.
+  * \param[in] numThreads The number of threads; 1 processes all axes in the thread that builds the profile. */
+asynStatus asynMotorController::setProfileThreads(int numThreads)
+{
+  if (numThreads < 1) return asynError;
+  lock();
+  profileThreads_ = numThreads;
+  unlock();
+  return asynSuccess;
+}
+
+/** Copies the velocities at the profile points of an axis in user units.
+  * \param[in] pAxis The axis.
+  * \param[out] value The velocities.
+  * \param[in] maxValues The size of value.
+  * Returns the number of velocities copied. */
+size_t asynMotorController::getProfileVelocities(asynMotorAxis *pAxis, double *value, size_t maxValues)
+{
+  size_t i, num;
+  int numPoints;
+  double resolution;
+  int direction;
+  int status=0;
+
+  status |= getIntegerParam(profileNumPoints_, &numPoints);
+  status |= getDoubleParam(pAxis->axisNo_, motorRecResolution_, &resolution);
+  status |= getIntegerParam(pAxis->axisNo_, motorRecDirection_, &direction);
+  if (status || !pAxis->profileVelocities_ || (numPoints < 0)) return 0;
+
+  num = ((size_t)numPoints < maxValues) ? numPoints : maxValues;
+  if (num > maxProfilePoints_) num = maxProfilePoints_;
+  if (direction != 0) resolution = -resolution;
+  for (i=0; i<num; i++) {
+    value[i] = pAxis->profileVelocities_[i] * resolution;
+  }
+  return num;
+}
+
+/** Starts streaming profile readbacks.
+  * Drivers push readbacks with pushProfileReadbacks() while a profile executes, and a thread
+  * publishes them in chunks with callbacks on profileStreamPoints_, profileStreamReadbacks_ and
+  * profileStreamFollowingErrors_, profileStreamRate_ times per second.
+  * Only the ring is held in memory, however long the profile.
+  * \param[in] maxPoints The number of points the ring holds; it should hold at least the points
+  *            gathered in 1/rate seconds.  Points pushed when it is full are counted in profileStreamOverruns_.
+  * \param[in] rate The initial number of chunks published per second; 0 pauses publishing. */
+asynStatus asynMotorController::startProfileStream(size_t maxPoints, double rate)
+{
+  static const char *functionName = "startProfileStream";
+
+  if (readbackRing_ || (maxPoints == 0)) return asynError;
+  readbackRing_ = new asynMotorReadbackRing(numAxes_, maxPoints);
+  if (readbackRing_->capacity() == 0) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: cannot allocate a ring of %d points\n", driverName, functionName, (int)maxPoints);
+    delete readbackRing_;
+    readbackRing_ = NULL;
+    return asynError;
+  }
+  lock();
+  setDoubleParam(profileStreamRate_, rate);
+  callParamCallbacks();
+  unlock();
+  epicsThreadCreate("motorProfileStream",
+                    epicsThreadPriorityLow,
+                    epicsThreadGetStackSize(epicsThreadStackMedium),
+                    (EPICSTHREADFUNC)asynMotorProfileStreamC, (void *)this);
+  return asynSuccess;
+}
+
+/** Pushes profile readbacks for streaming; see startProfileStream().
+  * Drivers call this as gathered data become available, typically from the thread that reads it.
+  * It does not take the lock, and may be called with or without it, but only from one thread at a time.
+  * \param[in] firstPoint The number of the first point, for example the gathered sample or pulse
+  *            from the start of the profile; the others follow in order.
+  * \param[in] numPoints The number of points.
+  * \param[in] readbacks The readback positions in controller units, numAxes_ values per point.
+  * \param[in] followingErrors The following errors in controller units, numAxes_ values per point; NULL for none.
+  * Returns the number of points pushed; 0 if streaming is not enabled. */
+size_t asynMotorController::pushProfileReadbacks(int firstPoint, size_t numPoints,
+                                                 const double *readbacks, const double *followingErrors)
+{
+  if (!readbackRing_) return 0;
+  return readbackRing_->push(firstPoint, numPoints, readbacks, followingErrors);
+}
+
+static void asynMotorProfileStreamC(void *drvPvt)
+{
+  asynMotorController *pController = (asynMotorController*)drvPvt;
+  pController->asynMotorProfileStream();
+}
+
+/** Profile stream thread started by startProfileStream().
+  * Every 1/profileStreamRate_ seconds takes the points in the ring, converts them to user units and
+  * does callbacks on the arrays of each axis in the profile and on the point numbers.
+  * The axes are those of the execute slot, which is the profile that pushes the points.
+  * It then increments profileStreamSequence_, so a client that sees the sequence change knows
+  * that the arrays are complete, and one that sees it jump knows it missed a chunk. */
+void asynMotorController::asynMotorProfileStream()
+{
+  size_t maxPoints = readbackRing_->capacity();
+  size_t i, num, overruns, lastOverruns = 0;
+  double *points;
+  double **readbacks, **followingErrors;
+  double rate, resolution, offset;
+  int axis, direction, slot;
+
+  points = (double *)calloc(maxPoints, sizeof(double));
+  readbacks = (double **)calloc(numAxes_, sizeof(double *));
+  followingErrors = (double **)calloc(numAxes_, sizeof(double *));
+  for (axis=0; axis<numAxes_; axis++) {
+    readbacks[axis] = (double *)calloc(maxPoints, sizeof(double));
+    followingErrors[axis] = (double *)calloc(maxPoints, sizeof(double));
+  }
+
+  while (!shuttingDown_) {
+    lock();
+    getDoubleParam(profileStreamRate_, &rate);
+    unlock();
+    if (rate > 0.) epicsEventWaitWithTimeout(streamEventId_, 1./rate);
+    else           epicsEventWait(streamEventId_);
+    if (rate <= 0.) continue;
+
+    num = readbackRing_->pop(maxPoints, points, readbacks, followingErrors);
+    overruns = readbackRing_->overruns();
+    if ((num == 0) && (overruns == lastOverruns)) continue;
+    lastOverruns = overruns;
+
+    lock();
+    slot = selectExecuteSlot();
+    if (num > 0) {
+      for (axis=0; axis<numAxes_; axis++) {
+        if (!pAxes_[axis] || !pAxes_[axis]->builtUseAxis_) continue;
+        getDoubleParam(axis, motorRecResolution_, &resolution);
+        getDoubleParam(axis, motorRecOffset_, &offset);
+        getIntegerParam(axis, motorRecDirection_, &direction);
+        if (direction != 0) resolution = -resolution;
+        for (i=0; i<num; i++) {
+          readbacks[axis][i] = readbacks[axis][i] * resolution + offset;
+          followingErrors[axis][i] *= resolution;
+        }
+        doCallbacksFloat64Array(readbacks[axis], num, profileStreamReadbacks_, axis);
+        doCallbacksFloat64Array(followingErrors[axis], num, profileStreamFollowingErrors_, axis);
+      }
+      doCallbacksFloat64Array(points, num, profileStreamPoints_, 0);
+      setIntegerParam(profileStreamNumPoints_, (int)num);
+      setIntegerParam(profileStreamSequence_, ++streamSequence_);
+    }
+    setIntegerParam(profileStreamOverruns_, (int)overruns);
+    selectProfileSlot(slot);
+    callParamCallbacks();
+    unlock();
+  }
+
+  for (axis=0; axis<numAxes_; axis++) {
+    free(readbacks[axis]);
+    free(followingErrors[axis]);
+  }
+  free(readbacks);
+  free(followingErrors);
+  free(points);
+}
+
+/** Copies the pulse positions of an axis in user units, as readbackProfile() converts readbacks.
+  * \param[in] pAxis The axis.
+  * \param[out] value The positions.
+  * \param[in] maxValues The size of value.
+  * Returns the number of positions copied. */
+size_t asynMotorController::getPulsePositions(asynMotorAxis *pAxis, double *value, size_t maxValues)
+{
+  size_t i, num;
+  double resolution;
+  double offset;
+  int direction;
+  int status=0;
+
+  status |= getDoubleParam(pAxis->axisNo_, motorRecResolution_, &resolution);
+  status |= getDoubleParam(pAxis->axisNo_, motorRecOffset_, &offset);
+  status |= getIntegerParam(pAxis->axisNo_, motorRecDirection_, &direction);
+  if (status || !pAxis->profilePulsePositions_) return 0;
+
+  num = (numProfilePulses_ < maxValues) ? numProfilePulses_ : maxValues;
+  if (direction != 0) resolution = -resolution;
+  for (i=0; i<num; i++) {
+    value[i] = pAxis->profilePulsePositions_[i] * resolution + offset;
+  }
+  return num;
+}
+
+/** Loads the pulse schedule into the pulse output hardware of the controller.
+  * The base class calls loadProfilePulses() of each axis in the profile, for controllers
+  * with position compare outputs per axis. Drivers whose pulse output belongs to the controller
+  * override this and use pulseTimes_ or the profilePulsePositions_ of the axes.
+  * Called with the lock held from buildProfile(). */
+asynStatus asynMotorController::loadProfilePulses()
+{
+  int axis;
+  int status=0;
+  asynMotorAxis *pAxis;
+
+  if (numProfilePulses_ == 0) return asynSuccess;
+  for (axis=0; axis<numAxes_; axis++) {
+    pAxis = getAxis(axis);
+    if (!pAxis || !pAxis->builtUseAxis_) continue;
+    status |= pAxis->loadProfilePulses(builtPulseMode_, numProfilePulses_);
+  }
+  return status ? asynError : asynSuccess;
+}
+
+/** Reports the pulses the controller actually output during a profile move.
+  * Drivers write the time of each pulse from the start of the profile into actualPulseTimes_
+  * and call this with the number of pulses, with the lock held.
+  * Sets profileActualPulses_ and does callbacks on it and on the actual pulse times.
+  * \param[in] numPulses The number of pulses in actualPulseTimes_. */
+asynStatus asynMotorController::setProfileActualPulses(size_t numPulses)
+{
+  if (numPulses > maxProfilePulses_) numPulses = maxProfilePulses_;
+  setIntegerParam(profileActualPulses_, (int)numPulses);
+  doCallbacksFloat64Array(actualPulseTimes_, numPulses, profileActualPulseTimes_, 0);
+  return callParamCallbacks();
+}
+
 /** Set the moving poll period (in secs) at runtime.*/
 asynStatus asynMotorController::setMovingPollPeriod(double movingPollPeriod)
 {
@@ -955,6 +2538,22 @@ asynStatus setIdlePollPeriod(const char *portName, double idlePollPeriod)
 
 
 
+asynStatus asynMotorDonePolls(const char *portName, double donePollPeriod, int donePollCount)
+{
+  asynMotorController *pC;
+  static const char *functionName = "asynMotorDonePolls";
+
+  pC = (asynMotorController*) findAsynPortDriver(portName);
+  if (!pC) {
+    printf("%s:%s: Error port %s not found\n", driverName, functionName, portName);
+    return asynError;
+  }
+
+  return pC->setDonePolls(donePollPeriod, donePollCount);
+}
+
+
+
 asynStatus asynMotorEnableMoveToHome(const char *portName, int axis, int distance)
 {
   asynMotorController *pC = NULL;
@@ -982,6 +2581,122 @@ asynStatus asynMotorEnableMoveToHome(const char *portName, int axis, int distanc
   return asynSuccess;
 }
 
+/** Sets the maximum number of axes of a controller that move to home at the same time.
+  * \param[in] portName The controller port name.
+  * \param[in] maxActive The maximum number of axes homing at once; the default is 1. */
+asynStatus asynMotorMoveToHomeConcurrency(const char *portName, int maxActive)
+{
+  asynMotorController *pC;
+  asynStatus status;
+  static const char *functionName = "asynMotorMoveToHomeConcurrency";
+
+  pC = (asynMotorController*) findAsynPortDriver(portName);
+  if (!pC) {
+    printf("%s:%s: Error port %s not found\n", driverName, functionName, portName);
+    return asynError;
+  }
+
+  status = pC->setMoveToHomeConcurrency(maxActive);
+  if (status) {
+    printf("%s:%s: Error port %s does not support move to home, or %d is not a valid number of axes\n",
+      driverName, functionName, portName, maxActive);
+  }
+  return status;
+}
+
+/** Sets the maximum number of threads a controller uses to prepare the trajectories of profile moves.
+  * \param[in] portName The controller port name.
+  * \param[in] numThreads The maximum number of threads; the default is 1. */
+asynStatus asynMotorProfileThreads(const char *portName, int numThreads)
+{
+  asynMotorController *pC;
+  static const char *functionName = "asynMotorProfileThreads";
+
+  pC = (asynMotorController*) findAsynPortDriver(portName);
+  if (!pC) {
+    printf("%s:%s: Error port %s not found\n", driverName, functionName, portName);
+    return asynError;
+  }
+  if (pC->setProfileThreads(numThreads)) {
+    printf("%s:%s: Error number of threads must be at least 1\n", driverName, functionName);
+    return asynError;
+  }
+  return asynSuccess;
+}
+
+/** Sets the number of profile slots of a controller.
+  * \param[in] portName The controller port name.
+  * \param[in] numSlots The number of slots; the default is 1. */
+asynStatus asynMotorProfileSlots(const char *portName, int numSlots)
+{
+  asynMotorController *pC;
+  static const char *functionName = "asynMotorProfileSlots";
+
+  pC = (asynMotorController*) findAsynPortDriver(portName);
+  if (!pC) {
+    printf("%s:%s: Error port %s not found\n", driverName, functionName, portName);
+    return asynError;
+  }
+  if (pC->setProfileSlots(numSlots)) {
+    printf("%s:%s: Error number of slots must be at least 1\n", driverName, functionName);
+    return asynError;
+  }
+  return asynSuccess;
+}
+
+/** Starts streaming the profile readbacks of a controller while profiles execute.
+  * \param[in] portName The controller port name.
+  * \param[in] maxPoints The number of points the readback ring holds.
+  * \param[in] rate The number of chunks published per second; 0 pauses publishing. */
+asynStatus asynMotorProfileStream(const char *portName, int maxPoints, double rate)
+{
+  asynMotorController *pC;
+  static const char *functionName = "asynMotorProfileStream";
+
+  pC = (asynMotorController*) findAsynPortDriver(portName);
+  if (!pC) {
+    printf("%s:%s: Error port %s not found\n", driverName, functionName, portName);
+    return asynError;
+  }
+  if ((maxPoints < 1) || pC->startProfileStream(maxPoints, rate)) {
+    printf("%s:%s: Error cannot start the profile stream of port %s\n", driverName, functionName, portName);
+    return asynError;
+  }
+  return asynSuccess;
+}
+
+/** Enables the axis-state snapshot file of a controller.
+  * If this is called before the controller starts its poller, the previous snapshot is restored
+  * when the poller starts and verified by the first poll; otherwise the snapshot is only written.
+  * \param[in] portName The controller port name.
+  * \param[in] fileName The snapshot file.
+  * \param[in] period The minimum time between snapshot writes.
+  * \param[in] positionAxes Bit mask of the axes whose position is restored from the snapshot.
+  * Leave out the axes whose position autosave restores, so that devMotorAsyn loads it. */
+asynStatus asynMotorSnapshot(const char *portName, const char *fileName, double period, int positionAxes)
+{
+  asynMotorController *pC;
+  snapshotConfig *pConfig;
+  static const char *functionName = "asynMotorSnapshot";
+
+  if (!portName || !fileName || (strlen(fileName) + 5 > MAX_CONTROLLER_STRING_SIZE)) {
+    printf("%s:%s: Error port name and file name are required\n", driverName, functionName);
+    return asynError;
+  }
+
+  pC = (asynMotorController*) findAsynPortDriver(portName);
+  if (pC) return pC->setSnapshotFile(fileName, period);
+
+  pConfig = (snapshotConfig *)calloc(1, sizeof(snapshotConfig));
+  pConfig->portName = epicsStrDup(portName);
+  pConfig->fileName = epicsStrDup(fileName);
+  pConfig->period = period;
+  pConfig->positionAxes = positionAxes;
+  pConfig->next = snapshotConfigs;
+  snapshotConfigs = pConfig;
+  return asynSuccess;
+}
+
 
 /* setMovingPollPeriod */
 static const iocshArg setMovingPollPeriodArg0 = {"Controller port name", iocshArgString};
@@ -1023,11 +2738,104 @@ static void enableMoveToHomeCallFunc(const iocshArgBuf *args)
 }
 
 
+/* asynMotorMoveToHomeConcurrency */
+static const iocshArg asynMotorMoveToHomeConcurrencyArg0 = {"Controller port name", iocshArgString};
+static const iocshArg asynMotorMoveToHomeConcurrencyArg1 = {"Maximum axes homing", iocshArgInt};
+static const iocshArg * const asynMotorMoveToHomeConcurrencyArgs[] = {&asynMotorMoveToHomeConcurrencyArg0,
+                                                                      &asynMotorMoveToHomeConcurrencyArg1};
+static const iocshFuncDef asynMotorMoveToHomeConcurrencyDef = {"asynMotorMoveToHomeConcurrency", 2,
+                                                               asynMotorMoveToHomeConcurrencyArgs};
+
+static void asynMotorMoveToHomeConcurrencyCallFunc(const iocshArgBuf *args)
+{
+  asynMotorMoveToHomeConcurrency(args[0].sval, args[1].ival);
+}
+
+
+/* asynMotorProfileThreads */
+static const iocshArg asynMotorProfileThreadsArg0 = {"Controller port name", iocshArgString};
+static const iocshArg asynMotorProfileThreadsArg1 = {"Maximum threads", iocshArgInt};
+static const iocshArg * const asynMotorProfileThreadsArgs[] = {&asynMotorProfileThreadsArg0,
+                                                               &asynMotorProfileThreadsArg1};
+static const iocshFuncDef asynMotorProfileThreadsDef = {"asynMotorProfileThreads", 2, asynMotorProfileThreadsArgs};
+
+static void asynMotorProfileThreadsCallFunc(const iocshArgBuf *args)
+{
+  asynMotorProfileThreads(args[0].sval, args[1].ival);
+}
+
+
+/* asynMotorProfileSlots */
+static const iocshArg asynMotorProfileSlotsArg0 = {"Controller port name", iocshArgString};
+static const iocshArg asynMotorProfileSlotsArg1 = {"Number of slots", iocshArgInt};
+static const iocshArg * const asynMotorProfileSlotsArgs[] = {&asynMotorProfileSlotsArg0,
+                                                             &asynMotorProfileSlotsArg1};
+static const iocshFuncDef asynMotorProfileSlotsDef = {"asynMotorProfileSlots", 2, asynMotorProfileSlotsArgs};
+
+static void asynMotorProfileSlotsCallFunc(const iocshArgBuf *args)
+{
+  asynMotorProfileSlots(args[0].sval, args[1].ival);
+}
+
+
+/* asynMotorProfileStream */
+static const iocshArg asynMotorProfileStreamArg0 = {"Controller port name", iocshArgString};
+static const iocshArg asynMotorProfileStreamArg1 = {"Ring points", iocshArgInt};
+static const iocshArg asynMotorProfileStreamArg2 = {"Chunks per second", iocshArgDouble};
+static const iocshArg * const asynMotorProfileStreamArgs[] = {&asynMotorProfileStreamArg0,
+                                                              &asynMotorProfileStreamArg1,
+                                                              &asynMotorProfileStreamArg2};
+static const iocshFuncDef asynMotorProfileStreamDef = {"asynMotorProfileStream", 3, asynMotorProfileStreamArgs};
+
+static void asynMotorProfileStreamCallFunc(const iocshArgBuf *args)
+{
+  asynMotorProfileStream(args[0].sval, args[1].ival, args[2].dval);
+}
+
+
+/* asynMotorDonePolls */
+static const iocshArg asynMotorDonePollsArg0 = {"Controller port name", iocshArgString};
+static const iocshArg asynMotorDonePollsArg1 = {"Poll period", iocshArgDouble};
+static const iocshArg asynMotorDonePollsArg2 = {"Maximum polls", iocshArgInt};
+static const iocshArg * const asynMotorDonePollsArgs[] = {&asynMotorDonePollsArg0,
+                                                          &asynMotorDonePollsArg1,
+                                                          &asynMotorDonePollsArg2};
+static const iocshFuncDef asynMotorDonePollsDef = {"asynMotorDonePolls", 3, asynMotorDonePollsArgs};
+
+static void asynMotorDonePollsCallFunc(const iocshArgBuf *args)
+{
+  asynMotorDonePolls(args[0].sval, args[1].dval, args[2].ival);
+}
+
+
+/* asynMotorSnapshot */
+static const iocshArg asynMotorSnapshotArg0 = {"Controller port name", iocshArgString};
+static const iocshArg asynMotorSnapshotArg1 = {"Snapshot file", iocshArgString};
+static const iocshArg asynMotorSnapshotArg2 = {"Write period", iocshArgDouble};
+static const iocshArg asynMotorSnapshotArg3 = {"Restored position axes mask", iocshArgInt};
+static const iocshArg * const asynMotorSnapshotArgs[] = {&asynMotorSnapshotArg0,
+                                                         &asynMotorSnapshotArg1,
+                                                         &asynMotorSnapshotArg2,
+                                                         &asynMotorSnapshotArg3};
+static const iocshFuncDef asynMotorSnapshotDef = {"asynMotorSnapshot", 4, asynMotorSnapshotArgs};
+
+static void asynMotorSnapshotCallFunc(const iocshArgBuf *args)
+{
+  asynMotorSnapshot(args[0].sval, args[1].sval, args[2].dval, args[3].ival);
+}
+
+
 static void asynMotorControllerRegister(void)
 {
   iocshRegister(&setMovingPollPeriodDef, setMovingPollPeriodCallFunc);
   iocshRegister(&setIdlePollPeriodDef, setIdlePollPeriodCallFunc);
   iocshRegister(&enableMoveToHome, enableMoveToHomeCallFunc);
+  iocshRegister(&asynMotorMoveToHomeConcurrencyDef, asynMotorMoveToHomeConcurrencyCallFunc);
+  iocshRegister(&asynMotorProfileThreadsDef, asynMotorProfileThreadsCallFunc);
+  iocshRegister(&asynMotorProfileSlotsDef, asynMotorProfileSlotsCallFunc);
+  iocshRegister(&asynMotorProfileStreamDef, asynMotorProfileStreamCallFunc);
+  iocshRegister(&asynMotorSnapshotDef, asynMotorSnapshotCallFunc);
+  iocshRegister(&asynMotorDonePollsDef, asynMotorDonePollsCallFunc);
 }
 epicsExportRegistrar(asynMotorControllerRegister);
 
@@ -10,6 +10,10 @@
 
 #include <epicsEvent.h>
 #include <epicsTypes.h>
+#include <epicsTime.h>
+
+#include "asynMotorTrajectory.h"
+#include "asynMotorReadbackRing.h"
 
 #define MAX_CONTROLLER_STRING_SIZE 256
 #define DEFAULT_CONTROLLER_TIMEOUT 2.0
@@ -45,6 +49,10 @@
 #define motorPostMoveDelayString        "MOTOR_POST_MOVE_DELAY"
 #define motorStatusString               "MOTOR_STATUS"
 #define motorUpdateStatusString         "MOTOR_UPDATE_STATUS"
+#define motorStopAllString              "MOTOR_STOP_ALL"
+#define motorMoveToHomeStateString      "MOTOR_MOVE_HOME_STATE"
+#define motorMoveToHomeQueueString      "MOTOR_MOVE_HOME_QUEUE"
+#define motorMoveToHomeTimeString       "MOTOR_MOVE_HOME_TIME"
 #define motorStatusDirectionString      "MOTOR_STATUS_DIRECTION" 
 #define motorStatusDoneString           "MOTOR_STATUS_DONE"
 #define motorStatusHighLimitString      "MOTOR_STATUS_HIGH_LIMIT"
@@ -74,6 +82,25 @@
 #define profileStartPulsesString        "PROFILE_START_PULSES"
 #define profileEndPulsesString          "PROFILE_END_PULSES"
 #define profileActualPulsesString       "PROFILE_ACTUAL_PULSES"
+#define profilePulseModeString          "PROFILE_PULSE_MODE"
+#define profilePulseTimesString         "PROFILE_PULSE_TIMES"
+#define profileActualPulseTimesString   "PROFILE_ACTUAL_PULSE_TIMES"
+#define profileAutoScaleString          "PROFILE_AUTO_SCALE"
+#define profileTimeScaleString          "PROFILE_TIME_SCALE"
+#define profileBadPointString           "PROFILE_BAD_POINT"
+#define profileFitModeString            "PROFILE_FIT_MODE"
+#define profileSegmentTimeString        "PROFILE_SEGMENT_TIME"
+#define profileNumSamplesString         "PROFILE_NUM_SAMPLES"
+#define profileNumSlotsString           "PROFILE_NUM_SLOTS"
+#define profileBuildSlotString          "PROFILE_BUILD_SLOT"
+#define profileExecuteSlotString        "PROFILE_EXECUTE_SLOT"
+#define profileReadbackSlotString       "PROFILE_READBACK_SLOT"
+#define profileSwapSlotsString          "PROFILE_SWAP_SLOTS"
+#define profileStreamRateString         "PROFILE_STREAM_RATE"
+#define profileStreamSequenceString     "PROFILE_STREAM_SEQUENCE"
+#define profileStreamNumPointsString    "PROFILE_STREAM_NUM_POINTS"
+#define profileStreamOverrunsString     "PROFILE_STREAM_OVERRUNS"
+#define profileStreamPointsString       "PROFILE_STREAM_POINTS"
 #define profileNumReadbacksString       "PROFILE_NUM_READBACKS"
 #define profileTimeModeString           "PROFILE_TIME_MODE"
 #define profileFixedTimeString          "PROFILE_FIXED_TIME"
@@ -99,6 +126,12 @@
 #define profilePositionsString          "PROFILE_POSITIONS"
 #define profileReadbacksString          "PROFILE_READBACKS"
 #define profileFollowingErrorsString    "PROFILE_FOLLOWING_ERRORS"
+#define profilePulsePositionsString     "PROFILE_PULSE_POSITIONS"
+#define profileMaxVelocityString        "PROFILE_MAX_VELOCITY"
+#define profileMaxAccelerationString    "PROFILE_MAX_ACCELERATION"
+#define profileVelocitiesString         "PROFILE_VELOCITIES"
+#define profileStreamReadbacksString    "PROFILE_STREAM_READBACKS"
+#define profileStreamFollowingErrorsString "PROFILE_STREAM_FOLLOWING_ERRORS"
 
 /** The structure that is passed back to devMotorAsyn when the status changes. */
 typedef struct MotorStatus {
@@ -118,6 +151,12 @@ enum ProfileMoveMode{
   PROFILE_MOVE_MODE_RELATIVE
 };
 
+/* How controller hardware decides when to output a pulse */
+enum ProfilePulseMode{
+  PROFILE_PULSE_MODE_TIME,
+  PROFILE_PULSE_MODE_POSITION
+};
+
 /* State codes for Build, Read and Execute. Careful, these must match the
  * corresponding MBBI records, but there is no way to check this */
 enum ProfileBuildState{
@@ -138,6 +177,15 @@ enum ProfileReadbackState{
 };
 
 
+/* Per-axis state of a move to home request */
+enum MoveToHomeState {
+  MOVE_TO_HOME_IDLE,
+  MOVE_TO_HOME_QUEUED,
+  MOVE_TO_HOME_ACTIVE,
+  MOVE_TO_HOME_DONE,
+  MOVE_TO_HOME_FAILED
+};
+
 /* Status codes for Build, Execute and Read */
 enum ProfileStatus {
   PROFILE_STATUS_UNDEFINED,
@@ -151,6 +199,50 @@ enum ProfileStatus {
 #include <asynPortDriver.h>
 
 class asynMotorAxis;
+class asynMotorController;
+
+/** The axes of a profile that one thread of asynMotorController::prepareProfile() processes */
+typedef struct prepareProfileJob {
+  asynMotorController *pC;
+  const int *axes;              /**< Axes in the profile */
+  int numAxes;
+  int first;                    /**< This thread processes axes[first], axes[first+stride], ... */
+  int stride;
+  int fitMode;
+  size_t numPoints;
+  double segmentTime;
+  size_t numSamples;
+  int status;
+  epicsEventId done;            /**< Signalled when a thread has finished; NULL for the calling thread */
+} prepareProfileJob;
+
+/** The profile arrays of a controller in one profile slot; see asynMotorController::selectProfileSlot() */
+typedef struct asynMotorProfileSlot {
+  double *times;
+  double *pulseTimes;
+  double *actualPulseTimes;
+  size_t maxPulses;
+  size_t numPulses;
+  size_t maxSamples;
+  size_t numSamples;
+  int numPoints;                /**< Number of points when the slot was built; 0 if it has not been built */
+  int moveMode;                 /**< The parameters when the slot was built, which may since have changed */
+  int pulseMode;
+  int startPulses;
+  int endPulses;
+} asynMotorProfileSlot;
+
+/** The profile arrays of an axis in one profile slot */
+typedef struct asynMotorAxisProfileSlot {
+  double *positions;
+  double *readbacks;
+  double *followingErrors;
+  double *pulsePositions;
+  double *velocities;
+  double *samplePositions;
+  double *sampleVelocities;
+  int useAxis;                  /**< profileUseAxis_ when the slot was built */
+} asynMotorAxisProfileSlot;
 
 class epicsShareClass asynMotorController : public asynPortDriver {
 
@@ -177,21 +269,54 @@ class epicsShareClass asynMotorController : public asynPortDriver {
   virtual asynStatus wakeupPoller();
   virtual asynStatus poll();
   virtual asynStatus setDeferredMoves(bool defer);
+  virtual asynStatus stopAll();
   void asynMotorPoller();  // This should be private but is called from C function
   
   /* Functions to deal with moveToHome.*/
   virtual asynStatus startMoveToHomeThread();
   virtual void asynMotorMoveToHome();
+  virtual asynStatus queueMoveToHome(int axis);
+  virtual asynStatus cancelMoveToHome(int axis);
+  virtual asynStatus setMoveToHomeConcurrency(int maxActive);
   
   /* These are the functions for profile moves */
   virtual asynStatus initializeProfile(size_t maxPoints);
   virtual asynStatus buildProfile();
+  virtual asynStatus validateProfile();
+  virtual asynStatus prepareProfile();
+  virtual asynStatus validatePreparedProfile();
+  void prepareProfileAxes(prepareProfileJob *pJob);
+  asynStatus setProfileThreads(int numThreads);
   virtual asynStatus executeProfile();
   virtual asynStatus abortProfile();
   virtual asynStatus readbackProfile();
+
+  /* These are the functions for profile output pulses */
+  virtual asynStatus buildPulseSchedule();
+  virtual asynStatus loadProfilePulses();
+  asynStatus setProfileActualPulses(size_t numPulses);
+  size_t getPulsePositions(asynMotorAxis *pAxis, double *value, size_t maxValues);
+  size_t getProfileVelocities(asynMotorAxis *pAxis, double *value, size_t maxValues);
+
+  /* These are the functions for profile slots */
+  asynStatus setProfileSlots(int numSlots);
+  int selectProfileSlot(int slot);
+  int selectExecuteSlot();
+  virtual asynStatus swapProfileSlots();
+
+  /* These are the functions for streaming profile readbacks */
+  asynStatus startProfileStream(size_t maxPoints, double rate);
+  size_t pushProfileReadbacks(int firstPoint, size_t numPoints, const double *readbacks, const double *followingErrors);
+  void asynMotorProfileStream();  // This should be private but is called from C function
   
   virtual asynStatus setMovingPollPeriod(double movingPollPeriod);
   virtual asynStatus setIdlePollPeriod(double idlePollPeriod);
+  virtual asynStatus setDonePolls(double donePollPeriod, int donePollCount);
+
+  /* These are the functions for the axis-state snapshot file */
+  virtual asynStatus setSnapshotFile(const char *fileName, double period);
+  virtual asynStatus readSnapshot();
+  virtual asynStatus writeSnapshot();
 
   int shuttingDown_;   /**< Flag indicating that IOC is shutting down.  Stops poller */
 
@@ -227,6 +352,10 @@ class epicsShareClass asynMotorController : public asynPortDriver {
   int motorPostMoveDelay_;
   int motorStatus_;
   int motorUpdateStatus_;
+  int motorStopAll_;
+  int motorMoveToHomeState_;
+  int motorMoveToHomeQueue_;
+  int motorMoveToHomeTime_;
 
   // These are the status bits
   int motorStatusDirection_;
@@ -258,6 +387,25 @@ class epicsShareClass asynMotorController : public asynPortDriver {
   int profileStartPulses_;
   int profileEndPulses_;
   int profileActualPulses_;
+  int profilePulseMode_;
+  int profilePulseTimes_;
+  int profileActualPulseTimes_;
+  int profileAutoScale_;
+  int profileTimeScale_;
+  int profileBadPoint_;
+  int profileFitMode_;
+  int profileSegmentTime_;
+  int profileNumSamples_;
+  int profileNumSlots_;
+  int profileBuildSlot_;
+  int profileExecuteSlot_;
+  int profileReadbackSlot_;
+  int profileSwapSlots_;
+  int profileStreamRate_;
+  int profileStreamSequence_;
+  int profileStreamNumPoints_;
+  int profileStreamOverruns_;
+  int profileStreamPoints_;
   int profileNumReadbacks_;
   int profileTimeMode_;
   int profileFixedTime_;
@@ -283,7 +431,13 @@ class epicsShareClass asynMotorController : public asynPortDriver {
   int profilePositions_;
   int profileReadbacks_;
   int profileFollowingErrors_;
-  #define LAST_MOTOR_PARAM profileFollowingErrors_
+  int profilePulsePositions_;
+  int profileMaxVelocity_;
+  int profileMaxAcceleration_;
+  int profileVelocities_;
+  int profileStreamReadbacks_;
+  int profileStreamFollowingErrors_;
+  #define LAST_MOTOR_PARAM profileStreamFollowingErrors_
 
   int numAxes_;                 /**< Number of axes this controller supports */
   asynMotorAxis **pAxes_;       /**< Array of pointers to axis objects */
@@ -292,11 +446,60 @@ class epicsShareClass asynMotorController : public asynPortDriver {
   double idlePollPeriod_;       /**< The time between polls when no axes are moving */
   double movingPollPeriod_;     /**< The time between polls when any axis is moving */
   int    forcedFastPolls_;      /**< The number of forced fast polls when the poller wakes up */
+  double donePollPeriod_;       /**< The time between polls after a move is expected to be done; 0 = movingPollPeriod_/4 */
+  int    donePollCount_;        /**< The maximum number of polls at donePollPeriod_; 0 disables them */
  
   size_t maxProfilePoints_;     /**< Maximum number of profile points */
   double *profileTimes_;        /**< Array of times per profile point */
+  double *profileInverseTimes_; /**< Work array for validateProfile(); 1/profileTimes_ */
+  double *profileSegmentVelocities_; /**< Work array for validateProfile(); velocity of each segment */
+  double *profileAccelerations_; /**< Work array for validateProfile(); acceleration at each point */
+  size_t maxProfileSamples_;    /**< Size of the axis sample arrays; grows with the number of samples */
+  size_t numProfileSamples_;    /**< Number of samples computed by prepareProfile(); 0 if not resampled */
+  int profileThreads_;          /**< Maximum number of threads used by prepareProfile() */
+  size_t maxProfilePulses_;     /**< Size of the pulse arrays; grows with profileNumPulses_ */
+  size_t numProfilePulses_;     /**< Number of pulses in the schedule built by buildPulseSchedule() */
+  double *pulseTimes_;          /**< Time of each scheduled pulse from the start of the profile */
+  double *actualPulseTimes_;    /**< Time of each pulse the controller actually output */
+  int numProfilePoints_;        /**< Number of points when the selected slot was built; 0 if not built */
+  int builtMoveMode_;           /**< profileMoveMode_ when the selected slot was built */
+  int builtPulseMode_;          /**< profilePulseMode_ when the selected slot was built */
+  int builtStartPulses_;        /**< profileStartPulses_ when the selected slot was built */
+  int builtEndPulses_;          /**< profileEndPulses_ when the selected slot was built */
+
+  int numProfileSlots_;         /**< Number of profile slots; see setProfileSlots() */
+  asynMotorProfileSlot *profileSlots_; /**< The arrays of each slot; those of profileSlot_ are in the members above */
+  int profileSlot_;             /**< The slot whose arrays are in the members; buildSlot_ except in selectProfileSlot() */
+  int buildSlot_;               /**< Slot that array writes and buildProfile() use */
+  int executeSlot_;             /**< Slot that executeProfile() and abortProfile() use; fixed while executing */
+  int readbackSlot_;            /**< Slot that readbackProfile() and the readback arrays use */
+
+  void storeProfileSlot();
+  void loadProfileSlot(int slot);
+  void freeProfileSlots();
+  asynStatus setProfileSlot(int function, int slot);
+
+  asynMotorReadbackRing *readbackRing_; /**< Readbacks pushed by the driver during a profile; NULL if not streaming */
+  epicsEventId streamEventId_;  /**< Event ID to wake up the profile stream thread */
+  int streamSequence_;          /**< Number of readback chunks published */
+
+  int moveToHomeAxis_;          /**< The axis most recently handed to a move to home thread */
+  int *moveToHomeQueue_;        /**< Axes waiting to move to home, oldest first */
+  int moveToHomeQueued_;        /**< Number of axes in moveToHomeQueue_ */
+  int moveToHomeActive_;        /**< Number of axes moving to home */
+  int moveToHomeMaxActive_;     /**< Maximum number of axes moving to home at the same time */
+  int moveToHomeThreads_;       /**< Number of move to home threads started */
+
+  void updateMoveToHomeQueue();
+
+  char *snapshotFile_;          /**< Axis-state snapshot file; NULL if snapshots are not enabled */
+  double snapshotPeriod_;       /**< Minimum time between snapshot writes */
+  epicsTimeStamp snapshotTime_; /**< Time of the last snapshot write */
+  void *snapshot_;              /**< Snapshot buffer; header followed by one record per axis */
+  int snapshotVerify_;          /**< Verify the restored snapshot with the next poll */
+  int snapshotPositionAxes_;    /**< Bit mask of the axes whose position is restored from the snapshot */
 
-  int moveToHomeAxis_;
+  double donePollTimeout(double timeout);
 
   /* These are convenience functions for controllers that use asynOctet interfaces to the hardware */
   asynStatus writeController();
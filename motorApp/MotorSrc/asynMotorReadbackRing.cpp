@@ -0,0 +1,104 @@
+/* asynMotorReadbackRing.cpp
+ *
+ * This file implements the single-producer, single-consumer ring that carries
+ * profile readbacks from a driver to asynMotorController while a profile executes.
+ * head_ and tail_ count rows since the ring was created and only increase, so
+ * head_ - tail_ is the number of rows in the ring even after they wrap around.
+ * MOTOR_BARRIER() orders the rows against the counters.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#define epicsExportSharedSymbols
+#include <shareLib.h>
+#include "asynMotorReadbackRing.h"
+#include "motorBarrier.h"
+
+/** Creates a ring.
+  * \param[in] numAxes The number of axes of the controller.
+  * \param[in] maxPoints The number of rows the ring holds. */
+asynMotorReadbackRing::asynMotorReadbackRing(int numAxes, size_t maxPoints)
+  : numAxes_(numAxes), maxPoints_(maxPoints), rowSize_(1 + 2*numAxes),
+    head_(0), tail_(0), overruns_(0)
+{
+  rows_ = (double *)calloc(maxPoints_ * rowSize_, sizeof(double));
+  if (!rows_) maxPoints_ = 0;
+}
+
+asynMotorReadbackRing::~asynMotorReadbackRing()
+{
+  free(rows_);
+}
+
+/** Adds rows to the ring; called by the producer only.
+  * Rows that do not fit are dropped and counted in overruns().
+  * \param[in] firstPoint The point number of the first row; the others follow in order.
+  * \param[in] numPoints The number of rows.
+  * \param[in] readbacks The readback positions, numAxes values per row.
+  * \param[in] followingErrors The following errors, numAxes values per row; NULL for none.
+  * Returns the number of rows added. */
+size_t asynMotorReadbackRing::push(int firstPoint, size_t numPoints,
+                                   const double *readbacks, const double *followingErrors)
+{
+  size_t head = head_;
+  size_t space = maxPoints_ - (head - tail_);
+  size_t i, num;
+  double *row;
+
+  num = (numPoints < space) ? numPoints : space;
+  for (i=0; i<num; i++) {
+    row = &rows_[((head + i) % maxPoints_) * rowSize_];
+    row[0] = firstPoint + (double)i;
+    memcpy(&row[1], &readbacks[i*numAxes_], numAxes_*sizeof(double));
+    if (followingErrors)
+      memcpy(&row[1+numAxes_], &followingErrors[i*numAxes_], numAxes_*sizeof(double));
+    else
+      memset(&row[1+numAxes_], 0, numAxes_*sizeof(double));
+  }
+  if (num < numPoints) overruns_ = overruns_ + (numPoints - num);
+  MOTOR_BARRIER();
+  head_ = head + num;
+  return num;
+}
+
+/** Removes rows from the ring; called by the consumer only.
+  * The rows are returned by column: the point numbers, and one array per axis.
+  * \param[in] maxPoints The maximum number of rows to remove.
+  * \param[out] points The point number of each row.
+  * \param[out] readbacks The readback positions of each axis.
+  * \param[out] followingErrors The following errors of each axis.
+  * Returns the number of rows removed. */
+size_t asynMotorReadbackRing::pop(size_t maxPoints, double *points, double **readbacks, double **followingErrors)
+{
+  size_t tail = tail_;
+  size_t num = head_ - tail;
+  size_t i;
+  int axis;
+  const double *row;
+
+  MOTOR_BARRIER();
+  if (num > maxPoints) num = maxPoints;
+  for (i=0; i<num; i++) {
+    row = &rows_[((tail + i) % maxPoints_) * rowSize_];
+    points[i] = row[0];
+    for (axis=0; axis<numAxes_; axis++) {
+      readbacks[axis][i] = row[1+axis];
+      followingErrors[axis][i] = row[1+numAxes_+axis];
+    }
+  }
+  MOTOR_BARRIER();
+  tail_ = tail + num;
+  return num;
+}
+
+/** Returns the number of rows in the ring. */
+size_t asynMotorReadbackRing::used() const
+{
+  return head_ - tail_;
+}
+
+/** Returns the number of rows dropped because the ring was full. */
+size_t asynMotorReadbackRing::overruns() const
+{
+  return overruns_;
+}
@@ -0,0 +1,44 @@
+/* asynMotorReadbackRing.h
+ *
+ * This file defines the ring buffer that carries profile readbacks from a driver
+ * to asynMotorController while a profile executes, so that they can be published
+ * in chunks instead of only when readbackProfile() is called at the end.
+ *
+ * There is one producer, the driver thread that gathers the data, and one consumer,
+ * the controller thread that publishes it.  Neither takes a lock: each only writes its own
+ * counter, and MOTOR_BARRIER() from motorBarrier.h orders the rows against the counters.
+ */
+#ifndef asynMotorReadbackRing_H
+#define asynMotorReadbackRing_H
+
+#include <stddef.h>
+#include <shareLib.h>
+
+#ifdef __cplusplus
+
+/** Ring of profile readback rows.  Each row holds the point number, and the readback position
+  * and following error of every axis of the controller, in controller units. */
+class epicsShareClass asynMotorReadbackRing {
+
+  public:
+  asynMotorReadbackRing(int numAxes, size_t maxPoints);
+  ~asynMotorReadbackRing();
+
+  size_t push(int firstPoint, size_t numPoints, const double *readbacks, const double *followingErrors);
+  size_t pop(size_t maxPoints, double *points, double **readbacks, double **followingErrors);
+  size_t used() const;
+  size_t overruns() const;
+  size_t capacity() const { return maxPoints_; }
+
+  private:
+  int numAxes_;
+  size_t maxPoints_;
+  size_t rowSize_;              /**< Doubles per row; the point number then the readback and error of each axis */
+  double *rows_;
+  volatile size_t head_;        /**< Rows pushed; written only by the producer */
+  volatile size_t tail_;        /**< Rows popped; written only by the consumer */
+  volatile size_t overruns_;    /**< Rows dropped because the ring was full; written only by the producer */
+};
+
+#endif /* _cplusplus */
+#endif /* asynMotorReadbackRing_H */
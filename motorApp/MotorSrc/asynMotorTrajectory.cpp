@@ -0,0 +1,307 @@
+/* asynMotorTrajectory.cpp
+ *
+ * This file implements the trajectory pre-processing used by asynMotorController
+ * profile moves: limit checks, point velocities for PVT controllers, resampling to a fixed
+ * segment time and the output pulse schedule.  Each function is one or two linear passes
+ * over the arrays of one axis.
+ */
+#include <stdlib.h>
+#include <math.h>
+
+#define epicsExportSharedSymbols
+#include <shareLib.h>
+#include "asynMotorTrajectory.h"
+
+int trajectoryVelocities(int fitMode, size_t numPoints, const double *times,
+                         const double *positions, double *velocities)
+{
+  size_t i, n = numPoints;
+  double d0, d1, a, b, c, r, m;
+  double *cp;
+
+  if (n == 0) return 0;
+  if (n == 1) {
+    velocities[0] = 0.;
+    return 0;
+  }
+  d0 = (positions[1] - positions[0]) / times[0];
+  if (n == 2) {
+    velocities[0] = velocities[1] = d0;
+    return 0;
+  }
+
+  if (fitMode == PROFILE_FIT_MODE_LINEAR) {
+    velocities[0] = d0;
+    for (i=1; i<n-1; i++) {
+      d1 = (positions[i+1] - positions[i]) / times[i];
+      velocities[i] = (times[i]*d0 + times[i-1]*d1) / (times[i-1] + times[i]);
+      d0 = d1;
+    }
+    velocities[n-1] = d0;
+    return 0;
+  }
+
+  /* Natural cubic spline.  The first derivatives at the points satisfy the tridiagonal system
+   *   h[i] v[i-1] + 2(h[i-1]+h[i]) v[i] + h[i-1] v[i+1] = 3(h[i] d[i-1] + h[i-1] d[i])
+   * with 2 v[0] + v[1] = 3 d[0] and v[n-2] + 2 v[n-1] = 3 d[n-2] at the ends, where h[i] is the time
+   * and d[i] the mean velocity of segment i.  It is solved by forward elimination into cp and
+   * velocities, then back substitution. */
+  cp = (double *)malloc(n * sizeof(double));
+  if (!cp) return -1;
+  cp[0] = 0.5;
+  velocities[0] = 1.5 * d0;
+  for (i=1; i<n; i++) {
+    if (i < n-1) {
+      d1 = (positions[i+1] - positions[i]) / times[i];
+      a = times[i];
+      b = 2. * (times[i-1] + times[i]);
+      c = times[i-1];
+      r = 3. * (times[i]*d0 + times[i-1]*d1);
+      d0 = d1;
+    } else {
+      a = 1.;
+      b = 2.;
+      c = 0.;
+      r = 3. * d0;
+    }
+    m = b - a*cp[i-1];
+    cp[i] = c / m;
+    velocities[i] = (r - a*velocities[i-1]) / m;
+  }
+  for (i=n-1; i>0; i--) {
+    velocities[i-1] -= cp[i-1] * velocities[i];
+  }
+  free(cp);
+  return 0;
+}
+
+/* Reductions used by trajectoryCheckLimits().  Each is one pass with no branches that depend on
+ * earlier elements, so the compiler can vectorise them. */
+static double maxAbs(const double *x, size_t n)
+{
+  double m = 0.;
+  for (size_t i=0; i<n; i++) m = (fabs(x[i]) > m) ? fabs(x[i]) : m;
+  return m;
+}
+
+/* Returns the index of the first element with |x| > limit.
+ * Only called after maxAbs() has found that there is one. */
+static size_t firstAbove(const double *x, size_t n, double limit)
+{
+  size_t i;
+  for (i=0; i<n; i++) if (fabs(x[i]) > limit) break;
+  return i;
+}
+
+double trajectoryCheckLimits(size_t numPoints, const double *times, const double *inverseTimes,
+                             const double *positions, double maxVelocity, double maxAcceleration,
+                             double accelerationTime, double *segmentVelocities,
+                             double *accelerations, int *badPoint, int *badLimit)
+{
+  size_t k, numSegments = (numPoints > 0) ? numPoints-1 : 0;
+  double peak, required, scale = 1.;
+  int i, point;
+
+  *badPoint = 0;
+  *badLimit = TRAJECTORY_LIMIT_NONE;
+  if (numSegments < 1) return scale;
+
+  for (k=0; k<numSegments; k++)
+    segmentVelocities[k] = (positions[k+1] - positions[k]) * inverseTimes[k];
+
+  if (maxVelocity > 0.) {
+    peak = maxAbs(segmentVelocities, numSegments);
+    if (peak > maxVelocity) {
+      required = peak / maxVelocity;
+      if (required > scale) scale = required;
+      *badPoint = (int)firstAbove(segmentVelocities, numSegments, maxVelocity) + 1;
+      *badLimit = TRAJECTORY_LIMIT_VELOCITY;
+    }
+  }
+
+  if (maxAcceleration > 0.) {
+    /* Acceleration at each interior point; the first and last points are the ramps */
+    accelerations[0] = 0.;
+    for (k=1; k<numSegments; k++)
+      accelerations[k] = 2. * (segmentVelocities[k] - segmentVelocities[k-1]) / (times[k-1] + times[k]);
+    peak = maxAbs(accelerations, numSegments);
+    if (peak > maxAcceleration) {
+      /* The acceleration scales as the square of the velocity */
+      required = sqrt(peak / maxAcceleration);
+      if (required > scale) scale = required;
+      point = (int)firstAbove(accelerations, numSegments, maxAcceleration) + 1;
+      if ((*badPoint == 0) || (point < *badPoint)) {
+        *badPoint = point;
+        *badLimit = TRAJECTORY_LIMIT_ACCELERATION;
+      }
+    }
+    /* The ramps take a fixed time, so their acceleration scales as the velocity */
+    if (accelerationTime > 0.) {
+      for (i=0; i<2; i++) {
+        peak = fabs(segmentVelocities[i ? numSegments-1 : 0]) / accelerationTime;
+        if (peak <= maxAcceleration) continue;
+        required = peak / maxAcceleration;
+        if (required > scale) scale = required;
+        point = i ? (int)numPoints : 1;
+        if ((*badPoint == 0) || (point < *badPoint)) {
+          *badPoint = point;
+          *badLimit = TRAJECTORY_LIMIT_ACCELERATION;
+        }
+      }
+    }
+  }
+  return scale;
+}
+
+size_t trajectoryNumSamples(size_t numPoints, const double *times, double sampleTime)
+{
+  size_t i;
+  double total = 0.;
+
+  if ((numPoints == 0) || (sampleTime <= 0.)) return 0;
+  for (i=0; i<numPoints-1; i++) total += times[i];
+  /* A last interval shorter than 1e-9 of a sample is rounded away */
+  return (size_t)ceil(total/sampleTime - 1e-9) + 1;
+}
+
+void trajectoryResample(int fitMode, size_t numPoints, const double *times,
+                        const double *positions, const double *velocities,
+                        double sampleTime, size_t numSamples,
+                        double *samplePositions, double *sampleVelocities)
+{
+  size_t k, point = 0;
+  double time, total = 0., segmentStart = 0., h, s, s2;
+
+  if ((numPoints == 0) || (numSamples == 0)) return;
+  if (numPoints == 1) {
+    for (k=0; k<numSamples; k++) {
+      samplePositions[k] = positions[0];
+      if (sampleVelocities) sampleVelocities[k] = 0.;
+    }
+    return;
+  }
+  for (k=0; k<numPoints-1; k++) total += times[k];
+
+  /* Samples are in time order, so one pass advances through the segments */
+  for (k=0; k<numSamples; k++) {
+    time = (k == numSamples-1) ? total : k*sampleTime;
+    if (time > total) time = total;
+    while ((point < numPoints-2) && (time >= segmentStart + times[point])) {
+      segmentStart += times[point];
+      point++;
+    }
+    h = times[point];
+    s = (h > 0.) ? (time - segmentStart) / h : 0.;
+    if (s > 1.) s = 1.;
+    if (fitMode == PROFILE_FIT_MODE_LINEAR) {
+      samplePositions[k] = positions[point] + s*(positions[point+1] - positions[point]);
+      if (sampleVelocities) sampleVelocities[k] = (h > 0.) ? (positions[point+1] - positions[point]) / h : 0.;
+    } else {
+      samplePositions[k] = trajectoryHermite(h, positions[point], velocities[point],
+                                             positions[point+1], velocities[point+1], s);
+      if (sampleVelocities) {
+        s2 = s*s;
+        sampleVelocities[k] = (h > 0.) ?
+          ((6.*s2 - 6.*s)*positions[point] + (3.*s2 - 4.*s + 1.)*h*velocities[point] +
+           (6.*s - 6.*s2)*positions[point+1] + (3.*s2 - 2.*s)*h*velocities[point+1]) / h :
+          velocities[point];
+      }
+    }
+  }
+}
+
+void trajectorySegmentExtremes(double time, double p0, double v0, double p1, double v1,
+                               double *minPosition, double *maxPosition,
+                               double *maxVelocity, double *maxAcceleration)
+{
+  double a0, a1, qa, disc, t, p, v;
+  int i;
+
+  *minPosition = (p0 < p1) ? p0 : p1;
+  *maxPosition = (p0 > p1) ? p0 : p1;
+  *maxVelocity = (fabs(v0) > fabs(v1)) ? fabs(v0) : fabs(v1);
+  *maxAcceleration = 0.;
+  if (time <= 0.) return;
+
+  /* The acceleration is linear in time, so its extremes are at the ends */
+  a0 = (6.*(p1 - p0) - 2.*time*(2.*v0 + v1)) / (time*time);
+  a1 = (-6.*(p1 - p0) + 2.*time*(v0 + 2.*v1)) / (time*time);
+  *maxAcceleration = (fabs(a0) > fabs(a1)) ? fabs(a0) : fabs(a1);
+
+  /* The velocity v0 + a0 t + qa t^2 has its extreme where the acceleration changes sign */
+  qa = (a1 - a0) / (2.*time);
+  if (a0*a1 < 0.) {
+    t = time * a0 / (a0 - a1);
+    v = fabs(v0 + 0.5*a0*t);
+    if (v > *maxVelocity) *maxVelocity = v;
+  }
+
+  /* The position has its extremes where the velocity is 0 */
+  if (qa == 0.) {
+    if (a0 == 0.) return;
+    t = -v0 / a0;
+    if ((t > 0.) && (t < time)) {
+      p = trajectoryHermite(time, p0, v0, p1, v1, t/time);
+      if (p < *minPosition) *minPosition = p;
+      if (p > *maxPosition) *maxPosition = p;
+    }
+    return;
+  }
+  disc = a0*a0 - 4.*qa*v0;
+  if (disc < 0.) return;
+  for (i=0; i<2; i++) {
+    t = (-a0 + (i ? sqrt(disc) : -sqrt(disc))) / (2.*qa);
+    if ((t <= 0.) || (t >= time)) continue;
+    p = trajectoryHermite(time, p0, v0, p1, v1, t/time);
+    if (p < *minPosition) *minPosition = p;
+    if (p > *maxPosition) *maxPosition = p;
+  }
+}
+
+double trajectoryPulseTimes(size_t numPoints, const double *times, int startPoint, int endPoint,
+                            size_t numPulses, double *pulseTimes)
+{
+  double startTime = 0., time = 0., period;
+  int point;
+  size_t i;
+
+  /* Keep both points in the profile, so that only its times are summed */
+  if (endPoint > (int)numPoints) endPoint = (int)numPoints;
+  if (startPoint < 1) startPoint = 1;
+  if (startPoint > endPoint) startPoint = endPoint;
+  for (point=0; point<startPoint-1; point++) startTime += times[point];
+  for (; point<endPoint-1; point++) time += times[point];
+  period = (numPulses > 1) ? time / (numPulses-1) : 0.;
+  for (i=0; i<numPulses; i++) pulseTimes[i] = startTime + i*period;
+  return period;
+}
+
+void trajectoryInterpolate(int fitMode, size_t numPoints, const double *times,
+                           const double *positions, const double *velocities,
+                           size_t numValues, const double *valueTimes, double *values)
+{
+  size_t k, point = 0;
+  double segmentStart = 0., h, s;
+
+  if (numPoints == 0) return;
+  for (k=0; k<numValues; k++) {
+    if (numPoints == 1) {
+      values[k] = positions[0];
+      continue;
+    }
+    /* The times are in order, so one pass advances through the segments */
+    while ((point < numPoints-2) && (valueTimes[k] >= segmentStart + times[point])) {
+      segmentStart += times[point];
+      point++;
+    }
+    h = times[point];
+    s = (h > 0.) ? (valueTimes[k] - segmentStart) / h : 0.;
+    if (s < 0.) s = 0.;
+    if (s > 1.) s = 1.;
+    if (fitMode == PROFILE_FIT_MODE_CUBIC)
+      values[k] = trajectoryHermite(h, positions[point], velocities[point],
+                                    positions[point+1], velocities[point+1], s);
+    else
+      values[k] = positions[point] + s*(positions[point+1] - positions[point]);
+  }
+}
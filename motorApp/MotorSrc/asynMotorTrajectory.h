@@ -0,0 +1,100 @@
+/* asynMotorTrajectory.h
+ *
+ * This file defines the trajectory pre-processing used by asynMotorController
+ * when it builds a profile move: the velocity of each axis at each profile point,
+ * either for a piecewise linear path or for a cubic spline through the points,
+ * resampling of the path to the fixed segment time of a controller, the limit checks
+ * of validateProfile() and the output pulse schedule.
+ * This replaces client-side trajectory generation such as trajectoryGenerate.py.
+ *
+ * All functions work on one axis at a time and have no shared state, so that
+ * several axes can be processed in parallel.  Times are segment durations, as in
+ * asynMotorController::profileTimes_; times[i] is the time from point i to point i+1.
+ */
+#ifndef asynMotorTrajectory_H
+#define asynMotorTrajectory_H
+
+#include <stddef.h>
+#include <shareLib.h>
+
+/* How the path between profile points is fitted */
+enum ProfileFitMode{
+  PROFILE_FIT_MODE_LINEAR,
+  PROFILE_FIT_MODE_CUBIC
+};
+
+/* The limit that trajectoryCheckLimits() found exceeded at the first bad point */
+enum TrajectoryLimit{
+  TRAJECTORY_LIMIT_NONE,
+  TRAJECTORY_LIMIT_VELOCITY,
+  TRAJECTORY_LIMIT_ACCELERATION
+};
+
+#ifdef __cplusplus
+
+/** Computes the velocity at each profile point.
+  * PROFILE_FIT_MODE_LINEAR: the time-weighted mean of the velocities of the two adjacent segments,
+  * as used for PVT controllers by the XPS driver.
+  * PROFILE_FIT_MODE_CUBIC: the velocities of the natural cubic spline through the points,
+  * which has continuous acceleration.
+  * Returns 0, or -1 if memory could not be allocated. */
+epicsShareFunc int trajectoryVelocities(int fitMode, size_t numPoints, const double *times,
+                                        const double *positions, double *velocities);
+
+/** Checks the points of one axis against its velocity and acceleration limits.
+  * Computes the velocity of every segment into segmentVelocities and the acceleration at every
+  * interior point into accelerations (work arrays of numPoints-1 elements), from inverseTimes,
+  * 1/times, which the caller computes once for all of its axes.  The ramps from and to rest at the
+  * ends take accelerationTime.  maxVelocity and maxAcceleration are in the units of positions;
+  * 0 disables a check, as does an accelerationTime of 0 for the ramps.
+  * Returns the factor, 1 or more, by which all times must be multiplied to satisfy the limits, and sets
+  * badPoint to the first point (numbered from 1) that exceeds a limit, or 0, and badLimit to that limit. */
+epicsShareFunc double trajectoryCheckLimits(size_t numPoints, const double *times, const double *inverseTimes,
+                                            const double *positions, double maxVelocity, double maxAcceleration,
+                                            double accelerationTime, double *segmentVelocities,
+                                            double *accelerations, int *badPoint, int *badLimit);
+
+/** Returns the number of samples at sampleTime intervals that cover the profile,
+  * including the first and last points. */
+epicsShareFunc size_t trajectoryNumSamples(size_t numPoints, const double *times, double sampleTime);
+
+/** Evaluates the path at sampleTime intervals from the first point; the last sample is at the last point.
+  * The path between points is a straight line (PROFILE_FIT_MODE_LINEAR) or the cubic Hermite
+  * curve defined by the point positions and velocities.  sampleVelocities may be NULL. */
+epicsShareFunc void trajectoryResample(int fitMode, size_t numPoints, const double *times,
+                                       const double *positions, const double *velocities,
+                                       double sampleTime, size_t numSamples,
+                                       double *samplePositions, double *sampleVelocities);
+
+/** Computes the times of numPulses pulses spaced evenly in time from point startPoint to point endPoint
+  * (numbered from 1), measured from the first point, so the first and last pulses are at those points.
+  * Points outside 1 to numPoints are moved to the nearest end of the profile.
+  * Returns the time between pulses. */
+epicsShareFunc double trajectoryPulseTimes(size_t numPoints, const double *times, int startPoint, int endPoint,
+                                           size_t numPulses, double *pulseTimes);
+
+/** Evaluates the path at numValues times in increasing order, measured from the first point,
+  * as trajectoryResample() does at fixed intervals.  velocities is only used by PROFILE_FIT_MODE_CUBIC. */
+epicsShareFunc void trajectoryInterpolate(int fitMode, size_t numPoints, const double *times,
+                                          const double *positions, const double *velocities,
+                                          size_t numValues, const double *valueTimes, double *values);
+
+/** Finds the extremes of one cubic Hermite segment of duration time from position p0, velocity v0
+  * to position p1, velocity v1: the lowest and highest position, and the largest absolute velocity
+  * and acceleration anywhere in the segment, not only at its ends. */
+epicsShareFunc void trajectorySegmentExtremes(double time, double p0, double v0, double p1, double v1,
+                                              double *minPosition, double *maxPosition,
+                                              double *maxVelocity, double *maxAcceleration);
+
+/** Evaluates one cubic Hermite segment of duration time from position p0, velocity v0
+  * to position p1, velocity v1, at fraction s (0 to 1) of the segment. */
+inline double trajectoryHermite(double time, double p0, double v0, double p1, double v1, double s)
+{
+  double s2 = s*s;
+  double s3 = s2*s;
+  return (2.*s3 - 3.*s2 + 1.)*p0 + (s3 - 2.*s2 + s)*time*v0 +
+         (3.*s2 - 2.*s3)*p1 + (s3 - s2)*time*v1;
+}
+
+#endif /* _cplusplus */
+#endif /* asynMotorTrajectory_H */
@@ -43,6 +43,27 @@
  * Added "Use Relative" (use_rel) indicator to init_controller()'s "LOAD_POS" logic.
  * See README R6-10 item #6 for details.
  * 
+ * .07 2026-10-19
+ * Pass the driver's double positions to the motor record's RMPD/REPD fields and set DRAW, so
+ * sub-step resolution is kept. RMP and REP are rounded copies, clipped to the epicsInt32 range.
+ * 
+ * .08 2026-10-19
+ * Honour the motor record's PMIN field in update_values(); while a move is in progress, changes
+ * to RMP, REP, RMPD, REPD and RVEL are posted at most once every PMIN seconds. Pending changes
+ * are always posted with the status update that reports the move done.
+ * 
+ * .09 2026-10-19
+ * Register controller stop groups with motorUtil. allstop sends MOTOR_STOP_ALL once to each
+ * asyn port with a queued request, so the controllers are stopped in parallel.
+ * 
+ * .10 2026-10-19
+ * init_record() no longer waits for each initial LOAD_POS to complete; the loads of all records
+ * are queued, the controllers execute them concurrently, and init(after=1) waits for all of them
+ * once.  The record is initialised from the position being loaded.  A per-controller timing
+ * report of record initialisation is printed at the end of device support initialisation.
+ * dbScanLockOK is only set once the wait is over; loads that time out are reported by port
+ * and their events are destroyed.
+ * 
  */
 
 #include <stddef.h>
@@ -52,6 +73,10 @@
 #include <math.h>
 
 #include "motor_epics_inc.h"
+#include <epicsTime.h>
+#include <epicsString.h>
+#include <ellLib.h>
+#include <epicsMutex.h>
 
 #include <asynDriver.h>
 #include <asynInt32.h>
@@ -76,6 +101,9 @@ static RTN_STATUS build_trans( motor_cmnd, double *, struct motorRecord *);
 static RTN_STATUS end_trans(struct motorRecord *);
 static void asynCallback(asynUser *);
 static void statusCallback(void *, asynUser *, void *);
+static void *findStopGroup(struct dbCommon *);
+static int startStopGroup(void *);
+static void initWait(void);
 
 typedef enum {int32Type, float64Type, float64ArrayType} interfaceType;
 
@@ -149,20 +177,157 @@ typedef struct
     void *asynGenericPointerPvt;
     void *registrarPvt;
     epicsEventId initEvent;
+    epicsTimeStamp initDone;    /* Completion time of the initial LOAD_POS. */
     int driverReasons[NUM_MOTOR_COMMANDS];
+    unsigned int postPending;   /* Raw fields changed but not yet posted. */
+    epicsTimeStamp lastPost;
 } motorAsynPvt;
 
+/* postPending bits */
+#define POST_RMP  0x01
+#define POST_REP  0x02
+#define POST_RMPD 0x04
+#define POST_REPD 0x08
+#define POST_RVEL 0x10
+
+/* Controller stop group for motorUtil's allstop; one per asyn port.  pasynUser is
+ * NULL if the driver has no MOTOR_STOP_ALL parameter. */
+typedef struct
+{
+    ELLNODE node;
+    char *port;
+    asynUser *pasynUser;
+    asynInt32 *pasynInt32;
+    void *asynInt32Pvt;
+} motorAsynStopGroup;
+
+static ELLLIST stopGroupList;
+
+/* Record initialisation statistics of an asyn port, for the startup timing report. */
+typedef struct
+{
+    ELLNODE node;
+    char *port;
+    int records;
+    int loads;                  /* Initial LOAD_POS requests. */
+    int timeouts;               /* LOAD_POS requests not completed by initWait(). */
+    double recordTime;          /* Total time in init_record(). */
+    double loadTime;            /* Time from the first LOAD_POS request to the last completion. */
+    epicsTimeStamp firstLoad;
+} motorAsynInitStats;
+
+/* An initial LOAD_POS that init(after=1) waits for. */
+typedef struct
+{
+    ELLNODE node;
+    motorAsynPvt *pPvt;
+    motorAsynInitStats *pStats;
+    epicsTimeStamp start;
+} motorAsynInitLoad;
+
+static ELLLIST initStatsList;
+static ELLLIST initLoadList;
+static epicsMutexId initLock;   /* Protects initEvent between asynCallback() and initWait(). */
+
+/* Maximum time init(after=1) waits for all initial LOAD_POS requests to complete. */
+#define INIT_TIMEOUT 30.0
+
 
 
 /* The init routine is used to set a flag to indicate that it is OK to call dbScanLock */
 static int dbScanLockOK = 0;
 static long init( int after )
 {
-    dbScanLockOK = (after!=0);
+    if (!after)
+    {
+        dbScanLockOK = 0;
+        if (!initLock)
+            initLock = epicsMutexMustCreate();
+        motorUtilRegisterStopGroups(findStopGroup, startStopGroup);
+    }
+    else
+    {
+        /* Until initWait() returns, asynCallback() must not process the records. */
+        initWait();
+        dbScanLockOK = 1;
+    }
     return 0;
 }
 
-static void init_controller(struct motorRecord *pmr, asynUser *pasynUser )
+/* Returns the initialisation statistics of the port of an asyn motor record. */
+static motorAsynInitStats *findInitStats(motorAsynPvt *pPvt)
+{
+    motorAsynInitStats *pStats;
+    const char *port;
+
+    if (pasynManager->getPortName(pPvt->pasynUser, &port) != asynSuccess)
+        port = "unknown";
+
+    for (pStats = (motorAsynInitStats *)ellFirst(&initStatsList); pStats;
+         pStats = (motorAsynInitStats *)ellNext(&pStats->node))
+        if (strcmp(pStats->port, port) == 0)
+            return pStats;
+
+    pStats = callocMustSucceed(1, sizeof(motorAsynInitStats), "devMotorAsyn findInitStats()");
+    pStats->port = epicsStrDup(port);
+    ellAdd(&initStatsList, &pStats->node);
+    return pStats;
+}
+
+/* Waits once for the initial LOAD_POS requests of all records, which the controllers
+ * have been executing concurrently, and prints the timing report of each port. */
+static void initWait(void)
+{
+    motorAsynInitLoad *pLoad;
+    motorAsynInitStats *pStats;
+    epicsTimeStamp start, now;
+    double remaining;
+
+    epicsTimeGetCurrent(&start);
+    while ((pLoad = (motorAsynInitLoad *)ellGet(&initLoadList)))
+    {
+        motorAsynPvt *pPvt = pLoad->pPvt;
+
+        epicsTimeGetCurrent(&now);
+        remaining = INIT_TIMEOUT - epicsTimeDiffInSeconds(&now, &start);
+        if (epicsEventWaitWithTimeout(pPvt->initEvent, remaining > 0. ? remaining : 0.) == epicsEventWaitOK)
+        {
+            double loadTime = epicsTimeDiffInSeconds(&pPvt->initDone, &pLoad->pStats->firstLoad);
+
+            if (loadTime > pLoad->pStats->loadTime)
+                pLoad->pStats->loadTime = loadTime;
+        }
+        else
+        {
+            asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR,
+                      "devMotorAsyn::initWait, %s set position not complete after %.0f seconds\n",
+                      pPvt->pmr->name, INIT_TIMEOUT);
+            pLoad->pStats->timeouts++;
+        }
+        /* A request that completes later finds no event to signal. */
+        epicsMutexMustLock(initLock);
+        epicsEventDestroy(pPvt->initEvent);
+        pPvt->initEvent = 0;
+        epicsMutexUnlock(initLock);
+        free(pLoad);
+    }
+
+    while ((pStats = (motorAsynInitStats *)ellGet(&initStatsList)))
+    {
+        printf("devMotorAsyn: port %s, %d records, init_record %.3f s, %d positions loaded in %.3f s",
+               pStats->port, pStats->records, pStats->recordTime, pStats->loads, pStats->loadTime);
+        if (pStats->timeouts)
+            printf(", %d not complete", pStats->timeouts);
+        printf("\n");
+        if (pStats->timeouts)
+            errlogPrintf("devMotorAsyn::initWait, port %s did not load %d of %d positions within %.0f seconds\n",
+                         pStats->port, pStats->timeouts, pStats->loads, INIT_TIMEOUT);
+        free(pStats->port);
+        free(pStats);
+    }
+}
+
+static void init_controller(struct motorRecord *pmr, asynUser *pasynUser, motorAsynInitStats *pStats )
 {
     /* This routine is copied out of the old motordevCom and initialises the controller
        based on the record values. I think most of it should be transferred to init_record
@@ -183,9 +348,16 @@ static void init_controller(struct motorRecord *pmr, asynUser *pasynUser )
        )
     {
         double setPos = pmr->dval / pmr->mres;
-        epicsEventId initEvent = epicsEventCreate( epicsEventEmpty );
+        motorAsynInitLoad *pLoad = callocMustSucceed(1, sizeof(motorAsynInitLoad),
+                                                     "devMotorAsyn init_controller()");
 
-        pPvt->initEvent = initEvent;
+        pPvt->initEvent = epicsEventMustCreate( epicsEventEmpty );
+        pLoad->pPvt = pPvt;
+        pLoad->pStats = pStats;
+        epicsTimeGetCurrent(&pLoad->start);
+        if (pStats->loads++ == 0)
+            pStats->firstLoad = pLoad->start;
+        ellAdd(&initLoadList, &pLoad->node);
 
         start_trans(pmr);
         build_trans(LOAD_POS, &setPos, pmr);
@@ -195,12 +367,12 @@ static void init_controller(struct motorRecord *pmr, asynUser *pasynUser )
                   "devMotorAsyn::init_controller, %s set position to %f\n",
                   pmr->name, setPos );
 
-        if ( initEvent )
-        {
-            epicsEventMustWait(initEvent);
-            epicsEventDestroy(initEvent);
-            pPvt->initEvent = 0;
-        }
+        /* Do not wait for the controller; init(after=1) waits for all records at once.
+         * Until the driver reports the loaded position, report the position being
+         * loaded so that the motor record initialises from it. */
+        pPvt->status.position = setPos;
+        if (pmr->eres != 0.)
+            pPvt->status.encoderPosition = setPos * pmr->mres / pmr->eres;
     }
     else
         asynPrint(pasynUser, ASYN_TRACE_FLOW,
@@ -232,8 +404,12 @@ static long init_record(struct motorRecord * pmr )
     asynStatus status;
     asynInterface *pasynInterface;
     motorAsynPvt *pPvt;
+    motorAsynInitStats *pStats;
+    epicsTimeStamp initStart, initEnd;
     /*    double resolution;*/
 
+    epicsTimeGetCurrent(&initStart);
+
     /* Allocate motorAsynPvt private structure */
     pPvt = callocMustSucceed(1, sizeof(motorAsynPvt), "devMotorAsyn init_record()");
 
@@ -243,6 +419,7 @@ static long init_record(struct motorRecord * pmr )
     pPvt->pasynUser = pasynUser;
     pPvt->pmr = pmr;
     pmr->dpvt = pPvt;
+    pmr->draw = 1;      /* update_values() sets the double raw positions. */
 
     status = pasynEpicsUtils->parseLink(pasynUser, &pmr->out,
                                         &port, &signal, &userParam);
@@ -378,7 +555,8 @@ static long init_record(struct motorRecord * pmr )
      * the initial setting of position. Otherwise we won't be able to decide
      * whether or not to write new position values to the controller.
      */
-    init_controller(pmr, pasynUser);
+    pStats = findInitStats(pPvt);
+    init_controller(pmr, pasynUser, pStats);
     /* Do not need to manually retrieve the new status values, as if they are
      * set, a callback will be generated
      */
@@ -386,6 +564,10 @@ static long init_record(struct motorRecord * pmr )
     /* Finally, indicate to the motor record that these values can be used. */
     pasynManager->freeAsynUser(pasynUser);
     pPvt->needUpdate = 1;
+
+    epicsTimeGetCurrent(&initEnd);
+    pStats->records++;
+    pStats->recordTime += epicsTimeDiffInSeconds(&initEnd, &initStart);
     
     return(0);
 bad:
@@ -408,19 +590,31 @@ CALLBACK_VALUE update_values(struct motorRecord * pmr)
     if ( pPvt->needUpdate )
     {
         epicsInt32 rawvalue;
+        msta_field msta;
+        int post = 1;
 
-        rawvalue = (epicsInt32)floor(pPvt->status.position + 0.5);
+        if (pmr->rmpd != pPvt->status.position)
+        {
+            pmr->rmpd = pPvt->status.position;
+            pPvt->postPending |= POST_RMPD;
+        }
+        rawvalue = rawToSteps(pPvt->status.position);
         if (pmr->rmp != rawvalue)
         {
             pmr->rmp = rawvalue;
-            db_post_events(pmr, &pmr->rmp, DBE_VAL_LOG);
+            pPvt->postPending |= POST_RMP;
         }
 
-        rawvalue = (epicsInt32)floor(pPvt->status.encoderPosition + 0.5);
+        if (pmr->repd != pPvt->status.encoderPosition)
+        {
+            pmr->repd = pPvt->status.encoderPosition;
+            pPvt->postPending |= POST_REPD;
+        }
+        rawvalue = rawToSteps(pPvt->status.encoderPosition);
         if (pmr->rep != rawvalue)
         {
             pmr->rep = rawvalue;
-            db_post_events(pmr, &pmr->rep, DBE_VAL_LOG);
+            pPvt->postPending |= POST_REP;
         }
 
         /* Don't post MSTA changes here; motor record's process() function does efficent MSTA posting. */
@@ -430,7 +624,35 @@ CALLBACK_VALUE update_values(struct motorRecord * pmr)
         if (pmr->rvel != rawvalue)
         {
             pmr->rvel = rawvalue;
-            db_post_events(pmr, &pmr->rvel, DBE_VAL_LOG);
+            pPvt->postPending |= POST_RVEL;
+        }
+
+        /* Rate-limit posting while moving; always post with the final (done) status. */
+        msta.All = pPvt->status.status;
+        if (pmr->pmin > 0.0 && !msta.Bits.RA_DONE && !msta.Bits.RA_PROBLEM)
+        {
+            epicsTimeStamp now;
+
+            epicsTimeGetCurrent(&now);
+            if (epicsTimeDiffInSeconds(&now, &pPvt->lastPost) < pmr->pmin)
+                post = 0;
+            else
+                pPvt->lastPost = now;
+        }
+
+        if (post && pPvt->postPending)
+        {
+            if (pPvt->postPending & POST_RMPD)
+                db_post_events(pmr, &pmr->rmpd, DBE_VAL_LOG);
+            if (pPvt->postPending & POST_RMP)
+                db_post_events(pmr, &pmr->rmp, DBE_VAL_LOG);
+            if (pPvt->postPending & POST_REPD)
+                db_post_events(pmr, &pmr->repd, DBE_VAL_LOG);
+            if (pPvt->postPending & POST_REP)
+                db_post_events(pmr, &pmr->rep, DBE_VAL_LOG);
+            if (pPvt->postPending & POST_RVEL)
+                db_post_events(pmr, &pmr->rvel, DBE_VAL_LOG);
+            pPvt->postPending = 0;
         }
 
         rc = CALLBACK_DATA;
@@ -623,6 +845,7 @@ static void asynCallback(asynUser *pasynUser)
     motorAsynPvt *pPvt = (motorAsynPvt *)pasynUser->userPvt;
     motorRecord *pmr = pPvt->pmr;
     motorAsynMessage *pmsg = pasynUser->userData;
+    int command = pmsg->command;    /* pmsg is freed before the initial LOAD_POS is signalled. */
     int status;
     int commandIsMove = 0;
 
@@ -696,8 +919,13 @@ static void asynCallback(asynUser *pasynUser)
                   pmr->name, pasynUser->errorMessage);
     }
 
-    if ( pPvt->initEvent && pmsg->command == motorPosition) {
-        epicsEventSignal( pPvt->initEvent );
+    if (command == motorPosition) {
+        epicsMutexMustLock(initLock);
+        if (pPvt->initEvent) {
+            epicsTimeGetCurrent(&pPvt->initDone);
+            epicsEventSignal( pPvt->initEvent );
+        }
+        epicsMutexUnlock(initLock);
     }
 }
 
@@ -732,3 +960,76 @@ static void statusCallback(void *drvPvt, asynUser *pasynUser,
     }
 }
 
+
+static void stopGroupCallback(asynUser *pasynUser)
+{
+    motorAsynStopGroup *pGroup = (motorAsynStopGroup *)pasynUser->userPvt;
+    asynStatus status;
+
+    status = pGroup->pasynInt32->write(pGroup->asynInt32Pvt, pasynUser, 1);
+    if (status != asynSuccess)
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+                  "devMotorAsyn::stopGroupCallback, %s stop all failed: %s\n",
+                  pGroup->port, pasynUser->errorMessage);
+    motorUtilStopGroupDone(pGroup, status);
+}
+
+/* Returns the stop group of the controller of an asyn motor record, or NULL. */
+static void *findStopGroup(struct dbCommon *precord)
+{
+    motorRecord *pmr = (motorRecord *)precord;
+    motorAsynPvt *pPvt = (motorAsynPvt *)pmr->dpvt;
+    motorAsynStopGroup *pGroup;
+    asynInterface *pasynInterface;
+    asynDrvUser *pasynDrvUser;
+    asynUser *pasynUser;
+    const char *port;
+
+    if ((void *)pmr->dset != (void *)&devMotorAsyn || !pPvt || pmr->pact)
+        return NULL;
+    if (pasynManager->getPortName(pPvt->pasynUser, &port) != asynSuccess)
+        return NULL;
+
+    for (pGroup = (motorAsynStopGroup *)ellFirst(&stopGroupList); pGroup;
+         pGroup = (motorAsynStopGroup *)ellNext(&pGroup->node))
+        if (strcmp(pGroup->port, port) == 0)
+            return pGroup->pasynUser ? pGroup : NULL;
+
+    pGroup = callocMustSucceed(1, sizeof(motorAsynStopGroup), "devMotorAsyn findStopGroup()");
+    pGroup->port = epicsStrDup(port);
+    ellAdd(&stopGroupList, &pGroup->node);
+
+    pasynUser = pasynManager->createAsynUser(stopGroupCallback, 0);
+    pasynUser->userPvt = pGroup;
+    if (pasynManager->connectDevice(pasynUser, port, 0) != asynSuccess)
+    {
+        pasynManager->freeAsynUser(pasynUser);
+        return NULL;
+    }
+    pasynInterface = pasynManager->findInterface(pasynUser, asynInt32Type, 1);
+    if (!pasynInterface)
+        goto bad;
+    pGroup->pasynInt32 = (asynInt32 *)pasynInterface->pinterface;
+    pGroup->asynInt32Pvt = pasynInterface->drvPvt;
+    pasynInterface = pasynManager->findInterface(pasynUser, asynDrvUserType, 1);
+    if (!pasynInterface)
+        goto bad;
+    pasynDrvUser = (asynDrvUser *)pasynInterface->pinterface;
+    if (pasynDrvUser->create(pasynInterface->drvPvt, pasynUser, motorStopAllString, NULL, NULL) != asynSuccess)
+        goto bad;
+    pGroup->pasynUser = pasynUser;
+    return pGroup;
+
+bad:
+    pasynManager->disconnect(pasynUser);
+    pasynManager->freeAsynUser(pasynUser);
+    return NULL;
+}
+
+/* Queues the stop of all axes of a controller; the port thread writes MOTOR_STOP_ALL. */
+static int startStopGroup(void *group)
+{
+    motorAsynStopGroup *pGroup = (motorAsynStopGroup *)group;
+
+    return (pasynManager->queueRequest(pGroup->pasynUser, asynQueuePriorityHigh, 0) != asynSuccess);
+}
@@ -50,6 +50,10 @@ USAGE...        Definitions and structures common to all levels of motorRecord
  *                    the defined() operator.
  * .11 06-02-14 rls - Jens Eden's modification to add EPICS_BYTE_ORDER to the
  *                    logic of setting {MSB/LSB}_First.
+ * .12 10-19-26     - Added the controller stop group interface used by
+ *                    motorUtil's allstop.
+ * .13 10-19-26     - Added rawToSteps(), shared by the motor record and
+ *                    devMotorAsyn.
  */
 
 #ifndef INCmotorh
@@ -61,6 +65,7 @@ USAGE...        Definitions and structures common to all levels of motorRecord
 #include <osiUnistd.h> 
 #include <epicsVersion.h>
 #include <epicsEndian.h>
+#include <epicsTypes.h>
 
 /* Less than EPICS base version test.*/
 #ifndef EPICS_VERSION_INT
@@ -87,6 +92,23 @@ typedef enum CALLBACK_VALUES {NOTHING_DONE = 0, CALLBACK_DATA = 1} CALLBACK_VALU
 
 #define NINT(f) (long)((f)>0 ? (f)+0.5 : (f)-0.5)       /* Nearest integer. */
 
+/* MS Visual C only knows __inline in C files. */
+#if defined(_MSC_VER) && !defined(__cplusplus) && !defined(inline)
+#define inline __inline
+#endif
+
+/* Nearest step of a raw position, clipped to the epicsInt32 range of the
+ * integer raw fields (RMP, REP, RRBV).  A function, so that expressions such
+ * as (rdblvalue * rres) / mres are evaluated once. */
+static inline epicsInt32 rawToSteps(double f)
+{
+    if (f >= 2147483647.0)
+        return (epicsInt32) 2147483647;
+    if (f <= -2147483648.0)
+        return (epicsInt32) (-2147483647 - 1);
+    return (epicsInt32) NINT(f);
+}
+
 /* Motor Record Command Set. !WARNING! this enumeration must match ALL of the
    following (up to and including JOG_VELOCITY);
     - "oms_table" in devOmsCom.c
@@ -222,5 +244,22 @@ struct motor_dset
 /* All db_post_events() calls set both VALUE and LOG bits. */
 #define DBE_VAL_LOG (unsigned int) (DBE_VALUE | DBE_LOG)
 
+/* Controller stop groups for motorUtil's allstop.  Device support that can stop
+   all axes of a controller with one request registers a function that returns the
+   group (controller) of a motor record, or NULL, and a function that starts the
+   stop of a group without waiting for it.  When the controller has accepted the
+   stop, device support calls motorUtilStopGroupDone() with a zero status. */
+typedef void *(*MOTOR_STOP_GROUP_FIND) (struct dbCommon *);
+typedef int (*MOTOR_STOP_GROUP_START) (void *);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void motorUtilRegisterStopGroups(MOTOR_STOP_GROUP_FIND, MOTOR_STOP_GROUP_START);
+void motorUtilStopGroupDone(void *, int);
+#ifdef __cplusplus
+}
+#endif
+
 #endif  /* INCmotorh */
 
@@ -0,0 +1,41 @@
+/* motorBarrier.c
+ *
+ * This file implements motorBarrier() and motorAtomicAdd(), the fallbacks for
+ * MOTOR_BARRIER() and MOTOR_ATOMIC_ADD() on compilers without the intrinsics.
+ */
+#include <epicsMutex.h>
+#include <epicsThread.h>
+
+#define epicsExportSharedSymbols
+#include <shareLib.h>
+#include "motorBarrier.h"
+
+static epicsThreadOnceId barrierOnce = EPICS_THREAD_ONCE_INIT;
+static epicsMutexId barrierLock;
+
+static void barrierInit(void *arg)
+{
+    barrierLock = epicsMutexMustCreate();
+}
+
+/** Full memory barrier; locking and unlocking a mutex orders memory in every thread that uses it. */
+void motorBarrier(void)
+{
+    epicsThreadOnce(&barrierOnce, barrierInit, NULL);
+    epicsMutexMustLock(barrierLock);
+    epicsMutexUnlock(barrierLock);
+}
+
+/** Adds delta to *value and returns the new value; the mutex makes the update atomic
+  * with respect to every other motorAtomicAdd(). */
+int motorAtomicAdd(volatile int *value, int delta)
+{
+    int result;
+
+    epicsThreadOnce(&barrierOnce, barrierInit, NULL);
+    epicsMutexMustLock(barrierLock);
+    result = *value + delta;
+    *value = result;
+    epicsMutexUnlock(barrierLock);
+    return result;
+}
@@ -0,0 +1,39 @@
+/* motorBarrier.h
+ *
+ * This file defines MOTOR_BARRIER(), the full memory barrier used by motor code that shares
+ * data between threads without a lock, such as asynMotorReadbackRing and pmacDpram.
+ * Writes before the barrier are visible to other threads before writes after it, and
+ * reads after it do not see older data than reads before it.
+ *
+ * With GCC 4.1 or later it is __sync_synchronize().  Otherwise it is motorBarrier(), which
+ * locks and unlocks an epicsMutex; the OS makes memory consistent across both, so it is
+ * a barrier too, only slower.
+ *
+ * MOTOR_ATOMIC_ADD(p, n) adds n to the int at p and returns the new value, as one atomic
+ * step that is also a full barrier; it is __sync_add_and_fetch() or motorAtomicAdd().
+ */
+#ifndef motorBarrier_H
+#define motorBarrier_H
+
+#include <shareLib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+epicsShareFunc void motorBarrier(void);
+epicsShareFunc int motorAtomicAdd(volatile int *value, int delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+#define MOTOR_BARRIER() __sync_synchronize()
+#define MOTOR_ATOMIC_ADD(p, n) __sync_add_and_fetch((p), (n))
+#else
+#define MOTOR_BARRIER() motorBarrier()
+#define MOTOR_ATOMIC_ADD(p, n) motorAtomicAdd((p), (n))
+#endif
+
+#endif /* motorBarrier_H */
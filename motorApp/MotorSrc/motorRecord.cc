@@ -190,6 +190,18 @@ USAGE...        Motor Record Support.
  * .76 04-04-18 rls - If URIP is Yes and RDBL is inaccessible (e.g., CA server is down), do not start
  *                    a new target position move (sans Home search or Jog). 
  * .78 08-21-18 kmp - Reverted .69 stop on RA_PROBLEM true.
+ * .79 10-19-26     - Added monitored readback mode (RDBM = Monitor); a CA RDBL link is
+ *                    subscribed with dbCa and read from a cached value. RDBT/RSTL flag a
+ *                    stale readback.
+ * .80 10-19-26     - Double-precision raw readbacks. If device support sets DRAW, the
+ *                    dial readback is calculated from RMPD/REPD; RRBV, RMP and REP are
+ *                    rounded copies clipped to the 32 bit range.
+ * .81 10-19-26     - Rate-limited readback posting. While moving, monitor() posts the
+ *                    readback group (RBV, RRBV, RRBD, DRBV, DIFF, RDIF) at most once
+ *                    every PMIN seconds; the final values are posted when DMOV is set.
+ * .82 10-19-26     - Readback-only fast path. A device support callback that only changes
+ *                    the readbacks of a move in progress updates and posts the readback
+ *                    group without the full process() cycle; see readback_update().
  */                                                          
 
 #define VERSION 6.10
@@ -201,6 +213,9 @@ USAGE...        Motor Record Support.
 #include    <math.h>
 
 #include    "motor_epics_inc.h"
+#include    <dbCa.h>
+#include    <epicsMutex.h>
+#include    <epicsTime.h>
 
 #define GEN_SIZE_OFFSET
 #include    "motorRecord.h"
@@ -231,6 +246,8 @@ static inline void Debug(int level, const char *format, ...) {
 static RTN_STATUS do_work(motorRecord *, CALLBACK_VALUE);
 static void alarm_sub(motorRecord *);
 static void monitor(motorRecord *);
+static epicsUInt32 post_readbacks(motorRecord *, unsigned short);
+static bool readback_update(motorRecord *, unsigned int);
 static void process_motor_info(motorRecord *, bool);
 static void load_pos(motorRecord *);
 static void check_speed_and_resolution(motorRecord *);
@@ -240,6 +257,7 @@ static void set_userlimits(motorRecord *);
 static void range_check(motorRecord *, double *, double, double);
 static void clear_buttons(motorRecord *);
 static void syncTargetPosition(motorRecord *);
+static long get_rdbl(motorRecord *, double *);
 
 /*** Record Support Entry Table (RSET) functions. ***/
 
@@ -363,6 +381,7 @@ typedef union
         unsigned int M_MIP      :1;
         unsigned int M_DIFF     :1;
         unsigned int M_RDIF     :1;
+        unsigned int M_RRBD     :1;
     } Bits;
 } mmap_field;
 
@@ -475,6 +494,52 @@ static void callbackFunc(struct callback *pcb)
 }
 
 
+/*
+The monitored readback mode (RDBM = "Monitor") keeps the latest value of a CA
+RDBL link in the structure below.  It is allocated by init_record(), which
+saves the pointer in the motorRecord, and is updated by the dbCa monitor
+callback.  See get_rdbl() for its use.
+*/
+
+struct rdbl_cache       /* RDBL monitor cache structure. */
+{
+    epicsMutexId lock;
+    struct motorRecord *precord;
+    double value;
+    epicsTimeStamp time;        /* Arrival time of the last update. */
+    bool valid;                 /* Connected, with at least one update. */
+};
+
+static void rdblConnect(void *arg)
+{
+    struct rdbl_cache *pcache = (struct rdbl_cache *) arg;
+
+    if (dbCaIsLinkConnected(&pcache->precord->rdbl) == FALSE)
+    {
+        epicsMutexLock(pcache->lock);
+        pcache->valid = false;
+        epicsMutexUnlock(pcache->lock);
+    }
+}
+
+static void rdblMonitor(void *arg)
+{
+    struct rdbl_cache *pcache = (struct rdbl_cache *) arg;
+    double value;
+    long rtnstat;
+
+    rtnstat = dbCaGetLink(&pcache->precord->rdbl, DBR_DOUBLE, &value, NULL, NULL, NULL);
+    if (!RTN_SUCCESS(rtnstat))
+        return;
+
+    epicsMutexLock(pcache->lock);
+    pcache->value = value;
+    epicsTimeGetCurrent(&pcache->time);
+    pcache->valid = true;
+    epicsMutexUnlock(pcache->lock);
+}
+
+
 /******************************************************************************
         enforceMinRetryDeadband()
 
@@ -562,6 +627,24 @@ static long init_record(dbCommon* arg, int pass)
     callbackSetPriority(pmr->prio, &pcallback->dly_callback);
     pcallback->precord = pmr;
 
+    /*** subscribe to a CA readback link in monitored readback mode ***/
+    if (pmr->rdbm == motorRDBM_Monitor && pmr->rdbl.type == CA_LINK)
+    {
+        struct rdbl_cache *pcache;
+        short pvlMask = pmr->rdbl.value.pv_link.pvlMask;
+
+        pcache = (struct rdbl_cache *) callocMustSucceed(1, sizeof(struct rdbl_cache), errmsg);
+        pcache->lock = epicsMutexMustCreate();
+        pcache->precord = pmr;
+        pmr->rcac = (void *) pcache;
+        /* dbCaRemoveLink() clears the link options; restore them and ask for
+         * the native monitor, which dbCa otherwise only adds on the first
+         * dbCaGetLink() that rdblMonitor() would make. */
+        dbCaRemoveLink(&pmr->rdbl);
+        pmr->rdbl.value.pv_link.pvlMask = pvlMask | pvlOptInpNative;
+        dbCaAddLinkCallback(&pmr->rdbl, rdblConnect, rdblMonitor, pcache);
+    }
+
     /*
      * Reconcile two different ways of specifying speed and resolution; make
      * sure things are sane.
@@ -1202,6 +1285,12 @@ static long process(dbCommon *arg)
      * this is a callback.
      */
     process_reason = (*pdset->update_values) (pmr);
+    if (process_reason == CALLBACK_DATA && readback_update(pmr, old_msta) == true)
+    {
+        pmr->pact = 0;
+        Debug(4, "process:---------------------- end; readback only; motor \"%s\"\n", pmr->name);
+        return(OK);
+    }
     if (pmr->msta != old_msta)
         MARK(M_MSTA);
 
@@ -2339,7 +2428,7 @@ static RTN_STATUS do_work(motorRecord * pmr, CALLBACK_VALUE proc_ind)
             if (pmr->urip == motorUEIP_Yes)
             {
                 double test_drbv;
-                rtnstat = dbGetLink(&(pmr->rdbl), DBR_DOUBLE, &test_drbv, 0, 0 );
+                rtnstat = get_rdbl(pmr, &test_drbv);
                 if (RTN_SUCCESS(rtnstat))
                     rtnstat = TRUE;
                 else
@@ -3202,6 +3291,7 @@ static long get_graphic_double(DBADDR *paddr, struct dbr_grDouble * pgd)
 
     case motorRecordRVAL:
     case motorRecordRRBV:
+    case motorRecordRRBD:
         if (pmr->mres >= 0)
         {
             pgd->upper_disp_limit = pmr->dhlm / pmr->mres;
@@ -3253,6 +3343,7 @@ static long
 
     case motorRecordRVAL:
     case motorRecordRRBV:
+    case motorRecordRRBD:
         if (pmr->mres >= 0)
         {
             pcd->upper_ctrl_limit = pmr->dhlm / pmr->mres;
@@ -3372,16 +3463,23 @@ static void alarm_sub(motorRecord * pmr)
       status = recGblSetSevr((dbCommon *) pmr, STATE_ALARM, MAJOR_ALARM);
     }
 
+    if (pmr->rstl != 0)
+        status = recGblSetSevr((dbCommon *) pmr, READ_ALARM, MINOR_ALARM);
+
     return;
 }
 
 
 /******************************************************************************
-        monitor()
+        post_readbacks()
 
 LOGIC:
+    IF Min Readback Post Period (PMIN) > 0, AND, NOT Done Moving, AND,
+            monitor_mask is zero, AND, less than PMIN seconds since the last post.
+        Defer the readback group (RBV, RRBV, RRBD, DRBV, DIFF, RDIF); i.e.,
+            remove their marks and return them to the caller.
+    ENDIF
     Initalize local variables for MARKED and UNMARKED macros.
-    Set monitor_mask from recGblResetAlarms() return value.
     IF both Monitor (MDEL) and Archive (ADEL) Deadbands are zero.
         Set local_mask <- monitor_mask.
         IF RBV marked for value change
@@ -3412,28 +3510,37 @@ LOGIC:
             dbpost RBV.
         ENDIF            
     ENDIF
-
-    dbpost frequently changing PV's.
-    IF no PV's marked for value change.
-        EXIT.
-    ENDIF
-    
-    dbpost remaining PV's.
-    Clear all PF's marked for value change.
-    EXIT
+    dbpost remaining readback group PV's.
+    Return the marks of deferred readback PV's.
 
 *******************************************************************************/
-static void monitor(motorRecord * pmr)
+static epicsUInt32 post_readbacks(motorRecord * pmr, unsigned short monitor_mask)
 {
-    unsigned short monitor_mask, local_mask;
+    unsigned short local_mask;
     double delta = 0.0;
     mmap_field mmap_bits;
-    nmap_field nmap_bits;
+    epicsUInt32 deferred = 0;
 
-    mmap_bits.All = pmr->mmap; /* Initialize for MARKED. */
-    nmap_bits.All = pmr->nmap; /* Initialize for MARKED_AUX. */
+    if (pmr->pmin > 0.0 && pmr->dmov == FALSE && monitor_mask == 0)
+    {
+        epicsTimeStamp now;
 
-    monitor_mask = recGblResetAlarms(pmr);
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &pmr->ptim) < pmr->pmin)
+        {
+            mmap_field group;
+
+            group.All = 0;
+            group.Bits.M_RBV  = group.Bits.M_RRBV = group.Bits.M_RRBD = 1;
+            group.Bits.M_DRBV = group.Bits.M_DIFF = group.Bits.M_RDIF = 1;
+            deferred = pmr->mmap & group.All;
+            pmr->mmap &= ~deferred;
+        }
+        else
+            pmr->ptim = now;
+    }
+
+    mmap_bits.All = pmr->mmap; /* Initialize for MARKED. */
 
     if (pmr->mdel == 0.0 && pmr->adel == 0.0)
     {
@@ -3482,6 +3589,12 @@ static void monitor(motorRecord * pmr)
         db_post_events(pmr, &pmr->rrbv, local_mask);
         UNMARK(M_RRBV);
     }
+
+    if ((local_mask = monitor_mask | (MARKED(M_RRBD) ? DBE_VAL_LOG : 0)))
+    {
+        db_post_events(pmr, &pmr->rrbd, local_mask);
+        UNMARK(M_RRBD);
+    }
     
     if ((local_mask = monitor_mask | (MARKED(M_DRBV) ? DBE_VAL_LOG : 0)))
     {
@@ -3500,7 +3613,40 @@ static void monitor(motorRecord * pmr)
         db_post_events(pmr, &pmr->rdif, local_mask);
         UNMARK(M_RDIF);
     }
+
+    return(deferred);
+}
+
+
+/******************************************************************************
+        monitor()
+
+LOGIC:
+    Set monitor_mask from recGblResetAlarms() return value.
+    dbpost the readback group - call post_readbacks().
+    dbpost MSTA.
+    IF no PV's marked for value change.
+        Restore marks of deferred readback PV's.
+        EXIT.
+    ENDIF
     
+    dbpost remaining PV's.
+    Clear all PF's marked for value change.
+    Restore marks of deferred readback PV's.
+    EXIT
+
+*******************************************************************************/
+static void monitor(motorRecord * pmr)
+{
+    unsigned short monitor_mask, local_mask;
+    mmap_field mmap_bits;
+    nmap_field nmap_bits;
+    epicsUInt32 deferred;
+
+    monitor_mask = recGblResetAlarms(pmr);
+    deferred = post_readbacks(pmr, monitor_mask);
+
+    mmap_bits.All = pmr->mmap; /* Initialize for MARKED. */
     if ((local_mask = monitor_mask | (MARKED(M_MSTA) ? DBE_VAL_LOG : 0)))
     {
         msta_field msta;
@@ -3520,7 +3666,10 @@ static void monitor(motorRecord * pmr)
     }
 
     if ((pmr->mmap == 0) && (pmr->nmap == 0))
+    {
+        pmr->mmap = deferred;
         return;
+    }
 
     /* short circuit: less frequently posted PV's go below this line. */
     mmap_bits.All = pmr->mmap; /* Initialize for MARKED. */
@@ -3609,6 +3758,7 @@ static void monitor(motorRecord * pmr)
         db_post_events(pmr, &pmr->homr, local_mask);
 
     UNMARK_ALL;
+    pmr->mmap = deferred;       /* Post deferred readbacks next time. */
 }
 
 
@@ -3620,6 +3770,7 @@ static void process_motor_info(motorRecord * pmr, bool initcall)
     double old_drbv = pmr->drbv;
     double old_rbv = pmr->rbv;
     long old_rrbv = pmr->rrbv;
+    double old_rrbd = pmr->rrbd;
     short old_tdir = pmr->tdir;
     short old_movn = pmr->movn;
     short old_hls = pmr->hls;
@@ -3636,15 +3787,16 @@ static void process_motor_info(motorRecord * pmr, bool initcall)
     if (pmr->ueip == motorUEIP_Yes)
     {
         /* An encoder is present and the user wants us to use it. */
-        pmr->rrbv = pmr->rep;
-        pmr->drbv = pmr->rrbv * pmr->eres;
+        pmr->rrbd = pmr->draw ? pmr->repd : pmr->rep;
+        pmr->rrbv = rawToSteps(pmr->rrbd);
+        pmr->drbv = pmr->rrbd * pmr->eres;
     }
     else if (pmr->urip == motorUEIP_Yes && initcall == false)
     {
         double rdblvalue;
         long rtnstat;
 
-        rtnstat = dbGetLink(&(pmr->rdbl), DBR_DOUBLE, &rdblvalue, 0, 0 );
+        rtnstat = get_rdbl(pmr, &rdblvalue);
         if (!RTN_SUCCESS(rtnstat))
         {
             Debug(3, "process_motor_info: error reading RDBL link.\n");
@@ -3658,18 +3810,22 @@ static void process_motor_info(motorRecord * pmr, bool initcall)
         }
         else
         {
-            pmr->rrbv = NINT((rdblvalue * pmr->rres) / pmr->mres);
+            pmr->rrbv = rawToSteps((rdblvalue * pmr->rres) / pmr->mres);
+            pmr->rrbd = pmr->rrbv;
             pmr->drbv = pmr->rrbv * pmr->mres;
         }
     }
     else /* UEIP = URIP = No */
     {
-        pmr->rrbv = pmr->rmp;
-        pmr->drbv = pmr->rrbv * pmr->mres;
+        pmr->rrbd = pmr->draw ? pmr->rmpd : pmr->rmp;
+        pmr->rrbv = rawToSteps(pmr->rrbd);
+        pmr->drbv = pmr->rrbd * pmr->mres;
     }
 
     if (pmr->rrbv != old_rrbv)
         MARK(M_RRBV);
+    if (pmr->rrbd != old_rrbd)
+        MARK(M_RRBD);
     if (pmr->drbv != old_drbv)
         MARK(M_DRBV);
 
@@ -3727,6 +3883,73 @@ static void process_motor_info(motorRecord * pmr, bool initcall)
     MARK(M_RDIF);
 }
 
+/******************************************************************************
+        readback_update()
+
+Fast path of process() for a device support callback that only changes the
+readbacks of a move in progress; e.g., position updates during a long move.
+Returns true if the update was handled; otherwise, process() continues with
+the full cycle, which repeats process_motor_info() with the same result.
+
+LOGIC:
+    IF the status word (MSTA) changed, OR, the motor is not moving, OR,
+            DMOV is TRUE, OR, MIP is not a steady move (MOVE, RETRY, HOMF, HOMR,
+            MOVE_BL, EXTERNAL), OR, STOP or SPMG are set, OR, STUP is busy, OR,
+            the readback link (RDBL) is used, OR, an alarm has been raised,
+            OR, PV's other than the readback group are marked for posting.
+        Return false.
+    ENDIF
+    Update the readbacks - call process_motor_info().
+    IF PV's other than the readback group were marked, OR,
+            New Target Monitor (NTM) would stop the motor.
+        Return false.
+    ENDIF
+    Fire off the readback link (RLNK).
+    Update the time stamp.
+    dbpost the readback group - call post_readbacks(); the alarm state is
+        unchanged because its inputs (MSTA, DVAL, limits) are unchanged.
+    Return true.
+
+*******************************************************************************/
+static bool readback_update(motorRecord * pmr, unsigned int old_msta)
+{
+    const unsigned short steady = MIP_MOVE | MIP_RETRY | MIP_HOME | MIP_MOVE_BL | MIP_EXTERNAL;
+    mmap_field group;
+    epicsUInt32 deferred;
+
+    group.All = 0;
+    group.Bits.M_RBV  = group.Bits.M_RRBV = group.Bits.M_RRBD = 1;
+    group.Bits.M_DRBV = group.Bits.M_DIFF = group.Bits.M_RDIF = 1;
+
+    if (pmr->msta != old_msta || pmr->movn == 0 || pmr->dmov != 0 ||
+        pmr->mip == MIP_DONE || (pmr->mip & ~steady) != 0 ||
+        pmr->stop != 0 || pmr->spmg != motorSPMG_Go || pmr->stup != motorSTUP_OFF ||
+        pmr->urip != 0 || pmr->nsev != 0 ||
+        (pmr->mmap & ~group.All) != 0 || pmr->nmap != 0)
+        return(false);
+
+    process_motor_info(pmr, false);
+
+    if ((pmr->mmap & ~group.All) != 0 || pmr->nmap != 0)
+        return(false);
+
+    if (pmr->ntm == menuYesNoYES && (pmr->mip & (MIP_MOVE | MIP_RETRY)) != 0)
+    {
+        int sign_rdif = (pmr->rdif < 0) ? 0 : 1;
+        double ntm_deadband =  pmr->ntmf * (fabs(pmr->bdst) + pmr->rdbd);
+
+        if (sign_rdif != pmr->cdir && fabs(pmr->diff) > ntm_deadband)
+            return(false);
+    }
+
+    dbPutLink(&(pmr->rlnk), DBR_DOUBLE, &(pmr->rbv), 1);
+    recGblGetTimeStamp(pmr);
+    deferred = post_readbacks(pmr, 0);
+    pmr->mmap = deferred;       /* Post deferred readbacks next time. */
+    return(true);
+}
+
+
 /* Calc and load new raw position into motor w/out moving it. */
 static void load_pos(motorRecord * pmr)
 {
@@ -4129,27 +4352,31 @@ static void syncTargetPosition(motorRecord *pmr)
     if (pmr->ueip)
     {
         /* An encoder is present and the user wants us to use it. */
-        pmr->rrbv = pmr->rep;
-        pmr->drbv = pmr->rrbv * pmr->eres;
+        pmr->rrbd = pmr->draw ? pmr->repd : pmr->rep;
+        pmr->rrbv = rawToSteps(pmr->rrbd);
+        pmr->drbv = pmr->rrbd * pmr->eres;
     }
     else if (pmr->urip)
     {
         /* user wants us to use the readback link */
-        rtnstat = dbGetLink(&(pmr->rdbl), DBR_DOUBLE, &rdblvalue, 0, 0 );
+        rtnstat = get_rdbl(pmr, &rdblvalue);
         if (!RTN_SUCCESS(rtnstat))
             printf("%s: syncTargetPosition: error reading RDBL link.\n", pmr->name);
         else
         {
-            pmr->rrbv = NINT((rdblvalue * pmr->rres) / pmr->mres);
+            pmr->rrbv = rawToSteps((rdblvalue * pmr->rres) / pmr->mres);
+            pmr->rrbd = pmr->rrbv;
             pmr->drbv = pmr->rrbv * pmr->mres;
         }
     }
     else
     {
-        pmr->rrbv = pmr->rmp;
-        pmr->drbv = pmr->rrbv * pmr->mres;
+        pmr->rrbd = pmr->draw ? pmr->rmpd : pmr->rmp;
+        pmr->rrbv = rawToSteps(pmr->rrbd);
+        pmr->drbv = pmr->rrbd * pmr->mres;
     }
     MARK(M_RRBV);
+    MARK(M_RRBD);
     MARK(M_DRBV);
     pmr->rbv = pmr->drbv * dir + pmr->off;
     MARK(M_RBV);
@@ -4162,3 +4389,48 @@ static void syncTargetPosition(motorRecord *pmr)
     MARK(M_RVAL);
 }
 
+/*
+FUNCTION... long get_rdbl(motorRecord *, double *)
+USAGE... Read the readback link (RDBL).
+NOTES... If the link is monitored (RDBM = "Monitor" and RDBL is a CA link), the
+value comes from the cache updated by rdblMonitor(); an error is returned while
+the link is disconnected.  RSTL is set when the cached value is older than RDBT
+seconds (RDBT <= 0 disables the check); the stale value is still used.  In all
+other cases RDBL is read with dbGetLink().
+*/
+static long get_rdbl(motorRecord *pmr, double *value)
+{
+    struct rdbl_cache *pcache = (struct rdbl_cache *) pmr->rcac;
+    epicsTimeStamp now;
+    epicsTimeStamp time;
+    bool valid;
+    short stale = 0;
+
+    if (pcache == NULL)
+        return(dbGetLink(&(pmr->rdbl), DBR_DOUBLE, value, 0, 0));
+
+    epicsMutexLock(pcache->lock);
+    valid = pcache->valid;
+    *value = pcache->value;
+    time = pcache->time;
+    epicsMutexUnlock(pcache->lock);
+
+    if (valid == true && pmr->rdbt > 0.0)
+    {
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &time) > pmr->rdbt)
+            stale = 1;
+    }
+    if (pmr->rstl != stale)
+    {
+        pmr->rstl = stale;
+        db_post_events(pmr, &pmr->rstl, DBE_VAL_LOG);
+    }
+    if (valid == false)
+    {
+        recGblSetSevr((dbCommon *) pmr, LINK_ALARM, INVALID_ALARM);
+        return(-1);
+    }
+    return(0);
+}
+
@@ -24,21 +24,34 @@ USAGE...        Motor Record Utility Support.
 *                  - Added redundant initialization error check. 
 * .02 03-11-08 rls - 64 bit compatability.
 *                  - add printChIDlist() to iocsh.
+* .03 10-19-26     - Replaced Channel Access with direct database access; DMOV
+*                    and allstop are monitored through a database event context
+*                    and the outputs are written with dbPutField().
+*                  - Moving motors are kept in a lock-free set with an atomic
+*                    count, updated when DMOV changes, so updates and allstop
+*                    no longer scan all motors.
+* .04 10-19-26     - allstop first stops each controller with one request through
+*                    the stop groups registered by device support, in parallel
+*                    across controllers, then sets STOP on the moving records.
+*                    The stop latencies are kept for printChIDlist.
 */
 
 #include <stdio.h>
 #include <string.h>
-#include <cadef.h>
 #include <dbDefs.h>
+#include <dbAccess.h>
+#include <dbEvent.h>
+#include <epicsMutex.h>
 #include <epicsString.h>
+#include <epicsTime.h>
 #include <cantProceed.h>
+#include <initHooks.h>
 #include <iocsh.h>
 #include <epicsExport.h>
 #include <errlog.h>
 
 #include <motor.h>
-
-#define TIMEOUT 60 /* seconds */
+#include "motorBarrier.h"
 
 /* ----- External Declarations ----- */
 extern char **getMotorList();
@@ -46,24 +59,26 @@ extern char **getMotorList();
 
 /* ----- Function Declarations ----- */
 RTN_STATUS motorUtilInit(char *);
-static int motorUtil_task(void *);
-static chid getChID(char *);
-static long pvMonitor(int, chid, int);
-static void dmov_handler(struct event_handler_args);
-static void allstop_handler(struct event_handler_args);
-static void stopAll(chid, char *);
-static int motorMovingCount();
-static void moving(int, chid, short);
+static void motorUtil_start(initHookState);
+static int motorUtil_init();
+static int getAddr(char *, DBADDR *);
+static void dmov_handler(void *, DBADDR *, int, struct db_field_log *);
+static void allstop_handler(void *, DBADDR *, int, struct db_field_log *);
+static void stopAll(short);
+static void moving(int, short);
 /* ----- --------------------- ----- */
 
 
 typedef struct motor_pv_info
 {
     char name[PVNAME_SZ];      /* pv names limited to 60 chars + term. in dbDefs.h */
-    chid chid_dmov;     /* Channel id for <motor name>.DMOV */
-    chid chid_stop;     /* Channel id for <motor name>.STOP */
+    DBADDR addr_dmov;   /* Database address of <motor name>.DMOV */
+    DBADDR addr_stop;   /* Database address of <motor name>.STOP */
+    dbEventSubscription sub_dmov;
+    int group;          /* Index in stopGroups, or -1. */
     int in_motion;
-    int index;          /* Call to ca_add_event() must have ptr to argument. */
+    int slot;           /* Position in movingSet while in_motion. */
+    int index;          /* Passed to the DMOV event callback. */
 } Motor_pv_info;
 
 
@@ -76,12 +91,62 @@ int numMotors = 0;
 static Motor_pv_info *motorArray;
 static char **motorlist = 0;
 static char *vme;
-static int old_numMotorsMoving = 0;
-static short old_alldone_value = 1;
-static chid chid_allstop, chid_moving, chid_alldone, chid_movingdiff;
+static dbEventCtx eventCtx;
+static dbEventSubscription sub_allstop;
+static DBADDR addr_allstop, addr_moving, addr_alldone, addr_movingdiff;
+/* The moving set holds the motorArray indices of the moving motors in its first
+ * numMotorsMoving entries; each motor keeps its slot, so adding and removing one
+ * are O(1).  Only the event task changes the set, calling dmov_handler() and
+ * allstop_handler() one at a time, so it takes no lock.  The count is changed
+ * atomically after the entries, so the iocsh list/print commands read at most
+ * numMotorsMoving valid entries; a motor that moves meanwhile may be missed. */
+static int *movingSet;
+static volatile int numMotorsMoving = 0;
+/* Controller stop groups; see motor.h. */
+static MOTOR_STOP_GROUP_FIND stopGroupFind = NULL;
+static MOTOR_STOP_GROUP_START stopGroupStart = NULL;
+static void **stopGroups;
+static char *stopGroupStarted;
+static int numStopGroups = 0;
+/* allstop latencies, protected by statsLock */
+static epicsMutexId statsLock;
+static epicsTimeStamp stopStart;
+static int stopGroupsPending = 0;
+static int stopGroupsCount = 0;
+static double stopGroupLatency = 0.0;  /* Start to last controller accepting the stop. */
+static double stopRecordLatency = 0.0; /* Start to last record STOP put. */
 /* ----- ---------------- ----- */
 
 
+void motorUtilRegisterStopGroups(MOTOR_STOP_GROUP_FIND find, MOTOR_STOP_GROUP_START start)
+{
+    stopGroupFind = find;
+    stopGroupStart = start;
+}
+
+
+/* Called by device support, possibly from another thread, when a controller has
+ * accepted the stop started by stopAll(). */
+void motorUtilStopGroupDone(void *group, int status)
+{
+    epicsTimeStamp now;
+    double latency;
+
+    epicsTimeGetCurrent(&now);
+    epicsMutexMustLock(statsLock);
+    latency = epicsTimeDiffInSeconds(&now, &stopStart);
+    if (latency > stopGroupLatency)
+        stopGroupLatency = latency;
+    stopGroupsPending--;
+    epicsMutexUnlock(statsLock);
+
+    if (status)
+        errlogPrintf("motorUtil: controller stop failed, status = %i\n", status);
+    else if (motorUtil_debug)
+        errlogPrintf("controller stopped after %.3f ms\n", latency * 1000.0);
+}
+
+
 RTN_STATUS motorUtilInit(char *vme_name)
 {
     RTN_STATUS status = OK;
@@ -103,172 +168,211 @@ RTN_STATUS motorUtilInit(char *vme_name)
     initialized = true;
     vme = epicsStrDup(vme_name);
 
-    epicsThreadCreate((char *) "motorUtil", epicsThreadPriorityMedium,
-                      epicsThreadGetStackSize(epicsThreadStackMedium),
-                      (EPICSTHREADFUNC) motorUtil_task, (void *) NULL);
+    /* Database events can only be subscribed to once the IOC is running. */
+    if (interruptAccept)
+        motorUtil_init();
+    else
+        initHookRegister(motorUtil_start);
     return(status);
 }
 
 
-static int motorUtil_task(void *arg)
+static void motorUtil_start(initHookState state)
+{
+    if (state == initHookAfterIocRunning)
+        motorUtil_init();
+}
+
+
+static int motorUtil_init()
 {
     char temp[PVNAME_STRINGSZ+5];
-    int itera, status;
-    epicsEventId wait_forever;
+    int itera;
 
-    SEVCHK(ca_context_create(ca_enable_preemptive_callback),
-           "motorUtil: ca_context_create() error");
+    statsLock = epicsMutexMustCreate();
 
     motorlist = getMotorList();
     if (motorUtil_debug)
         errlogPrintf("There are %i motors\n", numMotors);
     
-    if (numMotors > 0)
+    if (numMotors <= 0)
+        return OK;
+
+    motorArray = (Motor_pv_info *) callocMustSucceed(numMotors,
+                               sizeof(Motor_pv_info), "motorUtil:init()");
+    movingSet = (int *) callocMustSucceed(numMotors, sizeof(int),
+                                          "motorUtil:init()");
+    stopGroups = (void **) callocMustSucceed(numMotors, sizeof(void *),
+                                             "motorUtil:init()");
+    stopGroupStarted = (char *) callocMustSucceed(numMotors, sizeof(char),
+                                                  "motorUtil:init()");
+
+    /* setup $(P)moving, $(P)alldone and $(P)movingDiff */
+    sprintf(temp, "%smoving.VAL", vme);
+    itera = getAddr(temp, &addr_moving);
+    sprintf(temp, "%salldone.VAL", vme);
+    itera |= getAddr(temp, &addr_alldone);
+    sprintf(temp, "%smovingDiff.VAL", vme);
+    itera |= getAddr(temp, &addr_movingdiff);
+    if (itera)
     {
-        motorArray = (Motor_pv_info *) callocMustSucceed(numMotors,
-                                   sizeof(Motor_pv_info), "motorUtil:init()");
-   
-        /* setup $(P)moving */
-        strcpy(temp, vme);
-        strcat(temp, "moving.VAL");
-        chid_moving = getChID(temp);
-
-        /* setup $(P)alldone */
-        strcpy(temp, vme);
-        strcat(temp, "alldone.VAL");
-        chid_alldone = getChID(temp);
-
-        /* setup $(P)movingDiff */
-        strcpy(temp, vme);
-        strcat(temp, "movingDiff.VAL");
-        chid_movingdiff = getChID(temp);
-
-	if (!chid_moving || !chid_alldone || !chid_movingdiff) {
-	    errlogPrintf("Failed to connect to %smoving or %salldone or %smovingDiff.\n"
-			 "Check prefix matches Db\n", vme, vme, vme);
-	    ca_task_exit();
-	    return ERROR;
-	}
-
-        /* loop over motors in motorlist and fill in motorArray */
-        for (itera=0; itera < numMotors; itera++)
-        {
-            motorArray[itera].index = itera;
-
-            /* Setup .DMOVs */
-            strcpy(motorArray[itera].name, motorlist[itera]);
-            strcpy(temp, motorlist[itera]);
-            strcat(temp, ".DMOV");
-            motorArray[itera].chid_dmov = getChID(temp);
-            status = pvMonitor(1, motorArray[itera].chid_dmov, itera);
-                    
-            /* Setup .STOPs */
-            strcpy(temp, motorlist[itera]);
-            strcat(temp, ".STOP");
-            motorArray[itera].chid_stop = getChID(temp);        
-        }
-
-        /* setup $(P)allstop */
-        strcpy(temp, vme);
-        strcat(temp, "allstop.VAL");
-        chid_allstop = getChID(temp);
-	if (!chid_allstop) {
-	    errlogPrintf("Failed to connect to %sallstop\n",vme);
-	} else {
-	    status = pvMonitor(0, chid_allstop, -1);
-	}
+        errlogPrintf("Failed to find %smoving or %salldone or %smovingDiff.\n"
+                     "Check prefix matches Db\n", vme, vme, vme);
+        return ERROR;
     }
-    
-    /* Wait on a (never signalled) event here, rather than suspending the
-       thread, so as not to show up in the thread list as "SUSPENDED", which
-       is usually a sign of a fault. */
-    wait_forever = epicsEventCreate(epicsEventEmpty);
-    if (wait_forever) {
-	epicsEventMustWait(wait_forever);
+
+    eventCtx = db_init_events();
+    if (!eventCtx ||
+        db_start_events(eventCtx, "motorUtil", NULL, NULL, epicsThreadPriorityMedium))
+    {
+        errlogPrintf("motorUtil: cannot start the database event task\n");
+        return ERROR;
     }
-    return(ERROR);
-}
 
+    /* loop over motors in motorlist and fill in motorArray */
+    for (itera=0; itera < numMotors; itera++)
+    {
+        Motor_pv_info *pmotor = &motorArray[itera];
 
-static chid getChID(char *PVname)
-{
-    chid channelID = 0;
-    int status;
+        pmotor->index = itera;
+        pmotor->group = -1;
+        strcpy(pmotor->name, motorlist[itera]);
 
-    if (motorUtil_debug)
-	errlogPrintf("getChID(%s)\n", PVname);
+        /* Setup .STOPs */
+        sprintf(temp, "%s.STOP", motorlist[itera]);
+        if (getAddr(temp, &pmotor->addr_stop))
+            continue;
 
-    /* In R3.14 ca_create_channel() will replace ca_search_and_connect() */
-    status = ca_search_and_connect(PVname, &channelID, 0, 0);
-    if (status == ECA_NORMAL) 
-    {
-	status = ca_pend_io(TIMEOUT);
+        /* Find the controller stop group of this motor, if any. */
+        if (stopGroupFind)
+        {
+            void *group = stopGroupFind(pmotor->addr_stop.precord);
+            int igroup;
+
+            for (igroup = 0; group && igroup < numStopGroups; igroup++)
+                if (stopGroups[igroup] == group)
+                    break;
+            if (group && igroup == numStopGroups)
+                stopGroups[numStopGroups++] = group;
+            if (group)
+                pmotor->group = igroup;
+        }
+
+        /* Setup .DMOVs; the first event gives the current value. */
+        sprintf(temp, "%s.DMOV", motorlist[itera]);
+        if (getAddr(temp, &pmotor->addr_dmov))
+            continue;
+        pmotor->sub_dmov = db_add_event(eventCtx, &pmotor->addr_dmov, dmov_handler,
+                                        &pmotor->index, DBE_VALUE);
+        if (!pmotor->sub_dmov)
+        {
+            errlogPrintf("motorUtil: db_add_event(%s) error\n", temp);
+            continue;
+        }
+        db_event_enable(pmotor->sub_dmov);
+        db_post_single_event(pmotor->sub_dmov);
     }
 
-    if (status != ECA_NORMAL)
+    /* setup $(P)allstop */
+    sprintf(temp, "%sallstop.VAL", vme);
+    if (getAddr(temp, &addr_allstop))
+        errlogPrintf("Failed to find %sallstop\n", vme);
+    else
     {
-        SEVCHK(status, "ca_search_and_connect");
-        errlogPrintf("motorUtil.cc: getChID(%s) error: %i\n", PVname, status);
-	channelID = 0;
+        sub_allstop = db_add_event(eventCtx, &addr_allstop, allstop_handler,
+                                   NULL, DBE_VALUE);
+        if (sub_allstop)
+            db_event_enable(sub_allstop);
     }
-    return channelID;
+    return OK;
 }
 
 
-static long pvMonitor(int eventType, chid channelID, int motor_index)
+static int getAddr(char *PVname, DBADDR *paddr)
 {
-    int status; 
+    long status;
 
-    /* Create monitor */
-    if (eventType)      /* moving() */
-        status = ca_add_event(DBR_SHORT, channelID, &dmov_handler,
-                              &(motorArray[motor_index].index), 0);
-    else                /* stopAll() */
-        status = ca_add_event(DBR_STRING, channelID, &allstop_handler, 0, 0);
-    status = ca_pend_io(TIMEOUT);
+    if (motorUtil_debug)
+	errlogPrintf("getAddr(%s)\n", PVname);
 
-    if (status != ECA_NORMAL)
+    status = dbNameToAddr(PVname, paddr);
+    if (status)
     {
-        SEVCHK(status, "ca_add_event");
-        ca_task_exit(); /* this is serious */
-        return status;
+        errlogPrintf("motorUtil.cc: getAddr(%s) error: %li\n", PVname, status);
+        return ERROR;
     }
-
-    return ECA_NORMAL;
+    return OK;
 }
 
 
-static void allstop_handler(struct event_handler_args args)
+static void allstop_handler(void *user_arg, DBADDR *paddr, int eventsRemaining,
+                            struct db_field_log *pfl)
 {
-    stopAll(args.chid, (char *) args.dbr);
+    short value;
+
+    if (dbGetField(paddr, DBR_SHORT, &value, NULL, NULL, pfl) == 0)
+        stopAll(value);
 }
 
 
-static void stopAll(chid callback_chid, char *callback_value)
+static void stopAll(short callback_value)
 {
-    int itera, status = 0;
+    Motor_pv_info *pmotor;
     short val = 1, release_val = 0;
+    epicsTimeStamp now;
+    int started = 0, itera;
     
-    if (callback_chid != chid_allstop)
-        errlogPrintf("callback_chid = %p, chid_allstop = %p\n", callback_chid,
-                      chid_allstop);
-    
-    if (strcmp(callback_value, "release") != 0)
+    if (callback_value != 0)
     {
-        /* if at least one motor is moving, then continue with stop all */
-        if (motorMovingCount())
+        epicsMutexMustLock(statsLock);
+        epicsTimeGetCurrent(&stopStart);
+        stopGroupLatency = 0.0;
+        stopGroupsPending = 0;
+        epicsMutexUnlock(statsLock);
+        memset(stopGroupStarted, 0, numStopGroups);
+
+        /* Only stop a motor that is moving.  This should avoid problems caused by trying
+        to stop motor records for which device and driver support have not been loaded.
+        This runs on the event task, so the moving set does not change meanwhile. */
+
+        /* Stop each controller with a moving motor first; the requests are queued
+           and run concurrently on the controllers' port threads. */
+        for (itera = 0; itera < numMotorsMoving; itera++)
         {
-            for(itera=0; itera < numMotors; itera++)
-	        /* Only stop a motor that is moving.  This should avoid problems caused by trying
-		to stop motor records for which device and driver support have not been loaded.*/
-                if (motorArray[itera].in_motion == 1)
-		    ca_put(DBR_SHORT, motorArray[itera].chid_stop, &val);
-            status = ca_flush_io(); 
+            pmotor = &motorArray[movingSet[itera]];
+            if (pmotor->group < 0 || stopGroupStarted[pmotor->group])
+                continue;
+            stopGroupStarted[pmotor->group] = 1;
+            epicsMutexMustLock(statsLock);
+            stopGroupsPending++;
+            epicsMutexUnlock(statsLock);
+            if (stopGroupStart(stopGroups[pmotor->group]))
+            {
+                errlogPrintf("motorUtil: cannot start controller stop for %s\n", pmotor->name);
+                epicsMutexMustLock(statsLock);
+                stopGroupsPending--;
+                epicsMutexUnlock(statsLock);
+            }
+            else
+                started++;
         }
 
+        /* Then stop the records, so that they do not retry or backlash; for motors
+           without a stop group this is the stop itself. */
+        for (itera = 0; itera < numMotorsMoving; itera++)
+            dbPutField(&motorArray[movingSet[itera]].addr_stop, DBR_SHORT, &val, 1);
+
+        epicsTimeGetCurrent(&now);
+        epicsMutexMustLock(statsLock);
+        stopGroupsCount = started;
+        stopRecordLatency = epicsTimeDiffInSeconds(&now, &stopStart);
+        epicsMutexUnlock(statsLock);
+        if (motorUtil_debug)
+            errlogPrintf("stopped %i controllers, records stopped after %.3f ms\n",
+                         started, stopRecordLatency * 1000.0);
+
         /* reset allstop so that it may be called again */
-        ca_put(DBR_SHORT, chid_allstop, &release_val);
-        status = ca_flush_io();
+        dbPutField(&addr_allstop, DBR_SHORT, &release_val, 1);
         if (motorUtil_debug)
             errlogPrintf("reset allstop to \"release\"\n");
     }
@@ -277,107 +381,97 @@ static void stopAll(chid callback_chid, char *callback_value)
 }
 
 
-static void dmov_handler(struct event_handler_args args)
+static void dmov_handler(void *user_arg, DBADDR *paddr, int eventsRemaining,
+                         struct db_field_log *pfl)
 {
-    moving(*((int *) args.usr), args.chid, *((short *) args.dbr));
+    short dmov;
+
+    if (dbGetField(paddr, DBR_SHORT, &dmov, NULL, NULL, pfl) == 0)
+        moving(*((int *) user_arg), dmov);
 }
 
 
-static void moving(int callback_motor_index, chid callback_chid,
-                   short callback_dmov)
+static void moving(int callback_motor_index, short callback_dmov)
 {
-    short new_alldone_value, done = 1, not_done = 0;
-    int numMotorsMoving, status;
+    Motor_pv_info *pmotor = &motorArray[callback_motor_index];
+    short done = 1, not_done = 0;
+    epicsInt32 count;
+    int last;
     char diffChar;
     char diffStr[PVNAME_STRINGSZ+1];
 
     if (motorUtil_debug)            
-        errlogPrintf("%s is %s\n", motorArray[callback_motor_index].name,
+        errlogPrintf("%s is %s\n", pmotor->name,
                (callback_dmov) ? "STOPPED" : "MOVING");
 
-    if (callback_dmov)
+    /* Only a change of state updates the set, the count and the outputs. */
+    if (callback_dmov && pmotor->in_motion)
     {                      
-        motorArray[callback_motor_index].in_motion = 0;
+        /* Move the last moving motor into this one's slot. */
+        pmotor->in_motion = 0;
+        last = movingSet[numMotorsMoving - 1];
+        movingSet[pmotor->slot] = last;
+        motorArray[last].slot = pmotor->slot;
+        count = MOTOR_ATOMIC_ADD(&numMotorsMoving, -1);
         diffChar = '-';
     }
-    else
+    else if (!callback_dmov && !pmotor->in_motion)
     {
-        motorArray[callback_motor_index].in_motion = 1;
+        pmotor->in_motion = 1;
+        pmotor->slot = numMotorsMoving;
+        movingSet[pmotor->slot] = callback_motor_index;
+        count = MOTOR_ATOMIC_ADD(&numMotorsMoving, 1);
         diffChar = '+';
     }
-    
-    numMotorsMoving = motorMovingCount();
-
-    new_alldone_value = (numMotorsMoving) ? 0 : 1;
-    
-    /* check to see if $(P)alldone needs to be updated */
-    if (new_alldone_value != old_alldone_value)
+    else
     {
-        /* give $(P)alldone the appropriate value */
-        if (numMotorsMoving == 0)
-        {
-            if (motorUtil_debug)
-                errlogPrintf("sending alldone = TRUE\n");
-
-            ca_put(DBR_SHORT, chid_alldone, &done);
-            old_alldone_value = new_alldone_value;
-        }
-        else
-        {
-            if (motorUtil_debug)
-                errlogPrintf("sending alldone = FALSE\n");
-
-            ca_put(DBR_SHORT, chid_alldone, &not_done);
-            old_alldone_value = new_alldone_value;
-        }
+        if (motorUtil_debug)
+            errlogPrintf("the number of motors moving remains the same.\n");
+        return;
     }
-    else if (motorUtil_debug)
-	errlogPrintf("the alldone value remains the same.\n");
 
-    /* check to see if $(P)moving needs to be updated */
-    if (numMotorsMoving != old_numMotorsMoving)
+    /* $(P)alldone changes when the first motor starts or the last one stops. */
+    if (count == 0)
     {
         if (motorUtil_debug)
-            errlogPrintf("updating number of motors moving\n");
-
-        /* give $(P)moving the appropriate value */
-        ca_put(DBR_LONG, chid_moving, &numMotorsMoving);
-	
-	/* Tell which motor's dmov changed */
-	sprintf(diffStr, "%c%s", diffChar, motorArray[callback_motor_index].name);
-	ca_array_put(DBR_CHAR, strlen(diffStr)+1, chid_movingdiff, diffStr); 
-
-        old_numMotorsMoving = numMotorsMoving;
+            errlogPrintf("sending alldone = TRUE\n");
+        dbPutField(&addr_alldone, DBR_SHORT, &done, 1);
+    }
+    else if (count == 1 && diffChar == '+')
+    {
+        if (motorUtil_debug)
+            errlogPrintf("sending alldone = FALSE\n");
+        dbPutField(&addr_alldone, DBR_SHORT, &not_done, 1);
     }
-    else if (motorUtil_debug)
-	errlogPrintf("the number of motors moving remains the same.\n");
-    
-    /* send the ca_puts */
-    status = ca_flush_io();
-}
-
 
-static int motorMovingCount()
-{
-    int itera, in_motion_count=0;
+    if (motorUtil_debug)
+        errlogPrintf("updating number of motors moving\n");
 
-    for (itera=0; itera < numMotors; itera++)
-        in_motion_count += motorArray[itera].in_motion;
+    /* give $(P)moving the appropriate value */
+    dbPutField(&addr_moving, DBR_LONG, &count, 1);
 
-    return in_motion_count;
+    /* Tell which motor's dmov changed */
+    sprintf(diffStr, "%c%s", diffChar, pmotor->name);
+    dbPutField(&addr_movingdiff, DBR_CHAR, diffStr, strlen(diffStr)+1);
 }
 
 
 void listMovingMotors()
 {
-    int itera;
+    Motor_pv_info *pmotor;
+    int itera, count;
   
     errlogPrintf("\nThe following motors are moving:\n");
     
-    for (itera=0; itera < numMotors; itera++)
-        if (motorArray[itera].in_motion == 1)
-            errlogPrintf("%s, index = %i\n", motorArray[itera].name,
-                   motorArray[itera].index);
+    if (!movingSet)
+        return;
+    count = numMotorsMoving;
+    MOTOR_BARRIER();
+    for (itera = 0; itera < count; itera++)
+    {
+        pmotor = &motorArray[movingSet[itera]];
+        errlogPrintf("%s, index = %i\n", pmotor->name, pmotor->index);
+    }
 }
 
 
@@ -387,16 +481,24 @@ void printChIDlist()
 
     for (itera=0; itera < numMotors; itera++)
     {
-        errlogPrintf("i = %i,\tname = %s\tchid_dmov = %p\tchid_stop = \
-               %p\tin_motion = %i\tindex = %i\n", itera,
-               motorArray[itera].name, motorArray[itera].chid_dmov,
-               motorArray[itera].chid_stop, motorArray[itera].in_motion,
-               motorArray[itera].index);
+        errlogPrintf("i = %i,\tname = %s\tsubscribed = %s\tin_motion = %i\tindex = %i\n",
+               itera, motorArray[itera].name,
+               motorArray[itera].sub_dmov ? "yes" : "no",
+               motorArray[itera].in_motion, motorArray[itera].index);
     }
     
-    errlogPrintf("chid_allstop = %p\n", chid_allstop);
-    errlogPrintf("chid_alldone = %p\n", chid_alldone);
-    errlogPrintf("chid_moving = %p\n",  chid_moving);
+    errlogPrintf("allstop subscribed = %s\n", sub_allstop ? "yes" : "no");
+    errlogPrintf("motors moving = %i\n", numMotorsMoving);
+
+    if (!statsLock)
+        return;
+    epicsMutexMustLock(statsLock);
+    errlogPrintf("controller stop groups = %i\n", numStopGroups);
+    errlogPrintf("last allstop: %i controllers, controllers stopped within %.3f ms%s, "
+                 "records stopped within %.3f ms\n", stopGroupsCount,
+                 stopGroupLatency * 1000.0, stopGroupsPending ? " (some pending)" : "",
+                 stopRecordLatency * 1000.0);
+    epicsMutexUnlock(statsLock);
 }
 
 
@@ -412,7 +514,7 @@ static void motorUtilCallFunc(const iocshArgBuf *args)
     motorUtilInit(args[0].sval);
 }
 
-static const iocshArg ArgP = {"Print motorUtil chid list", iocshArgString};
+static const iocshArg ArgP = {"Print motorUtil motor list", iocshArgString};
 static const iocshArg * const printChIDArg[1]  = {&ArgP};
 static const iocshFuncDef printChIDDef  = {"printChIDlist", 1, printChIDArg};
 
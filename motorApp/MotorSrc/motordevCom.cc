@@ -57,6 +57,8 @@ USAGE... This file contains device functions that are common to all motor
  * .14  08/19/14 rls Moved RMP and REP posting from record to here.
  * .15  07/29/15 rls Added "Use Relative" (use_rel) indicator to "init_pos" logic in
  *                   motor_init_record_com(). See README R6-10 item #6 for details.
+ * .16  10/19/26     Build commands directly into a pooled mess_node that is
+ *                   handed over to the driver by pointer.
  */
 
 
@@ -192,7 +194,6 @@ motor_init_record_com(struct motorRecord *mr, int brdcnt, struct driver_table *t
     bool initEncoder, initPos, initString, initPID;
     struct motor_trans *ptrans;
     MOTOR_AXIS_QUERY axis_query;
-    struct mess_node *motor_call;
     double ep_mp[2];            /* encoder pulses, motor pulses */
     int rtnStat;
     msta_field msta;
@@ -207,15 +208,14 @@ motor_init_record_com(struct motorRecord *mr, int brdcnt, struct driver_table *t
     ptrans->callback_changed = NO;
     ptrans->tabptr = tabptr;
     ptrans->dpm = false;
+    ptrans->motor_call = (struct mess_node *) NULL;
 
     /* Semaphore on private to record field data transfers */
     ptrans->lock = new epicsEvent(epicsEventFull);
-                                                        
-    motor_call = &(ptrans->motor_call);
 
     callbackSetCallback((void (*)(struct callbackPvt *)) motor_callback,
-                        &(motor_call->callback));
-    callbackSetPriority(priorityMedium, &(motor_call->callback));
+                        &(ptrans->callback));
+    callbackSetPriority(priorityMedium, &(ptrans->callback));
 
     /* check if axis already in use, then mark card, axis as in use */
     if (mr->out.type != VME_IO) /* out must be VME_IO. */
@@ -304,7 +304,7 @@ motor_init_record_com(struct motorRecord *mr, int brdcnt, struct driver_table *t
 
         /* Switch to special init callback so that record will not be processed during iocInit. */
         callbackSetCallback((void (*)(struct callbackPvt *)) motor_init_callback,
-                            &(motor_call->callback));
+                            &(ptrans->callback));
 
         if (initString == true)
         {
@@ -368,7 +368,7 @@ motor_init_record_com(struct motorRecord *mr, int brdcnt, struct driver_table *t
 
         /* Restore regular record callback */
         callbackSetCallback((void (*)(struct callbackPvt *)) motor_callback,
-                            &(motor_call->callback));
+                            &(ptrans->callback));
     }
 
     /* query motor for all info to fill into record */
@@ -433,7 +433,8 @@ epicsShareFunc CALLBACK_VALUE motor_update_values(struct motorRecord * mr)
 
 /*
 FUNCTION... long motor_start_trans_com(struct motorRecord *, struct board_stat **)
-USAGE... Start building a transaction.
+USAGE... Start building a transaction.  Gets a message node from the driver's
+    free list; device support builds the command directly into it.
 NOTES... This function MUST BE reentrant.
 */
 
@@ -447,17 +448,21 @@ epicsShareFunc long motor_start_trans_com(struct motorRecord *mr, struct board_s
     if (!mr->dpvt)
         return (S_dev_NoInit);
 
-    motor_call = &(trans->motor_call);
+    /* Reuse a node left over from an unfinished transaction. */
+    if (trans->motor_call == NULL)
+        trans->motor_call = motor_alloc(trans->tabptr);
+    motor_call = trans->motor_call;
 
-    /* initialize area to device private field to store command that is to be
+    /* initialize the node to store command that is to be
      * built and mark as command build in progress. */
 
     trans->state = BUILD_STATE;
+    motor_call->callback = trans->callback;
     motor_call->card = card;
     motor_call->signal = axis;
     motor_call->type = UNDEFINED;
     motor_call->mrecord = (struct dbCommon *) mr;
-    motor_call->message[0] = (char)  NULL;
+    motor_call->message[0] = '\0';
     motor_call->postmsgptr = (char*) NULL;
     motor_call->termstring = (char*) NULL;
     
@@ -467,7 +472,8 @@ epicsShareFunc long motor_start_trans_com(struct motorRecord *mr, struct board_s
 
 /*
 FUNCTION... long motor_end_trans_com(struct motorRecord *, struct driver_table *)
-USAGE... Finish building a transaction.
+USAGE... Finish building a transaction.  The message node is handed over to
+    the driver; it is no longer owned by the record after this call.
 NOTES... This function MUST BE reentrant.
 */
 
@@ -478,11 +484,18 @@ epicsShareFunc RTN_STATUS motor_end_trans_com(struct motorRecord *mr, struct dri
     RTN_STATUS rc;
 
     rc = OK;
-    motor_call = &(trans->motor_call);
+    motor_call = trans->motor_call;
+    if (motor_call == NULL)
+        return(rc = ERROR);
+    trans->motor_call = (struct mess_node *) NULL;
+
     if ((*trans->tabptr->card_array)[motor_call->card] == NULL)
     {
         msta_field msta;
 
+        (trans->tabptr->free) (motor_call, trans->tabptr);
+        trans->state = IDLE_STATE;
+
         /* If the controller does not exits, then set "done moving"
          * and the Hardware Problem bit TRUE.
          */
@@ -504,6 +517,7 @@ epicsShareFunc RTN_STATUS motor_end_trans_com(struct motorRecord *mr, struct dri
 
         case IDLE_STATE:
         default:
+            (trans->tabptr->free) (motor_call, trans->tabptr);
             rc = ERROR;
     }
     return (rc);
@@ -520,21 +534,23 @@ static void motor_callback(struct mess_node * motor_return)
 {
     struct motorRecord *mr = (struct motorRecord *) motor_return->mrecord;
     struct motor_trans *ptrans;
+    long position, encoder_position, velocity;
 
     ptrans = (struct motor_trans *) mr->dpvt;
 
     ptrans->lock->wait();
 
     ptrans->callback_changed = YES;
-    ptrans->motor_pos = motor_return->position;
-    ptrans->encoder_pos = motor_return->encoder_position;
-    ptrans->vel = motor_return->velocity;
-    ptrans->status = motor_return->status;
+    motor_read_node(motor_return, ptrans->tabptr, &position, &encoder_position,
+                    &velocity, &ptrans->status);
+    ptrans->motor_pos = position;
+    ptrans->encoder_pos = encoder_position;
+    ptrans->vel = velocity;
 
     /* load event for next transfer */
     ptrans->lock->signal();
 
-    /* free the return data buffer */
+    /* release the return data buffer; it may still be the driver's motion node */
     (ptrans->tabptr->free) (motor_return, ptrans->tabptr);
 
     dbScanLock((struct dbCommon *) mr);
@@ -549,16 +565,18 @@ static void motor_init_callback(struct mess_node * motor_return)
 {
     struct motorRecord *mr = (struct motorRecord *) motor_return->mrecord;
     struct motor_trans *ptrans;
+    long position, encoder_position, velocity;
 
     ptrans = (struct motor_trans *) mr->dpvt;
 
     ptrans->lock->wait();
 
     ptrans->callback_changed = YES;
-    ptrans->motor_pos = motor_return->position;
-    ptrans->encoder_pos = motor_return->encoder_position;
-    ptrans->vel = motor_return->velocity;
-    ptrans->status = motor_return->status;
+    motor_read_node(motor_return, ptrans->tabptr, &position, &encoder_position,
+                    &velocity, &ptrans->status);
+    ptrans->motor_pos = position;
+    ptrans->encoder_pos = encoder_position;
+    ptrans->vel = velocity;
 
     /* free the return data buffer */
     (ptrans->tabptr->free) (motor_return, ptrans->tabptr);
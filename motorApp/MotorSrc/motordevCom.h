@@ -24,6 +24,8 @@ USAGE...	This file contains definitions and structures that
  * Modification Log:
  * -----------------
  * .01 12-12-03 rls - Converted MSTA #define's to bit field.
+ * .02 10-19-26     - motor_call is a pointer to a pooled mess_node that is
+ *                    handed over to the driver by motor_end_trans_com().
  */
 
 
@@ -57,7 +59,8 @@ struct motor_trans
 {
     int state;
     epicsEvent *lock;
-    struct mess_node motor_call;
+    struct mess_node *motor_call;	/* Node being built; NULL when IDLE_STATE. */
+    CALLBACK callback;			/* Status callback copied into each node. */
     int callback_changed;
     int motor_pos;
     int encoder_pos;
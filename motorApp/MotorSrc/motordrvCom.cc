@@ -52,6 +52,11 @@ HeadURL:        $URL: https://subversion.xray.aps.anl.gov/synApps/motor/tags/R6-
  *                  messages.
  * .07 11/30/12 rls In process_messages(), pass commanded velocity from
  *                  motor_info->velocity to node->velocity with INFO request.
+ * .08 10/19/26     Zero-copy messages; motor_send() queues the caller's node
+ *                  instead of copying it, and query_axis() posts status
+ *                  callbacks on the motion node instead of a duplicate.
+ * .09 10/19/26     Status returns for one card and one scan cycle are
+ *                  batched into a single callbackRequest().
  */
 
 
@@ -59,6 +64,7 @@ HeadURL:        $URL: https://subversion.xray.aps.anl.gov/synApps/motor/tags/R6-
 #include        <string.h>
 #include        <callback.h>
 #include        <epicsThread.h>
+#include        <cantProceed.h>
 #include        <epicsExport.h>
 #include        <stdarg.h>
 
@@ -83,11 +89,25 @@ static inline void Debug(int level, const char *format, ...) {
   #endif
 }
 
+/* Status returns collected from one card during one scan cycle. */
+struct mess_batch
+{
+    CALLBACK callback;  /* !!WARNING!! - MUST be 1st structure member. */
+    struct mess_node *head;
+    struct mess_node *tail;
+    bool pending;       /* callbackRequest() outstanding for this batch. */
+    struct driver_table *tabptr;
+};
+
 /* Function declarations. */
-static double query_axis(int, struct driver_table *, epicsTime, double);
+static double query_axis(int, struct driver_table *, epicsTime, double,
+                         struct mess_batch *);
+static void batch_callback(CALLBACK *);
 static void process_messages(struct driver_table *, epicsTime, double);
 static struct mess_node *get_head_node(struct driver_table *);
 static struct mess_node *motor_malloc(struct circ_queue *, epicsEvent *);
+static void update_motion(int, int, struct mess_info *, bool,
+                          struct driver_table *, struct mess_batch *);
 
 
 /*
@@ -122,6 +142,7 @@ static struct mess_node *motor_malloc(struct circ_queue *, epicsEvent *);
  *          FOR each OMS board.
  *              IF motor data structure defined, AND, motor-in-motion indicator true.
  *                  Update OMS board status - call query_axis().
+ *                  Post the board's status returns as one callback batch.
  *              ENDIF
  *          ENDFOR
  *      ENDIF
@@ -141,6 +162,7 @@ epicsShareFunc int motor_task(struct thread_args *args)
     const double quantum = epicsThreadSleepQuantum();
     double half_quantum;
     int itera;
+    struct mess_batch *batches;
 
     tabptr = args->table;    
     previous_time = epicsTime::getCurrent();
@@ -155,6 +177,16 @@ epicsShareFunc int motor_task(struct thread_args *args)
 
     half_quantum = quantum / 2;
 
+    /* One status batch per card. */
+    batches = (struct mess_batch *) callocMustSucceed(*tabptr->cardcnt_ptr, sizeof(struct mess_batch),
+                                                      "motor_task()");
+    for (itera = 0; itera < *tabptr->cardcnt_ptr; itera++)
+    {
+        callbackSetCallback(batch_callback, &batches[itera].callback);
+        callbackSetPriority(priorityMedium, &batches[itera].callback);
+        batches[itera].tabptr = tabptr;
+    }
+
     for(;;)
     {
         if (*tabptr->any_inmotion_ptr == 0)
@@ -193,7 +225,8 @@ epicsShareFunc int motor_task(struct thread_args *args)
             {
                 struct controller *brdptr = (*tabptr->card_array)[itera];
                 if (brdptr != NULL && brdptr->motor_in_motion)
-                    stale_data_delay = query_axis(itera, tabptr, previous_time, stale_data_max_delay);
+                    stale_data_delay = query_axis(itera, tabptr, previous_time, stale_data_max_delay,
+                                                  &batches[itera]);
             }
         }
         process_messages(tabptr, previous_time, stale_data_max_delay);
@@ -203,7 +236,7 @@ epicsShareFunc int motor_task(struct thread_args *args)
 
 
 static double query_axis(int card, struct driver_table *tabptr, epicsTime tick,
-                         double max_delay)
+                         double max_delay, struct mess_batch *batch)
 {
     struct controller *brdptr;
     double rtndelay = 0.0;
@@ -236,51 +269,34 @@ static double query_axis(int card, struct driver_table *tabptr, epicsTime tick,
             }
             else if ((*tabptr->setstat) (card, index))
             {
-                struct mess_node *mess_ret;
                 bool ls_active;
 
-                motor_motion->position = motor_info->position;
-                motor_motion->encoder_position = motor_info->encoder_position;
-                motor_motion->velocity = motor_info->velocity;
-                motor_motion->status = motor_info->status;
-
-                mess_ret = (struct mess_node *) motor_malloc(tabptr->freeptr, tabptr->freelockptr);
-                mess_ret->callback = motor_motion->callback;
-                mess_ret->mrecord = motor_motion->mrecord;
-                mess_ret->position = motor_motion->position;
-                mess_ret->encoder_position = motor_motion->encoder_position;
-                mess_ret->velocity = motor_motion->velocity;
-                mess_ret->status = motor_motion->status;
-                mess_ret->type = motor_motion->type;
-
-                if (motor_motion->status.Bits.RA_DIRECTION)
+                if (motor_info->status.Bits.RA_DIRECTION)
                 {
-                    if (motor_motion->status.Bits.RA_PLUS_LS)
+                    if (motor_info->status.Bits.RA_PLUS_LS)
                         ls_active = true;
                     else
                         ls_active = false;
                 }
                 else
                 {
-                    if (motor_motion->status.Bits.RA_MINUS_LS)
+                    if (motor_info->status.Bits.RA_MINUS_LS)
                         ls_active = true;
                     else
                         ls_active = false;
                 }
 
                 if (ls_active == true ||
-                    motor_motion->status.Bits.RA_DONE ||
-                    motor_motion->status.Bits.RA_PROBLEM)
+                    motor_info->status.Bits.RA_DONE ||
+                    motor_info->status.Bits.RA_PROBLEM)
                 {
-                    (*tabptr->query_done) (card, index, motor_motion);
+                    update_motion(card, index, motor_info, true, tabptr, batch);
                     brdptr->motor_in_motion--;
-                    motor_free(motor_motion, tabptr);
                     motor_motion = (struct mess_node *) NULL;
                     motor_info->motor_motion = (struct mess_node *) NULL;
-                    mess_ret->status.Bits.RA_DONE = 1;
                 }
-
-                callbackRequest(&mess_ret->callback);
+                else
+                    update_motion(card, index, motor_info, false, tabptr, batch);
 
                 if (brdptr->motor_in_motion == 0)
                 {
@@ -289,11 +305,126 @@ static double query_axis(int card, struct driver_table *tabptr, epicsTime tick,
             }
         }
     }
+
+    /* Deliver this scan's status returns in one callback, unless the previous
+     * batch is still waiting in the callback queue; it picks these up. */
+    tabptr->freelockptr->wait();
+    if (batch->head != NULL && batch->pending == false)
+    {
+        batch->pending = true;
+        tabptr->freelockptr->signal();
+        callbackRequest(&batch->callback);
+    }
+    else
+        tabptr->freelockptr->signal();
+
     Debug(5, "query_axis: exit\n");
     return(rtndelay);
 }
 
 
+/*
+ * FUNCTION... batch_callback()
+ *
+ * USAGE... Callback for a card's status batch.  Runs each node's status
+ *          callback (motor_callback() in device support) in this one
+ *          callback thread pass.
+ */
+static void batch_callback(CALLBACK *cbptr)
+{
+    struct mess_batch *batch = (struct mess_batch *) cbptr;
+    struct driver_table *tabptr = batch->tabptr;
+    struct mess_node *node, *next;
+
+    tabptr->freelockptr->wait();
+    node = batch->head;
+    batch->head = batch->tail = (struct mess_node *) NULL;
+    batch->pending = false;
+    tabptr->freelockptr->signal();
+
+    for (; node != NULL; node = next)
+    {
+        next = node->batch_next;
+        node->batch_next = (struct mess_node *) NULL;
+        (*node->callback.callback) (&node->callback);
+    }
+}
+
+
+/*
+ * FUNCTION... update_motion()
+ *
+ * USAGE... Copy the latest axis status into the motion node and add it to the
+ *          card's status batch.
+ *
+ * LOGIC...
+ *  Lock free list.
+ *  Copy position, encoder position, velocity and status into the node.
+ *  IF motion is done.
+ *      Unlock free list.
+ *      Call driver's query_done().
+ *      Lock free list.
+ *      Set RA_DONE.
+ *      IF callback is already pending.
+ *          Drop the driver's reference; the pending callback frees the node.
+ *      ELSE
+ *          Hand the driver's reference over to the callback.
+ *      ENDIF
+ *  ELSE IF no callback is pending.
+ *      Add a reference for the callback.
+ *  ELSE
+ *      Nothing to request; the pending callback picks up the new data.
+ *  ENDIF
+ *  Append node to the card's status batch if needed.
+ *  Unlock free list.
+ */
+static void update_motion(int card, int index, struct mess_info *motor_info,
+                          bool done, struct driver_table *tabptr,
+                          struct mess_batch *batch)
+{
+    struct mess_node *node = motor_info->motor_motion;
+    bool request = false;
+
+    tabptr->freelockptr->wait();
+
+    node->position = motor_info->position;
+    node->encoder_position = motor_info->encoder_position;
+    node->velocity = motor_info->velocity;
+    node->status = motor_info->status;
+
+    if (done == true)
+    {
+        /* The driver still holds its reference, so the node stays valid. */
+        tabptr->freelockptr->signal();
+        (*tabptr->query_done) (card, index, node);
+        tabptr->freelockptr->wait();
+
+        node->status.Bits.RA_DONE = 1;
+        if (node->queued == true)
+            node->refs--;
+        else
+            request = node->queued = true;
+    }
+    else if (node->queued == false)
+    {
+        node->refs++;
+        request = node->queued = true;
+    }
+
+    if (request == true)
+    {
+        node->batch_next = (struct mess_node *) NULL;
+        if (batch->tail != NULL)
+            batch->tail->batch_next = node;
+        else
+            batch->head = node;
+        batch->tail = node;
+    }
+
+    tabptr->freelockptr->signal();
+}
+
+
 static void process_messages(struct driver_table *tabptr, epicsTime tick,
                              double max_delay)
 {
@@ -391,6 +522,7 @@ static void process_messages(struct driver_table *tabptr, epicsTime tick,
                 node->encoder_position = motor_info->encoder_position;
                 node->status = motor_info->status;
                 node->velocity = motor_info->velocity;
+                node->queued = true;
 
 /*=============================================================================
 * node->status & RA_DONE is not a reliable indicator of anything, in this case,
@@ -432,6 +564,7 @@ static void process_messages(struct driver_table *tabptr, epicsTime tick,
             node->velocity = 0;
             node->status.All = 0;
             node->status.Bits.RA_PROBLEM = 1;
+            node->queued = true;
             callbackRequest((CALLBACK *) node);
         }
     }
@@ -466,35 +599,46 @@ static struct mess_node *get_head_node(struct driver_table *tabptr)
     return (node);
 }
 
+/*
+ * FUNCTION... motor_alloc()
+ *
+ * USAGE... Get a message node from the driver's free list for device support
+ *          to build a command into.  The node is owned by the caller until it
+ *          is passed to motor_send() or motor_free().
+ */
+
+epicsShareFunc struct mess_node *motor_alloc(struct driver_table *tabptr)
+{
+    struct mess_node *node;
+
+    node = motor_malloc(tabptr->freeptr, tabptr->freelockptr);
+    node->refs = 1;
+    node->queued = false;
+    node->next = (struct mess_node *) NULL;
+    node->batch_next = (struct mess_node *) NULL;
+    node->status.All = 0;
+    node->message[0] = '\0';
+    return (node);
+}
+
 /*
  * FUNCTION... motor_send()
  *
- * USAGE... Send a command to the motor task queue.
+ * USAGE... Send a command to the motor task queue.  Ownership of the node
+ *          passes to the driver, whether or not the send succeeds.
  *
  * LOGIC...
- *  Allocate message node - call motor_malloc().
- *  Copy info. from input node to new node.
  *  Process node based on "type".
  *  Lock motor task queue.
- *  Insert new node at tail of queue.
+ *  Insert node at tail of queue.
  */
 
-epicsShareFunc RTN_STATUS motor_send(struct mess_node *u_msg, struct driver_table *tabptr)
+epicsShareFunc RTN_STATUS motor_send(struct mess_node *new_message, struct driver_table *tabptr)
 {
-    struct mess_node *new_message;
     struct circ_queue *qptr;
 
-    new_message = motor_malloc(tabptr->freeptr, tabptr->freelockptr);
-    new_message->callback = u_msg->callback;
     new_message->next = (struct mess_node *) NULL;
-    new_message->type = u_msg->type;
-    new_message->signal = u_msg->signal;
-    new_message->card = u_msg->card;
-    new_message->mrecord = u_msg->mrecord;
     new_message->status.All = 0;
-    strcpy(new_message->message, u_msg->message);
-    new_message->postmsgptr = u_msg->postmsgptr;
-    new_message->termstring = u_msg->termstring;
 
     switch (new_message->type)
     {
@@ -508,6 +652,7 @@ epicsShareFunc RTN_STATUS motor_send(struct mess_node *u_msg, struct driver_tabl
         case INFO:
             break;
         default:
+            motor_free(new_message, tabptr);
             return (ERROR);
     }
 
@@ -541,7 +686,7 @@ static struct mess_node *motor_malloc(struct circ_queue *freelistptr, epicsEvent
     lockptr->wait();
 
     if (!freelistptr->head)
-        node = (struct mess_node *) malloc(sizeof(struct mess_node));
+        node = (struct mess_node *) callocMustSucceed(1, sizeof(struct mess_node), "motor_malloc()");
     else
     {
         node = freelistptr->head;
@@ -555,6 +700,13 @@ static struct mess_node *motor_malloc(struct circ_queue *freelistptr, epicsEvent
     return (node);
 }
 
+/*
+ * FUNCTION... motor_free()
+ *
+ * USAGE... Drop one reference to a message node; the node is returned to the
+ *          free list when the last reference is dropped.
+ */
+
 epicsShareFunc int motor_free(struct mess_node * node, struct driver_table *tabptr)
 {
     struct circ_queue *freelistptr;
@@ -563,6 +715,12 @@ epicsShareFunc int motor_free(struct mess_node * node, struct driver_table *tabp
 
     tabptr->freelockptr->wait();
 
+    if (--node->refs > 0)
+    {
+        tabptr->freelockptr->signal();
+        return (0);
+    }
+
     node->next = (struct mess_node *) NULL;
 
     if (freelistptr->tail)
@@ -581,6 +739,29 @@ epicsShareFunc int motor_free(struct mess_node * node, struct driver_table *tabp
     return (0);
 }
 
+/*
+ * FUNCTION... motor_read_node()
+ *
+ * USAGE... Called from the status callback to copy the status out of a message
+ *          node.  Clears the node's callback pending indicator under the same
+ *          lock, so an update made after the copy requests a new callback.
+ */
+
+epicsShareFunc void motor_read_node(struct mess_node *node, struct driver_table *tabptr,
+                                    long *position, long *encoder_position,
+                                    long *velocity, msta_field *status)
+{
+    tabptr->freelockptr->wait();
+
+    *position = node->position;
+    *encoder_position = node->encoder_position;
+    *velocity = node->velocity;
+    *status = node->status;
+    node->queued = false;
+
+    tabptr->freelockptr->signal();
+}
+
 /*---------------------------------------------------------------------*/
 /*
  * both of these routines are only to be used at initialization time - before
@@ -39,6 +39,11 @@ USAGE...	This file contains definitions and structures that
  * .04 09-20-04 rls support for 32 axes / controller, maximum.
  * .05 05/10/05 rls Added "update_delay" for "Stale data delay" bug fix.
  * .06 10/18/05 rls Added MAX_TIMEOUT for all devices drivers.
+ * .07 10/19/26     mess_node's are pooled and handed over by pointer; added
+ *                  reference count for status callbacks that reuse the
+ *                  motion node.  Added motor_alloc().
+ * .08 10/19/26     Added batch_next; status returns from one card and scan
+ *                  cycle are delivered in a single callback.
  */
 
 
@@ -99,11 +104,18 @@ enum msg_types {
 #define	FLUSH -1 /* The 3rd argument of driver_table's getmsg() can indicate
 		either FLUSH the buffer or the # of commands to process. */
 
-/* message queue management - device and driver support only */
+/* message queue management - device and driver support only.
+ * Nodes are allocated from the driver's free list with motor_alloc(), built in
+ * place by device support and handed over to the driver with motor_send().
+ * The "refs" and "queued" members are protected by the driver's free list lock.
+ */
 struct mess_node
 {
     CALLBACK callback;	/* !!WARNING!! - MUST be 1st structure member. Calls to
 		    callbackRequest(CALLBACK *) use pointer to mess_node. */
+    int refs;		/* Owners of this node (driver and/or pending callback);
+			 * the node returns to the free list when it drops to 0. */
+    bool queued;	/* A status callback is pending on this node. */
     int signal;
     int card;
     msg_types type;
@@ -114,6 +126,7 @@ struct mess_node
     msta_field status;
     struct dbCommon *mrecord;	/* "Hidden" pointer to motor record. */
     struct mess_node *next;
+    struct mess_node *batch_next;	/* Link in a card's status batch. */
     char *postmsgptr;
     char const *termstring;	/* Termination string for STOP_AXIS command
 				    (see process_messages()). */
@@ -218,8 +231,11 @@ struct thread_args
 
 /* Function prototypes. */
 
+epicsShareFunc struct mess_node *motor_alloc(struct driver_table *);
 epicsShareFunc RTN_STATUS motor_send(struct mess_node *, struct driver_table *);
 epicsShareFunc int motor_free(struct mess_node *, struct driver_table *);
+epicsShareFunc void motor_read_node(struct mess_node *, struct driver_table *,
+                                    long *, long *, long *, msta_field *);
 epicsShareFunc int motor_card_info(int, MOTOR_CARD_QUERY *, struct driver_table *);
 epicsShareFunc int motor_axis_info(int, int, MOTOR_AXIS_QUERY *, struct driver_table *);
 epicsShareFunc int motor_task(struct thread_args *);
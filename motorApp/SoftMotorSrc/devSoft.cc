@@ -38,6 +38,11 @@ USAGE...        Motor record device level support for Soft channel.
  * .03 08-03-05 rls - Added debug messages.
  *                  - Fix compiler error with "gcc version 3.4.2 20041017 (Red
  *                    Hat 3.4.2-6.fc3)".
+ * .04 10-19-26     - Set a LINK INVALID alarm while any input link is not
+ *                    connected; see soft_link_func().
+ * .05 10-19-26     - Input links to PVs in this IOC (DB_LINK) are monitored
+ *                    with database events instead of Channel Access; see
+ *                    soft_db_add_link().
  */
 
 
@@ -54,7 +59,11 @@ NOTES...
 #include        <dbAccess.h>
 #include        <dbEvent.h>
 #include        <recSup.h>
+#include        <recGbl.h>
+#include        <ellLib.h>
+#include        <epicsThread.h>
 #include        <stdarg.h>
+#include        <stdlib.h>
 
 #include        "motorRecord.h"
 #include        "motor.h"
@@ -85,6 +94,20 @@ static long start(struct motorRecord *);
 static RTN_STATUS build(motor_cmnd, double *, struct motorRecord *);
 static RTN_STATUS end(struct motorRecord *);
 static void soft_process(struct motorRecord *);
+static void soft_db_event(void *, DBADDR *, int, struct db_field_log *);
+
+/* An input link to a PV in this IOC, monitored with database events. */
+struct soft_db_link
+{
+    ELLNODE node;
+    struct motorRecord *mr;
+    SOFT_LINKS link;
+    DBADDR addr;
+    dbEventSubscription event;
+};
+
+static dbEventCtx soft_db_ctx;
+static ELLLIST soft_db_list;
 
 
 struct motor_dset devMotorSoft =
@@ -127,6 +150,9 @@ static CALLBACK_VALUE update(struct motorRecord *mr)
         status.Bits.RA_DONE = 1;
     }
     mr->msta = status.All;
+
+    if (ptr->links_pending > 0)
+        recGblSetSevr(mr, LINK_ALARM, INVALID_ALARM);
     return(ptr->callback_flag);
 }
 
@@ -294,6 +320,33 @@ void soft_rdbl_func(struct motorRecord *mr, double newrdbl)
 }
 
 
+/*
+FUNCTION... void soft_link_func(struct motorRecord *, bool)
+USAGE...    Update the count of unconnected input links after a DINP, RDBL or
+            RINP link connects or disconnects.
+LOGIC...
+    Lock soft channel record.
+    Update count of unconnected links.
+    Unlock soft channel record.
+    IF the link disconnected.
+        Process soft channel record so the LINK alarm is raised.
+    ENDIF
+    A connected link processes the record with its first monitor.
+*/
+void soft_link_func(struct motorRecord *mr, bool connected)
+{
+    struct soft_private *ptr = (struct soft_private *) mr->dpvt;
+
+    dbScanLock((struct dbCommon *) mr);
+    ptr->links_pending += connected ? -1 : 1;
+    dbScanUnlock((struct dbCommon *) mr);
+
+    Debug(5, "soft_link_func(): %d links not connected for %s.\n", ptr->links_pending, mr->name);
+    if (connected == false && interruptAccept == TRUE)
+        soft_process(mr);
+}
+
+
 /*
 FUNCTION... static void soft_process(struct motorRecord *)
 USAGE...    Process the soft channel motor record.
@@ -331,3 +384,116 @@ void soft_motor_callback(CALLBACK *cbptr)
     soft_process((motorRecord *) mr);
 }
 
+
+
+/*
+FUNCTION... bool soft_db_add_link(struct motorRecord *, DBLINK *, SOFT_LINKS)
+USAGE...    Monitor a DB_LINK input link with a database event, so that
+            updates from PVs in this IOC do not go through Channel Access.
+            Returns false if the link must be monitored with CA.
+LOGIC...
+    IF the event context does not exist.
+        Create it, and start its task at the priority of the caller; i.e.,
+        below the "dbCaLink" task.
+    ENDIF
+    Find the address of the linked PV.
+    Add and enable a DBE_VALUE event on it.
+*/
+bool soft_db_add_link(struct motorRecord *mr, DBLINK *plink, SOFT_LINKS link)
+{
+    struct soft_db_link *pdb;
+
+    if (plink->type != DB_LINK || plink->value.pv_link.pvname == NULL)
+        return(false);
+
+    if (soft_db_ctx == NULL)
+    {
+        soft_db_ctx = db_init_events();
+        if (soft_db_ctx == NULL ||
+            db_start_events(soft_db_ctx, "soft_motor_db", NULL, NULL,
+                            epicsThreadGetPrioritySelf()))
+        {
+            errlogPrintf("devSoft: cannot start the database event task\n");
+            soft_db_ctx = NULL;
+            return(false);
+        }
+        ellInit(&soft_db_list);
+    }
+
+    pdb = (struct soft_db_link *) calloc(1, sizeof(struct soft_db_link));
+    if (pdb == NULL)
+        return(false);
+    pdb->mr = mr;
+    pdb->link = link;
+    if (dbNameToAddr(plink->value.pv_link.pvname, &pdb->addr) != 0 ||
+        (pdb->event = db_add_event(soft_db_ctx, &pdb->addr, soft_db_event,
+                                   pdb, DBE_VALUE)) == NULL)
+    {
+        free(pdb);
+        return(false);
+    }
+    db_event_enable(pdb->event);
+    ellAdd(&soft_db_list, &pdb->node);
+    Debug(5, "soft_db_add_link(): database event for %s link=%s\n", mr->name, plink->value.pv_link.pvname);
+    return(true);
+}
+
+
+/*
+FUNCTION... void soft_db_start()
+USAGE...    Post the current value of each database event link once interrupts
+            are accepted; values posted earlier are ignored by soft_*_func().
+*/
+void soft_db_start()
+{
+    struct soft_db_link *pdb;
+
+    if (soft_db_ctx == NULL)
+        return;
+
+    while (interruptAccept != TRUE)
+        epicsThreadSleep(0.1);
+
+    for (pdb = (struct soft_db_link *) ellFirst(&soft_db_list); pdb != NULL;
+         pdb = (struct soft_db_link *) ellNext(&pdb->node))
+        db_post_single_event(pdb->event);
+}
+
+
+/*
+FUNCTION... static void soft_db_event(void *, DBADDR *, int, struct db_field_log *)
+USAGE...    Database event callback of a DB_LINK input link; the database
+            counterpart of the CA monitors in devSoftAux.cc.
+*/
+static void soft_db_event(void *user_arg, DBADDR *paddr, int eventsRemaining,
+                          struct db_field_log *pfl)
+{
+    struct soft_db_link *pdb = (struct soft_db_link *) user_arg;
+
+    switch (pdb->link)
+    {
+        case SOFT_DINP:
+            {
+                short value;
+                if (dbGetField(paddr, DBR_SHORT, &value, NULL, NULL, pfl) == 0)
+                    soft_dinp_func(pdb->mr, value);
+            }
+            break;
+
+        case SOFT_RDBL:
+            {
+                double value;
+                if (dbGetField(paddr, DBR_DOUBLE, &value, NULL, NULL, pfl) == 0)
+                    soft_rdbl_func(pdb->mr, value);
+            }
+            break;
+
+        case SOFT_RINP:
+            {
+                epicsInt32 value;
+                if (dbGetField(paddr, DBR_LONG, &value, NULL, NULL, pfl) == 0)
+                    soft_rinp_func(pdb->mr, (long) value);
+            }
+            break;
+    }
+}
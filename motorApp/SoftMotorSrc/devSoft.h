@@ -28,6 +28,8 @@ USAGE... 	This file contains information that is common to
  * .02 09-23-04 rls Increase the maximum number of Soft Channel motor records
  *                  from 20 to 50.
  * .03 2006-04-10 pnd Convert to linked lists to remove arbitrary maximum
+ * .04 10-19-26     Added links_pending and soft_link_func().
+ * .05 10-19-26     Added SOFT_LINKS, soft_db_add_link() and soft_db_start().
  */
 
 #ifndef	INCdevSofth
@@ -38,6 +40,8 @@ USAGE... 	This file contains information that is common to
 
 typedef enum DONE_STATES {SOFTMOVE = 0, HARDMOVE = 1, DONE = 2} DONE_STATES;
 
+typedef enum SOFT_LINKS {SOFT_DINP, SOFT_RDBL, SOFT_RINP} SOFT_LINKS;
+
 struct soft_private
 {
     CALLBACK callback;
@@ -47,6 +51,8 @@ struct soft_private
 					 * "immediate done" default behavior. */
     bool initialized;			/* 1st RDBL call after interruptAccept is TRUE
 					 * sets this ON. */
+    int links_pending;			/* Number of DINP, RDBL and RINP links that
+					 * are not connected. */
 };
 
 struct motor_node {
@@ -59,6 +65,9 @@ extern long soft_init_record(void *);
 extern void soft_dinp_func(struct motorRecord *, short);
 extern void soft_rdbl_func(struct motorRecord *, double);
 extern void soft_rinp_func(struct motorRecord *, long);
+extern void soft_link_func(struct motorRecord *, bool);
+extern bool soft_db_add_link(struct motorRecord *, struct link *, SOFT_LINKS);
+extern void soft_db_start();
 extern void soft_motor_callback(CALLBACK *);
 
 #endif	/* INCdevSofth */
@@ -26,6 +26,13 @@ USAGE...        Motor record device level support for Soft channel.
  * .02 12-14-04 rls With EPICS R3.14.7 changes to epicsThread.h, need explicit
  *                  #include <stdlib.h>
  * .03 2006-04-10 pnd Convert to linked lists to remove arbitrary maximum
+ * .04 10-19-26     Connect the DINP, RDBL and RINP links of all soft motors in
+ *                  one batch; channels are created with connection callbacks
+ *                  and monitors are added when they connect, instead of a
+ *                  5 second ca_pend_io() per link with the record locked.
+ *                  Records are INVALID until all of their links connect.
+ * .05 10-19-26     Links to PVs in this IOC (DB_LINK) use database events;
+ *                  see soft_db_add_link() in devSoft.cc.
  */
 
 
@@ -44,6 +51,7 @@ in the same file; each defines (redefines) the DBR's.
 #include <dbLock.h>
 #include <callback.h>
 #include <epicsThread.h>
+#include <cantProceed.h>
 
 #include "motorRecord.h"
 #include "motor.h"
@@ -65,13 +73,30 @@ static inline void Debug(int level, const char *format, ...)
 #endif
 }
 
+/* A DINP, RDBL or RINP link of a soft motor. */
+struct soft_link
+{
+    struct motorRecord *mr;
+    const char *field;          /* Link field name, for messages. */
+    chtype type;                /* Monitor type. */
+    caEventCallBackFunc *func;  /* Monitor callback. */
+    chid chan;
+    evid event;
+    bool connected;
+};
+
 STATIC void soft_dinp(struct event_handler_args);
 STATIC void soft_rdbl(struct event_handler_args);
 STATIC void soft_rinp(struct event_handler_args);
+STATIC void soft_connect(struct connection_handler_args);
+STATIC bool soft_add_link(struct motorRecord *, DBLINK *, SOFT_LINKS, const char *,
+                          chtype, caEventCallBackFunc *);
 STATIC EPICSTHREADFUNC soft_motor_task(void *);
 STATIC epicsThreadId soft_motor_id;
 STATIC epicsEventId soft_motor_sem;
 STATIC ELLLIST soft_motor_list;
+STATIC struct soft_link *soft_links;
+STATIC int num_soft_links;
 
 STATIC void soft_dinp(struct event_handler_args args)
 {
@@ -89,6 +114,83 @@ STATIC void soft_rinp(struct event_handler_args args)
     soft_rinp_func((struct motorRecord *) args.usr, *((long *) args.dbr));
 }
 
+
+/*
+FUNCTION... void soft_connect(struct connection_handler_args)
+USAGE...    Connection callback for a soft motor link channel.
+LOGIC...
+    IF the channel connected for the first time.
+        Add the monitor.
+    ENDIF
+    Update the record's count of unconnected links - call soft_link_func().
+*/
+STATIC void soft_connect(struct connection_handler_args args)
+{
+    struct soft_link *plink = (struct soft_link *) ca_puser(args.chid);
+    struct motorRecord *mr = plink->mr;
+    bool up = (args.op == CA_OP_CONN_UP);
+
+    if (up == plink->connected)
+        return;
+
+    if (up && plink->event == NULL)
+    {
+        int status = ca_create_subscription(plink->type, 1, args.chid, DBE_VALUE,
+                                            plink->func, mr, &plink->event);
+        if (status != ECA_NORMAL)
+            errlogPrintf("devSoftAux: %s.%s monitor failure: %s\n", mr->name,
+                         plink->field, ca_message(status));
+    }
+
+    plink->connected = up;
+    Debug(5, "devSoftAux::soft_connect: %s.%s %s\n", mr->name, plink->field,
+          up ? "connected" : "disconnected");
+    soft_link_func(mr, up);
+}
+
+
+/* Creates the channel of a soft motor link, without waiting for it to connect. */
+STATIC bool soft_add_link(struct motorRecord *mr, DBLINK *plink, SOFT_LINKS link,
+                          const char *field, chtype type, caEventCallBackFunc *func)
+{
+    struct soft_private *ptr = (struct soft_private *) mr->dpvt;
+    struct soft_link *psoft = &soft_links[num_soft_links];
+    int status;
+
+    if (((plink->type != PV_LINK) &&
+         (plink->type != CA_LINK) &&
+         (plink->type != DB_LINK)) ||
+         (plink->value.pv_link.pvname == NULL))
+        return(false);
+
+    if (soft_db_add_link(mr, plink, link) == true)
+        return(true);
+
+    Debug(5, "devSoftAux::soft_add_link: adding %s link for motor %s link=%s\n", field, mr->name, plink->value.pv_link.pvname);
+    psoft->mr = mr;
+    psoft->field = field;
+    psoft->type = type;
+    psoft->func = func;
+    psoft->event = NULL;
+    psoft->connected = false;
+    dbScanLock((dbCommon *) mr);
+    ptr->links_pending++;
+    dbScanUnlock((dbCommon *) mr);
+    status = ca_create_channel(plink->value.pv_link.pvname, soft_connect, psoft,
+                               CA_PRIORITY_DEFAULT, &psoft->chan);
+    if (status != ECA_NORMAL)
+    {
+        errlogPrintf("devSoftAux: %s.%s ca_create_channel(%s) failure: %s\n", mr->name,
+                     field, plink->value.pv_link.pvname, ca_message(status));
+        dbScanLock((dbCommon *) mr);
+        ptr->links_pending--;
+        dbScanUnlock((dbCommon *) mr);
+        return(false);
+    }
+    num_soft_links++;
+    return(true);
+}
+
 long soft_init(int after)
 {
     if (!after)
@@ -149,6 +251,7 @@ long soft_init_record(void *arg)
     ptr = (struct soft_private *) mr->dpvt;
     ptr->dinp_value = (mr->dmov == 0) ? SOFTMOVE : DONE; /* Must match after initialzation. */
     ptr->initialized = false;
+    ptr->links_pending = 0;
 
     cbptr = &ptr->callback;
     callbackSetCallback((void (*)(struct callbackPvt *)) soft_motor_callback, cbptr);
@@ -162,12 +265,19 @@ STATIC EPICSTHREADFUNC soft_motor_task(void *parm)
 {
     struct motorRecord *mr;
     struct motor_node *node;
-    chid dinp, rdbl, rinp;
     epicsEventId wait_forever;
+    int itera, pending;
 
     epicsEventWait(soft_motor_sem);     /* Wait for dbLockInitRecords() to execute. */
     SEVCHK(ca_context_create(ca_enable_preemptive_callback), "soft_motor_task: ca_context_create() error");
 
+    /* Up to three links per soft motor. */
+    soft_links = (struct soft_link *) callocMustSucceed(3 * ellCount(&soft_motor_list) + 1,
+                                sizeof(struct soft_link), "devSoftAux::soft_motor_task");
+
+    /* Search for all links of all soft motors; the connection callbacks add
+       the monitors, so nothing here waits for a channel to connect.  Links
+       to PVs in this IOC are monitored with database events instead. */
     while ((node = (struct motor_node *) ellGet(&soft_motor_list)))
     {
         struct soft_private *ptr;
@@ -179,56 +289,39 @@ STATIC EPICSTHREADFUNC soft_motor_task(void *parm)
         ptr = (struct soft_private *) mr->dpvt;
         Debug(5, "devSoftAux::soft_motor_task: motor %s link type=%d\n", mr->name, mr->dinp.type);
         Debug(5, "devSoftAux::soft_motor_task: motor %s constantStr=%s dinp link=%s\n", mr->name, mr->dinp.value.constantStr, mr->dinp.value.pv_link.pvname);
-        if (((mr->dinp.type == PV_LINK) || 
-             (mr->dinp.type == CA_LINK) ||
-             (mr->dinp.type == DB_LINK)) &&
-             (mr->dinp.value.pv_link.pvname != NULL)) 
-        {
-            ptr->default_done_behavior = false;
-            Debug(5, "devSoftAux::soft_motor_task: adding dinp link for motor %s link=%s\n", mr->name, mr->dinp.value.pv_link.pvname);
-            SEVCHK(ca_search(mr->dinp.value.pv_link.pvname, &dinp),
-                   "ca_search() failure");
-            SEVCHK(ca_add_event(DBR_SHORT, dinp, soft_dinp, mr, NULL),"ca_add_event() failure");
-            SEVCHK(ca_pend_io((float) 5.0), "DINP link failure");
-        }
-        else
-        {
-            ptr->default_done_behavior = true;
-        }
-    
-        if ((mr->urip != 0) &&
-            ((mr->rdbl.type == PV_LINK) || 
-             (mr->rdbl.type == CA_LINK) ||
-             (mr->rdbl.type == DB_LINK)) &&
-             (mr->rdbl.value.pv_link.pvname != NULL)) 
-        {
-            Debug(5, "devSoftAux::soft_motor_task: adding rdbl link for motor %s link=%s\n", mr->name, mr->rdbl.value.pv_link.pvname);
-            SEVCHK(ca_search(mr->rdbl.value.pv_link.pvname, &rdbl),"ca_search() failure");
-            SEVCHK(ca_add_event(DBR_DOUBLE, rdbl, soft_rdbl, mr, NULL),"ca_add_event() failure");
-            SEVCHK(ca_pend_io((float) 5.0), "RDBL link failure");
-        }
+        ptr->default_done_behavior =
+            !soft_add_link(mr, &mr->dinp, SOFT_DINP, "DINP", DBR_SHORT, soft_dinp);
 
-        if (((mr->rinp.type == PV_LINK) || 
-             (mr->rinp.type == CA_LINK) ||
-             (mr->rinp.type == DB_LINK)) &&
-             (mr->rinp.value.pv_link.pvname != NULL))
-        {
-            Debug(5, "devSoftAux::soft_motor_task: adding rinp link for motor %s link=%s\n", mr->name, mr->rinp.value.pv_link.pvname);
-            SEVCHK(ca_search(mr->rinp.value.pv_link.pvname, &rinp),"ca_search() failure");
-            SEVCHK(ca_add_event(DBR_LONG, rinp, soft_rinp, mr, NULL),"ca_add_event() failure");
-            SEVCHK(ca_pend_io((float) 5.0), "RINP link failure");
-        }
+        if (mr->urip != 0)
+            soft_add_link(mr, &mr->rdbl, SOFT_RDBL, "RDBL", DBR_DOUBLE, soft_rdbl);
+
+        soft_add_link(mr, &mr->rinp, SOFT_RINP, "RINP", DBR_LONG, soft_rinp);
         dbScanUnlock((dbCommon *)mr);
     }
+    ca_flush_io();
+    soft_db_start();
 
     ellFree(&soft_motor_list);
     /* Wait on a (never signalled) event here, rather than suspending the
        thread, so as not to show up in the thread list as "SUSPENDED", which
-       is usually a sign of a fault. */
+       is usually a sign of a fault.  Report links that have not connected
+       after 5 seconds once. */
     wait_forever = epicsEventCreate(epicsEventEmpty);
     if (wait_forever)
+    {
+        epicsEventWaitWithTimeout(wait_forever, 5.0);
+        for (itera = 0, pending = 0; itera < num_soft_links; itera++)
+        {
+            if (soft_links[itera].connected == false)
+            {
+                errlogPrintf("devSoftAux: %s.%s link not connected\n",
+                             soft_links[itera].mr->name, soft_links[itera].field);
+                pending++;
+            }
+        }
+        Debug(1, "devSoftAux::soft_motor_task: %d of %d links not connected\n", pending, num_soft_links);
         epicsEventMustWait(wait_forever);
+    }
 
     return(NULL);
 }
-
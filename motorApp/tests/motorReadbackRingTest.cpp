@@ -0,0 +1,90 @@
+/* motorReadbackRingTest.cpp
+ *
+ * Unit tests of asynMotorReadbackRing: wrap-around and overrun counting.
+ * Producer and consumer run in one thread, so the order of the calls is fixed.
+ */
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "asynMotorReadbackRing.h"
+
+#define NUM_AXES 3
+#define MAX_POINTS 4
+
+/* Fills numPoints rows starting at point firstPoint; axis a of point p reads 10p + a, and its error -(10p + a) */
+static void fillRows(int firstPoint, int numPoints, double *readbacks, double *errors)
+{
+  for (int i=0; i<numPoints; i++) {
+    for (int axis=0; axis<NUM_AXES; axis++) {
+      readbacks[i*NUM_AXES + axis] = 10.*(firstPoint + i) + axis;
+      errors[i*NUM_AXES + axis] = -readbacks[i*NUM_AXES + axis];
+    }
+  }
+}
+
+/* Returns true if the popped rows are points firstPoint onwards with the values from fillRows() */
+static bool checkRows(int firstPoint, size_t numPoints, const double *points, double **readbacks, double **errors)
+{
+  for (size_t i=0; i<numPoints; i++) {
+    double point = firstPoint + (double)i;
+    if (points[i] != point) return false;
+    for (int axis=0; axis<NUM_AXES; axis++) {
+      if (readbacks[axis][i] != 10.*point + axis) return false;
+      if (errors[axis][i] != -(10.*point + axis)) return false;
+    }
+  }
+  return true;
+}
+
+MAIN(motorReadbackRingTest)
+{
+  asynMotorReadbackRing ring(NUM_AXES, MAX_POINTS);
+  double readbacks[8*NUM_AXES], errors[8*NUM_AXES];
+  double points[8], readbackColumns[NUM_AXES][8], errorColumns[NUM_AXES][8];
+  double *readbackPointers[NUM_AXES], *errorPointers[NUM_AXES];
+  size_t num;
+  int axis;
+
+  testPlan(14);
+  for (axis=0; axis<NUM_AXES; axis++) {
+    readbackPointers[axis] = readbackColumns[axis];
+    errorPointers[axis] = errorColumns[axis];
+  }
+  testOk1(ring.capacity() == MAX_POINTS);
+
+  // Points 1-3, pop 1-2, then points 4-6 which wrap past the end of the storage
+  fillRows(1, 3, readbacks, errors);
+  testOk1(ring.push(1, 3, readbacks, errors) == 3);
+  num = ring.pop(2, points, readbackPointers, errorPointers);
+  testOk(num == 2 && checkRows(1, num, points, readbackPointers, errorPointers), "Popped points 1-2");
+  fillRows(4, 3, readbacks, errors);
+  testOk1(ring.push(4, 3, readbacks, errors) == 3);
+  testOk1(ring.used() == 4);
+  testOk1(ring.overruns() == 0);
+
+  // The ring is full: nothing is added and the rows are counted
+  fillRows(7, 2, readbacks, errors);
+  testOk1(ring.push(7, 2, readbacks, errors) == 0);
+  testOk1(ring.overruns() == 2);
+
+  num = ring.pop(8, points, readbackPointers, errorPointers);
+  testOk(num == 4 && checkRows(3, num, points, readbackPointers, errorPointers),
+         "Popped points 3-6 across the wrap");
+  testOk1(ring.used() == 0);
+
+  // A push larger than the ring adds what fits; the overruns accumulate
+  fillRows(10, 5, readbacks, errors);
+  testOk1(ring.push(10, 5, readbacks, errors) == MAX_POINTS);
+  testOk1(ring.overruns() == 3);
+
+  // No following errors reads back as zero
+  ring.pop(8, points, readbackPointers, errorPointers);
+  fillRows(20, 1, readbacks, errors);
+  ring.push(20, 1, readbacks, NULL);
+  num = ring.pop(8, points, readbackPointers, errorPointers);
+  testOk(num == 1 && points[0] == 20. && readbackColumns[2][0] == 202., "Popped point 20");
+  testOk(errorColumns[0][0] == 0. && errorColumns[1][0] == 0. && errorColumns[2][0] == 0.,
+         "Following errors are 0 when none are pushed");
+
+  return testDone();
+}
@@ -0,0 +1,212 @@
+/* motorTrajectoryTest.cpp
+ *
+ * Unit tests of the profile move functions in asynMotorTrajectory.  They need no IOC.
+ */
+#include <math.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "asynMotorTrajectory.h"
+
+static bool near(double value, double expected, double tolerance = 1e-9)
+{
+  return fabs(value - expected) <= tolerance;
+}
+
+/* Calls trajectoryCheckLimits() with the work arrays and inverse times it needs */
+static double checkLimits(int numPoints, const double *times, const double *positions,
+                          double maxVelocity, double maxAcceleration, double accelerationTime,
+                          int *badPoint, int *badLimit)
+{
+  double inverseTimes[16], segmentVelocities[16], accelerations[16];
+
+  for (int k=0; k<numPoints-1; k++) inverseTimes[k] = 1./times[k];
+  return trajectoryCheckLimits(numPoints, times, inverseTimes, positions, maxVelocity, maxAcceleration,
+                               accelerationTime, segmentVelocities, accelerations, badPoint, badLimit);
+}
+
+static void testCheckLimits()
+{
+  double times[] = {1., 1., 1.};
+  double scaled[3];
+  double positions[] = {0., 1., 3., 4.};
+  double step[] = {0., 0., 0., 3.};
+  double ramp[] = {0., 2.};
+  double scale;
+  int badPoint, badLimit;
+
+  testDiag("trajectoryCheckLimits");
+
+  scale = checkLimits(4, times, positions, 2., 1., 0., &badPoint, &badLimit);
+  testOk(scale == 1. && badPoint == 0 && badLimit == TRAJECTORY_LIMIT_NONE,
+         "Within limits: scale %g, bad point %d", scale, badPoint);
+
+  // Segment velocities are 1, 2, 1; the second segment ends at point 3 and starts at point 2
+  scale = checkLimits(4, times, positions, 1.5, 0., 0., &badPoint, &badLimit);
+  testOk(near(scale, 2./1.5), "Velocity time scale %g == 4/3", scale);
+  testOk(badPoint == 2 && badLimit == TRAJECTORY_LIMIT_VELOCITY,
+         "First bad point %d is 2, velocity limit", badPoint);
+
+  // Accelerations are 2(2-1)/2 = 1 at point 2 and -1 at point 3; they scale as the square of the velocity
+  scale = checkLimits(4, times, positions, 0., 0.5, 0., &badPoint, &badLimit);
+  testOk(near(scale, sqrt(2.)), "Acceleration time scale %g == sqrt(2)", scale);
+  testOk(badPoint == 2 && badLimit == TRAJECTORY_LIMIT_ACCELERATION,
+         "First bad point %d is 2, acceleration limit", badPoint);
+
+  // Multiplying the times by the scale satisfies the limits
+  scale = checkLimits(4, times, positions, 1.5, 0.5, 0., &badPoint, &badLimit);
+  for (int k=0; k<3; k++) scaled[k] = times[k] * scale * (1. + 1e-12);
+  scale = checkLimits(4, scaled, positions, 1.5, 0.5, 0., &badPoint, &badLimit);
+  testOk(scale == 1. && badPoint == 0, "Scaled times are within limits: scale %g, bad point %d", scale, badPoint);
+
+  // The ramp from rest to 2 in 0.5 s is an acceleration of 4, which scales as the velocity
+  scale = checkLimits(2, times, ramp, 0., 3., 0.5, &badPoint, &badLimit);
+  testOk(near(scale, 4./3.) && badPoint == 1 && badLimit == TRAJECTORY_LIMIT_ACCELERATION,
+         "Ramp time scale %g == 4/3 at point %d", scale, badPoint);
+
+  // Both limits are first exceeded at point 3; velocity is reported, the scale is the larger one
+  scale = checkLimits(4, times, step, 2., 1., 0., &badPoint, &badLimit);
+  testOk(badPoint == 3 && badLimit == TRAJECTORY_LIMIT_VELOCITY,
+         "Velocity reported for a tie at point %d", badPoint);
+  testOk(near(scale, sqrt(3.)), "Time scale %g == sqrt(3), the larger of 3/2 and sqrt(3)", scale);
+}
+
+static void testVelocities()
+{
+  double times[] = {1., 1., 1.};
+  double cubic[] = {0., 1., 8., 27.};
+  double linearTimes[] = {1., 2.};
+  double linearPositions[] = {0., 1., 5.};
+  double unevenTimes[] = {0.5, 1.5, 1., 2.};
+  double unevenPositions[5];
+  double velocities[5];
+  double t = 0., h, d, a0, a1, previousA1 = 0., maxError = 0.;
+  int k;
+
+  testDiag("trajectoryVelocities");
+
+  // Natural spline through t^3 at t = 0, 1, 2, 3, solved by hand from the tridiagonal system
+  testOk1(trajectoryVelocities(PROFILE_FIT_MODE_CUBIC, 4, times, cubic, velocities) == 0);
+  testOk(near(velocities[0], 0.2) && near(velocities[1], 2.6) &&
+         near(velocities[2], 13.4) && near(velocities[3], 21.8),
+         "Spline velocities of t^3: %g %g %g %g == 0.2 2.6 13.4 21.8",
+         velocities[0], velocities[1], velocities[2], velocities[3]);
+
+  // Linear fit: the time-weighted mean of the adjacent segment velocities 1 and 2
+  trajectoryVelocities(PROFILE_FIT_MODE_LINEAR, 3, linearTimes, linearPositions, velocities);
+  testOk(near(velocities[0], 1.) && near(velocities[1], 4./3.) && near(velocities[2], 2.),
+         "Linear velocities %g %g %g == 1 4/3 2", velocities[0], velocities[1], velocities[2]);
+
+  // A natural spline has continuous acceleration and none at the ends; check with uneven times
+  for (k=0; k<5; k++) {
+    unevenPositions[k] = t*t*t - 2.*t*t;
+    if (k < 4) t += unevenTimes[k];
+  }
+  trajectoryVelocities(PROFILE_FIT_MODE_CUBIC, 5, unevenTimes, unevenPositions, velocities);
+  for (k=0; k<4; k++) {
+    h = unevenTimes[k];
+    d = unevenPositions[k+1] - unevenPositions[k];
+    a0 = (6.*d - 2.*h*(2.*velocities[k] + velocities[k+1])) / (h*h);
+    a1 = (-6.*d + 2.*h*(velocities[k] + 2.*velocities[k+1])) / (h*h);
+    if (k == 0) maxError = fabs(a0);
+    else if (fabs(a0 - previousA1) > maxError) maxError = fabs(a0 - previousA1);
+    previousA1 = a1;
+  }
+  if (fabs(previousA1) > maxError) maxError = fabs(previousA1);
+  testOk(maxError < 1e-9, "Spline acceleration is continuous and 0 at the ends, error %g", maxError);
+}
+
+static void testResample()
+{
+  double times[] = {0.5, 0.5};
+  double uneven[] = {0.5, 0.55};
+  double thirds[] = {0.1, 0.2};
+  double positions[] = {0., 1., 3.};
+  double samples[12], sampleVelocities[12];
+
+  testDiag("trajectoryNumSamples and trajectoryResample");
+
+  testOk1(trajectoryNumSamples(3, times, 0.1) == 11);
+  testOk1(trajectoryNumSamples(3, uneven, 0.1) == 12);
+  testOk(trajectoryNumSamples(3, thirds, 0.1) == 4, "0.1 + 0.2 at 0.1 s is 4 samples, not 5");
+  testOk1(trajectoryNumSamples(1, times, 0.1) == 1);
+  testOk1(trajectoryNumSamples(3, times, 0.) == 0);
+
+  trajectoryResample(PROFILE_FIT_MODE_LINEAR, 3, uneven, positions, NULL, 0.1, 12, samples, sampleVelocities);
+  testOk(near(samples[0], 0.) && near(samples[3], 0.6) && near(samples[11], 3.),
+         "Linear samples %g %g %g == 0 0.6 3", samples[0], samples[3], samples[11]);
+  testOk(near(sampleVelocities[3], 2.) && near(sampleVelocities[6], 2./0.55),
+         "Linear sample velocities %g %g are those of the segments", sampleVelocities[3], sampleVelocities[6]);
+}
+
+static void testSegmentExtremes()
+{
+  double minPosition, maxPosition, maxVelocity, maxAcceleration;
+
+  testDiag("trajectorySegmentExtremes");
+
+  // t^3 - 3t^2 from 0 to 3: velocity 3t^2 - 6t, acceleration 6t - 6
+  trajectorySegmentExtremes(3., 0., 0., 0., 9., &minPosition, &maxPosition, &maxVelocity, &maxAcceleration);
+  testOk(near(minPosition, -4.) && near(maxPosition, 0.),
+         "Positions %g to %g == -4 to 0, the minimum is between the ends", minPosition, maxPosition);
+  testOk(near(maxVelocity, 9.) && near(maxAcceleration, 12.),
+         "Peak velocity %g == 9, acceleration %g == 12", maxVelocity, maxAcceleration);
+
+  // -t^3 + 3t from 0 to 2: the maximum position 2 and the velocity extreme -9 are inside
+  trajectorySegmentExtremes(2., 0., 3., -2., -9., &minPosition, &maxPosition, &maxVelocity, &maxAcceleration);
+  testOk(near(minPosition, -2.) && near(maxPosition, 2.) && near(maxVelocity, 9.) && near(maxAcceleration, 12.),
+         "Positions %g to %g, velocity %g, acceleration %g == -2 to 2, 9, 12",
+         minPosition, maxPosition, maxVelocity, maxAcceleration);
+}
+
+static void testPulses()
+{
+  double times[] = {1., 2., 1.};
+  double positions[] = {0., 10., 20., 40.};
+  double lineTimes[] = {1., 1., 1.};
+  double line[] = {0., 1., 2., 3.};
+  double lineVelocities[] = {1., 1., 1., 1.};
+  double pulseTimes[4], pulsePositions[4], period;
+
+  testDiag("trajectoryPulseTimes and trajectoryInterpolate");
+
+  // Pulses from point 2 (t = 1) to point 4 (t = 4)
+  period = trajectoryPulseTimes(4, times, 2, 4, 4, pulseTimes);
+  testOk(near(period, 1.) && near(pulseTimes[0], 1.) && near(pulseTimes[3], 4.),
+         "Period %g == 1, pulses from %g == 1 to %g == 4", period, pulseTimes[0], pulseTimes[3]);
+  trajectoryInterpolate(PROFILE_FIT_MODE_LINEAR, 4, times, positions, NULL, 4, pulseTimes, pulsePositions);
+  testOk(near(pulsePositions[0], 10.) && near(pulsePositions[1], 15.) &&
+         near(pulsePositions[2], 20.) && near(pulsePositions[3], 40.),
+         "Linear pulse positions %g %g %g %g == 10 15 20 40",
+         pulsePositions[0], pulsePositions[1], pulsePositions[2], pulsePositions[3]);
+
+  period = trajectoryPulseTimes(4, times, 2, 2, 1, pulseTimes);
+  testOk(period == 0. && near(pulseTimes[0], 1.), "One pulse at %g == 1, period %g == 0", pulseTimes[0], period);
+
+  // An end point past the profile is moved to its last point
+  period = trajectoryPulseTimes(4, times, 2, 9, 4, pulseTimes);
+  testOk(near(period, 1.) && near(pulseTimes[3], 4.), "End point 9 of 4: period %g == 1, last pulse %g == 4",
+         period, pulseTimes[3]);
+
+  // A cubic through points on a line with their velocities is that line
+  period = trajectoryPulseTimes(4, lineTimes, 1, 4, 4, pulseTimes);
+  pulseTimes[1] = 1.5;
+  pulseTimes[2] = 2.25;
+  trajectoryInterpolate(PROFILE_FIT_MODE_CUBIC, 4, lineTimes, line, lineVelocities, 4, pulseTimes, pulsePositions);
+  testOk(near(pulsePositions[0], 0.) && near(pulsePositions[1], 1.5) &&
+         near(pulsePositions[2], 2.25) && near(pulsePositions[3], 3.),
+         "Cubic pulse positions %g %g %g %g == 0 1.5 2.25 3",
+         pulsePositions[0], pulsePositions[1], pulsePositions[2], pulsePositions[3]);
+}
+
+MAIN(motorTrajectoryTest)
+{
+  testPlan(28);
+  testCheckLimits();
+  testVelocities();
+  testResample();
+  testSegmentExtremes();
+  testPulses();
+  return testDone();
+}